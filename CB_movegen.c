@@ -1,880 +1,474 @@
-// cb_movegen.c: generates a list of legal moves
+// cb_movegen.c: generates a list of legal moves for the game types that checkerboard knows
 // 	getmovelist()
-//	is the only function which cb_movegen.c exports. it takes a Board8x8 as
-//  board with the following representation, color to move, and returns a
-//  list of CBmoves.
+//	takes a Board8x8, the color to move and the game type, and returns a list of moves.
+//	bitboardmovelist()
+//	does the same for a bitboard position (see bitboard.h); getmovelist()
+//  is only a wrapper which converts the board and calls it.
+//	builtinmovelist()
+//	tells if the rules of a game type are known here.
+//  the moves are produced as compact moves (see Cmove in bitboard.h); use
+//  cmovetocbmove() where a full CBmove is needed.
 
 /* INCLUDES */
 #include <memory.h>
 #include <windows.h>
 #include "standardheader.h"
 #include "cb_interface.h"
+#include "bitboard.h"
+#include "lsb.h"
 #include "CB_movegen.h"
 
+/* the rules in which the game types differ. */
+struct movegenrules {
+	int flyingkings;		/* kings move and capture over any distance. */
+	int menbackward;		/* men also capture backwards. */
+	int mencapturekings;	/* men may capture kings. */
+	int crowncontinue;		/* a man crowned during a capture goes on capturing as a king. */
+	int priority;			/* which of the captures must be chosen, see capturepriority(). */
+};
+
+#define PRIORITY_NONE 0			/* any capture. */
+#define PRIORITY_MOST 1			/* the most pieces. */
+#define PRIORITY_MOSTKINGS 2	/* the most pieces, then the most kings. */
+#define PRIORITY_ITALIAN 3		/* the most pieces, with a king, the most kings, the kings first. */
+#define PRIORITY_KING 4			/* with a king if a king can capture. */
+
+static const movegenrules englishrules = {0, 0, 1, 0, PRIORITY_NONE};
+static const movegenrules italianrules = {0, 0, 0, 0, PRIORITY_ITALIAN};
+static const movegenrules spanishrules = {1, 0, 1, 0, PRIORITY_MOSTKINGS};
+static const movegenrules russianrules = {1, 1, 1, 1, PRIORITY_NONE};
+static const movegenrules brazilianrules = {1, 1, 1, 0, PRIORITY_MOST};
+static const movegenrules czechrules = {1, 0, 1, 0, PRIORITY_KING};
+
 /* exported functions */
-int getmovelist(int color, CBmove movelist[MAXMOVES], Board8x8 board, int *isjump);
+int getmovelist(int color, Cmove movelist[MAXMOVES], Board8x8 board, int *isjump, int gametype);
+int bitboardmovelist(int color, Cmove movelist[MAXMOVES], pos *p, int *isjump, int gametype);
+int builtinmovelist(int gametype);
 
 /* internal functions */
-static int makemovelist(int color, CBmove movelist[MAXMOVES], int b[12][12], int *isjump);
-static void board8toboard12(Board8x8 board, int board12[12][12]);
-static void whitecapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d);
-static void blackcapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d);
-static void whitekingcapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d);
-static void blackkingcapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d);
+static const movegenrules *getrules(int gametype);
+static void addcaptures(pos *p, const movegenrules *rules, Cmove movelist[MAXMOVES], int *n, Cmove *m, uint32_t from,
+						uint32_t empty, uint32_t victims, int king, int firstdir, int lastdir, uint32_t promotion);
+static int filtercaptures(Cmove movelist[MAXMOVES], int n, const movegenrules *rules);
+static int capturepriority(Cmove movelist[MAXMOVES], int n, int priority);
+static int removeduplicates(Cmove movelist[MAXMOVES], int n);
+
+/*
+	the bitboard squares are numbered as in bitboard.c:
+
+		  CB_WHITE
+	   28  29  30  31
+	 24  25  26  27
+	   20  21  22  23
+	 16  17  18  19
+	   12  13  14  15
+	  8   9  10  11
+	    4   5   6   7
+	  0   1   2   3
+	      CB_BLACK
+
+	bit i is board8[2 * (i % 4) + ((i / 4) & 1)][i / 4]. black men move up, white men move down,
+	in every game type.
+*/
+#define EVENROWS 0x0F0F0F0F
+#define ODDROWS 0xF0F0F0F0
+#define LEFTEDGE 0x01010101		/* x == 0 */
+#define RIGHTEDGE 0x80808080	/* x == 7 */
+#define BLACKPROMOTION 0xF0000000
+#define WHITEPROMOTION 0x0000000F
+
+/* directions for step(): black men use UPLEFT..UPRIGHT, white men DOWNLEFT..DOWNRIGHT, kings all four. */
+#define UPLEFT 0
+#define UPRIGHT 1
+#define DOWNLEFT 2
+#define DOWNRIGHT 3
+
+static inline uint32_t step(uint32_t x, int dir)
+{
+	// moves every square in x one step diagonally in direction dir; squares which would leave the board vanish
+	switch (dir) {
+	case UPLEFT:
+		return(((x & EVENROWS & ~LEFTEDGE) << 3) | ((x & ODDROWS) << 4));
 
-static int n;
+	case UPRIGHT:
+		return(((x & EVENROWS) << 4) | ((x & ODDROWS & ~RIGHTEDGE) << 5));
 
-static inline int cbcolor_to_getmovelistcolor(int cbcolor)
-{
-	if (cbcolor == CB_BLACK)
-		return(1);
-	else
-		return(-1);
+	case DOWNLEFT:
+		return(((x & EVENROWS & ~LEFTEDGE) >> 5) | ((x & ODDROWS) >> 4));
+
+	default:
+		return(((x & EVENROWS) >> 4) | ((x & ODDROWS & ~RIGHTEDGE) >> 3));
+	}
 }
 
-int getmovelist(int color, CBmove m[MAXMOVES], Board8x8 b, int *isjump)
+static inline uint32_t jump(uint32_t square, int dir, int flying, uint32_t victims, uint32_t empty, uint32_t *landings)
 {
-	int i, j;
-	int n;
-	int board12[12][12];
-
-	board8toboard12(b, board12);
-	assert(color == CB_BLACK || color == CB_WHITE);
-	n = makemovelist(cbcolor_to_getmovelistcolor(color), m, board12, isjump);
-
-	// now: do something to the coordinates, so that the moves are in a 8x8-format
-	for (i = 0; i < n; i++) {
-		m[i].from.x -= 2;
-		m[i].to.x -= 2;
-		m[i].from.y -= 2;
-		m[i].to.y -= 2;
-		for (j = 0; j < 11; j++) {
-			m[i].path[j].x -= 2;
-			m[i].path[j].y -= 2;
-			m[i].del[j].x -= 2;
-			m[i].del[j].y -= 2;
-		}
+	// returns the piece that the piece on square captures in direction dir, or 0 if there is none.
+	// *landings is set to the empty squares behind it where the piece can land; a short piece has
+	// only the first one, a flying king all of them up to the next piece or the edge.
+	uint32_t over, to;
+
+	over = step(square, dir);
+	if (flying) {
+		while (over & empty)
+			over = step(over, dir);
 	}
+	over &= victims;
+	if (!over)
+		return(0);
+	to = step(over, dir) & empty;
+	*landings = to;
+	if (flying) {
+		for (to = step(to, dir) & empty; to; to = step(to, dir) & empty)
+			*landings |= to;
+	}
+	return(*landings ? over : 0);
+}
 
-	// and set the pieces to CB-format
-	for (i = 0; i < n; i++) {
-		switch (m[i].oldpiece) {
-		case -2:
-			m[i].oldpiece = (CB_WHITE | CB_KING);
-			break;
-
-		case -1:
-			m[i].oldpiece = (CB_WHITE | CB_MAN);
-			break;
-
-		case 1:
-			m[i].oldpiece = (CB_BLACK | CB_MAN);
-			break;
-
-		case 2:
-			m[i].oldpiece = (CB_BLACK | CB_KING);
-			break;
-		}
+static inline void addmove(Cmove *m, uint32_t from, uint32_t to, int oldpiece, int newpiece)
+{
+	m->path = LSB(from) | (LSB(to) << 5);
+	m->captures = 0;
+	m->kings = 0;
+	cmovesetpieces(*m, oldpiece, newpiece);
+}
 
-		switch (m[i].newpiece) {
-		case -2:
-			m[i].newpiece = (CB_WHITE | CB_KING);
-			break;
+static inline void addcapture(const movegenrules *rules, Cmove movelist[MAXMOVES], int *n, Cmove *m, int landings, uint32_t to,
+							  int king, uint32_t promotion)
+{
+	// appends the capture in *m, which ends with its landings'th landing on to, to movelist.
+	// a full movelist is first cut down to the captures that the rules allow so far, so
+	// that only allowed captures can be lost.
+	int oldpiece;
+
+	if (*n >= MAXMOVES) {
+		*n = filtercaptures(movelist, *n, rules);
+		if (*n >= MAXMOVES)
+			return;
+	}
+	oldpiece = cmoveoldpiece(*m);
+	movelist[*n] = *m;
+	cmovesetsquare(movelist[*n], landings, LSB(to));
+	movelist[*n].path &= ~(CMOVE_SQUAREBITS & (CMOVE_SQUAREBITS << (5 * (landings + 1))));
+	cmovesetpieces(movelist[*n], oldpiece, (king || (to & promotion)) ? (oldpiece | CB_KING) : oldpiece);
+	(*n)++;
+}
 
-		case -1:
-			m[i].newpiece = (CB_WHITE | CB_MAN);
-			break;
+int builtinmovelist(int gametype)
+{
+	return(getrules(gametype) != NULL);
+}
 
-		case 1:
-			m[i].newpiece = (CB_BLACK | CB_MAN);
-			break;
+static const movegenrules *getrules(int gametype)
+{
+	switch (gametype) {
+	case GT_ENGLISH:
+		return(&englishrules);
 
-		case 2:
-			m[i].newpiece = (CB_BLACK | CB_KING);
-			break;
-		}
+	case GT_ITALIAN:
+		return(&italianrules);
 
-		for (j = 0; j < m[i].jumps; j++) {
-			switch (m[i].delpiece[j]) {
-			case -2:
-				m[i].delpiece[j] = (CB_WHITE | CB_KING);
-				break;
+	case GT_SPANISH:
+		return(&spanishrules);
 
-			case -1:
-				m[i].delpiece[j] = (CB_WHITE | CB_MAN);
-				break;
+	case GT_RUSSIAN:
+		return(&russianrules);
 
-			case 1:
-				m[i].delpiece[j] = (CB_BLACK | CB_MAN);
-				break;
+	case GT_BRAZILIAN:
+		return(&brazilianrules);
 
-			case 2:
-				m[i].delpiece[j] = (CB_BLACK | CB_KING);
-				break;
-			}
-		}
+	case GT_CZECH:
+		return(&czechrules);
 	}
-
-	return n;
+	return(NULL);
 }
 
-void board8toboard12(Board8x8 board8, int board12[12][12])
+int getmovelist(int color, Cmove m[MAXMOVES], Board8x8 b, int *isjump, int gametype)
 {
-	// checkerboard uses a 8x8 board representation, the move generator a 12x12
-	// this routine converts a 8x8 to a 12x12 board
-	int i, j;
-	for (i = 0; i <= 11; i++) {
-		for (j = 0; j <= 11; j++)
-			board12[i][j] = 10;
-	}
-
-	for (i = 2; i <= 9; i++) {
-		for (j = 2; j <= 9; j++)
-			board12[i][j] = 0;
-	}
+	pos p;
 
-	for (i = 0; i <= 7; i++) {
-		for (j = 0; j <= 7; j++) {
-			if (board8[i][j] == (CB_BLACK | CB_MAN))
-				board12[i + 2][j + 2] = 1;
-			if (board8[i][j] == (CB_BLACK | CB_KING))
-				board12[i + 2][j + 2] = 2;
-			if (board8[i][j] == (CB_WHITE | CB_MAN))
-				board12[i + 2][j + 2] = -1;
-			if (board8[i][j] == (CB_WHITE | CB_KING))
-				board12[i + 2][j + 2] = -2;
-		}
-	}
+	boardtobitboard(b, &p);
+	return(bitboardmovelist(color, m, &p, isjump, gametype));
 }
 
-int makemovelist(int color, CBmove movelist[MAXMOVES], int board[12][12], int *isjump)
+int bitboardmovelist(int color, Cmove movelist[MAXMOVES], pos *p, int *isjump, int gametype)
 {
-	// produces a movelist for color to move on board
-	coor wk[12], bk[12], ws[12], bs[12];
-	int nwk = 0, nbk = 0, nws = 0, nbs = 0;
-	int i, j;
-	int x, y;
-	CBmove m;
-	*isjump = 0;
+	// produces a movelist for color to move on p under the rules of gametype. captures are
+	// compulsory, so if there are any, only the captures that the rules allow are returned
+	// and *isjump is set.
+	int n, dir, firstdir, lastdir;
+	uint32_t men, kings, victims, promotion, empty, pieces, from, to;
+	const movegenrules *rules;
+	Cmove m;
 
-	for (i = 0; i < MAXMOVES; i++)
-		movelist[i].jumps = 0;
+	assert(color == CB_BLACK || color == CB_WHITE);
+	rules = getrules(gametype);
+	assert(rules != NULL);
+	if (color == CB_BLACK) {
+		men = p->bm;
+		kings = p->bk;
+		victims = p->wm | p->wk;
+		promotion = BLACKPROMOTION;
+		firstdir = UPLEFT;
+		lastdir = UPRIGHT;
+	}
+	else {
+		men = p->wm;
+		kings = p->wk;
+		victims = p->bm | p->bk;
+		promotion = WHITEPROMOTION;
+		firstdir = DOWNLEFT;
+		lastdir = DOWNRIGHT;
+	}
+	empty = ~(p->bm | p->bk | p->wm | p->wk);
 	n = 0;
+	*isjump = 0;
 
-	// initialize list of stones
-	for (j = 2; j <= 8; j += 2) {
-		for (i = 2; i <= 8; i += 2) {
-			if (board[i][j] == 0)
-				continue;
-			if (board[i][j] == 1) {
-				ws[nws].x = i;
-				ws[nws].y = j;
-				nws++;
-				continue;
-			}
-
-			if (board[i][j] == 2) {
-				wk[nwk].x = i;
-				wk[nwk].y = j;
-				nwk++;
-				continue;
-			}
-
-			if (board[i][j] == -1) {
-				bs[nbs].x = i;
-				bs[nbs].y = j;
-				nbs++;
-				continue;
-			}
+	/* captures, first with kings and then with men. the moving piece leaves its square,
+	 * so it counts as empty for the rest of the capture.
+	 */
+	for (pieces = kings; pieces; pieces &= pieces - 1) {
+		from = pieces & (0 - pieces);
+		m.path = LSB(from);
+		m.captures = m.kings = 0;
+		cmovesetpieces(m, color | CB_KING, color | CB_KING);
+		addcaptures(p, rules, movelist, &n, &m, from, empty | from, victims, 1, firstdir, lastdir, promotion);
+	}
+	for (pieces = men; pieces; pieces &= pieces - 1) {
+		from = pieces & (0 - pieces);
+		m.path = LSB(from);
+		m.captures = m.kings = 0;
+		cmovesetpieces(m, color | CB_MAN, color | CB_MAN);
+		if (rules->menbackward)
+			addcaptures(p, rules, movelist, &n, &m, from, empty | from, victims, 0, UPLEFT, DOWNRIGHT, promotion);
+		else
+			addcaptures(p, rules, movelist, &n, &m, from, empty | from, victims, 0, firstdir, lastdir, promotion);
+	}
+	if (n > 0) {
+		*isjump = 1;
+		return(filtercaptures(movelist, n, rules));
+	}
 
-			if (board[i][j] == -2) {
-				bk[nbk].x = i;
-				bk[nbk].y = j;
-				nbk++;
-				continue;
+	/* normal moves */
+	for (pieces = kings; pieces; pieces &= pieces - 1) {
+		from = pieces & (0 - pieces);
+		for (dir = UPLEFT; dir <= DOWNRIGHT; dir++) {
+			for (to = step(from, dir) & empty; to && n < MAXMOVES; to = step(to, dir) & empty) {
+				addmove(&movelist[n++], from, to, color | CB_KING, color | CB_KING);
+				if (!rules->flyingkings)
+					break;
 			}
 		}
 	}
-
-	for (j = 3; j <= 9; j += 2) {
-		for (i = 3; i <= 9; i += 2) {
-			if (board[i][j] == 0)
+	for (pieces = men; pieces; pieces &= pieces - 1) {
+		from = pieces & (0 - pieces);
+		for (dir = firstdir; dir <= lastdir; dir++) {
+			to = step(from, dir) & empty;
+			if (!to || n >= MAXMOVES)
 				continue;
-			if (board[i][j] == 1) {
-				ws[nws].x = i;
-				ws[nws].y = j;
-				nws++;
-				continue;
-			}
-
-			if (board[i][j] == 2) {
-				wk[nwk].x = i;
-				wk[nwk].y = j;
-				nwk++;
-				continue;
-			}
-
-			if (board[i][j] == -1) {
-				bs[nbs].x = i;
-				bs[nbs].y = j;
-				nbs++;
-				continue;
-			}
-
-			if (board[i][j] == -2) {
-				bk[nbk].x = i;
-				bk[nbk].y = j;
-				nbk++;
-				continue;
-			}
+			addmove(&movelist[n++], from, to, color | CB_MAN, (to & promotion) ? (color | CB_KING) : (color | CB_MAN));
 		}
 	}
 
-	if (color == CB_WHITE) {
-
-		/* search for captures with white kings*/
-		if (nwk > 0) {
-			for (i = 0; i < nwk; i++) {
-				x = wk[i].x;
-				y = wk[i].y;
-				if
-				(
-					(board[x + 1][y + 1] < 0 && board[x + 2][y + 2] == 0) ||
-					(board[x - 1][y + 1] < 0 && board[x - 2][y + 2] == 0) ||
-					(board[x + 1][y - 1] < 0 && board[x + 2][y - 2] == 0) ||
-					(board[x - 1][y - 1] < 0 && board[x - 2][y - 2] == 0)
-				) {
-					m.from.x = x;
-					m.from.y = y;
-					m.path[0].x = x;
-					m.path[0].y = y;
-					whitekingcapture(board, movelist, m, x, y, 0);
-				}
-			}
-		}
+	return(n);
+}
 
-		/* search for captures with white stones */
-		if (nws > 0) {
-			for (i = 0; i < nws; i++) {
-				x = ws[i].x;
-				y = ws[i].y;
-				if
-				(
-					(board[x + 1][y + 1] < 0 && board[x + 2][y + 2] == 0) ||
-					(board[x - 1][y + 1] < 0 && board[x - 2][y + 2] == 0)
-				) {
-					m.from.x = x;
-					m.from.y = y;
-					m.path[0].x = x;
-					m.path[0].y = y;
-					whitecapture(board, movelist, m, x, y, 0);
-				}
+static void addcaptures(pos *p, const movegenrules *rules, Cmove movelist[MAXMOVES], int *n, Cmove *m, uint32_t from,
+						uint32_t empty, uint32_t victims, int king, int firstdir, int lastdir, uint32_t promotion)
+{
+	// appends every capture of the piece on from, whose move has been started in *m, to
+	// movelist. the capture tree is walked depth first with an explicit stack; *m holds
+	// the sequence so far and is only copied when a capture is complete.
+	// a man jumps in the directions firstdir..lastdir, a king in all four; promotion is
+	// the set of squares on which a man's capture ends as a king.
+	// captured pieces stay on the board until the move is over: they cannot be jumped
+	// twice and block the way.
+	struct {
+		uint32_t square;	/* where the piece stands at this depth. */
+		uint32_t over;		/* piece captured by the jump being followed, 0 if none. */
+		uint32_t landings;	/* landing squares of that jump which are still to be tried. */
+		int dir;			/* next direction to try. */
+		int king;			/* nonzero if the piece is a king at this depth. */
+		int found;			/* nonzero if a jump from here was found. */
+	} stack[CMOVE_MAXLANDINGS + 1];
+	int d, dir, flying, nextking;
+	uint32_t over, to, landings, more, x, kings, unused;
+
+	kings = p->bk | p->wk;
+	d = 0;
+	stack[0].square = from;
+	stack[0].over = 0;
+	stack[0].landings = 0;
+	stack[0].dir = king ? UPLEFT : firstdir;
+	stack[0].king = king;
+	stack[0].found = 0;
+	while (d >= 0) {
+		if (!stack[d].landings) {
+
+			/* take back the last jump from here, then look for the next one. */
+			if (stack[d].over) {
+				m->captures &= ~stack[d].over;
+				m->kings &= ~stack[d].over;
+				victims |= stack[d].over;
+				stack[d].over = 0;
 			}
-		}
-
-		/* if there are capture moves return. */
-		if (n > 0) {
-			*isjump = 1;
-			return(n);
-		}
-
-		/* search for moves with white kings */
-		if (nwk > 0) {
-			for (i = 0; i < nwk; i++) {
-				x = wk[i].x;
-				y = wk[i].y;
-				if (board[x + 1][y + 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x + 1;
-					movelist[n].to.y = y + 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x + 1;
-					movelist[n].path[1].y = y + 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = 2;
-					movelist[n].oldpiece = 2;
-					n++;
-				}
+			if (stack[d].dir > (stack[d].king ? DOWNRIGHT : lastdir)) {
 
-				if (board[x + 1][y - 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x + 1;
-					movelist[n].to.y = y - 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x + 1;
-					movelist[n].path[1].y = y - 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = 2;
-					movelist[n].oldpiece = 2;
-					n++;
-				}
-
-				if (board[x - 1][y + 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x - 1;
-					movelist[n].to.y = y + 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x - 1;
-					movelist[n].path[1].y = y + 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = 2;
-					movelist[n].oldpiece = 2;
-					n++;
-				}
-
-				if (board[x - 1][y - 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x - 1;
-					movelist[n].to.y = y - 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x - 1;
-					movelist[n].path[1].y = y - 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = 2;
-					movelist[n].oldpiece = 2;
-					n++;
-				}
+				/* all jumps from here are done: if there was none, the capture is complete. */
+				if (!stack[d].found && d > 0)
+					addcapture(rules, movelist, n, m, d, stack[d].square, stack[d].king, promotion);
+				d--;
+				continue;
 			}
-		}
 
-		/* search for moves with white stones */
-		if (nws > 0) {
-			for (i = nws - 1; i >= 0; i--) {
-				x = ws[i].x;
-				y = ws[i].y;
-				if (board[x + 1][y + 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x + 1;
-					movelist[n].to.y = y + 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x + 1;
-					movelist[n].path[1].y = y + 1;
-					movelist[n].del[0].x = -1;
-					if (y == 8) {
-						movelist[n].newpiece = 2;
-					}
-					else
-						movelist[n].newpiece = 1;
-					movelist[n].oldpiece = 1;
-					n++;
-				}
+			dir = stack[d].dir++;
+			flying = stack[d].king && rules->flyingkings;
+			over = jump(stack[d].square, dir, flying,
+						(stack[d].king || rules->mencapturekings) ? victims : (victims & ~kings), empty, &landings);
+			if (!over)
+				continue;
 
-				if (board[x - 1][y + 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x - 1;
-					movelist[n].to.y = y + 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x - 1;
-					movelist[n].path[1].y = y + 1;
-					movelist[n].del[0].x = -1;
-					if (y == 8) {
-						movelist[n].newpiece = 2;
+			stack[d].found = 1;
+			stack[d].over = over;
+			m->captures |= over;
+			m->kings |= over & kings;
+			victims &= ~over;
+			if (flying) {
+
+				/* a flying king must land where it can go on capturing, if there is such a square.
+				 * if not, every landing square ends the capture.
+				 */
+				more = 0;
+				for (x = landings; x; x &= x - 1) {
+					to = x & (0 - x);
+					for (dir = UPLEFT; dir <= DOWNRIGHT; dir++) {
+						if (jump(to, dir, 1, victims, empty, &unused)) {
+							more |= x & (0 - x);
+							break;
+						}
 					}
-					else
-						movelist[n].newpiece = 1;
-					movelist[n].oldpiece = 1;
-					n++;
 				}
-			}
-		}
-
-		if (n > 0)
-			return(n);
-	}
-	else {
-
-		/* search for captures with black kings*/
-		n = 0;
-		if (nbk > 0) {
-			for (i = 0; i < nbk; i++) {
-				x = bk[i].x;
-				y = bk[i].y;
-				if
-				(
-					((board[x + 1][y + 1] > 0) && (board[x + 1][y + 1] < 3) && (board[x + 2][y + 2] == 0)) ||
-					((board[x - 1][y + 1] > 0) && (board[x - 1][y + 1] < 3) && (board[x - 2][y + 2] == 0)) ||
-					((board[x + 1][y - 1] > 0) && (board[x + 1][y - 1] < 3) && (board[x + 2][y - 2] == 0)) ||
-					((board[x - 1][y - 1] > 0) && (board[x - 1][y - 1] < 3) && (board[x - 2][y - 2] == 0))
-				) {
-					m.from.x = x;
-					m.from.y = y;
-					m.path[0].x = x;
-					m.path[0].y = y;
-					blackkingcapture(board, movelist, m, x, y, 0);
+				if (!more || d + 1 == CMOVE_MAXLANDINGS) {
+					for (x = landings; x; x &= x - 1)
+						addcapture(rules, movelist, n, m, d + 1, x & (0 - x), 1, promotion);
+					continue;
 				}
+				landings = more;
 			}
+			stack[d].landings = landings;
 		}
 
-		/* search for captures with black stones */
-		if (nbs > 0) {
-			for (i = nbs - 1; i >= 0; i--) {
-				x = bs[i].x;
-				y = bs[i].y;
-				if
-				(
-					(board[x + 1][y - 1] > 0 && board[x + 2][y - 2] == 0) ||
-					(board[x - 1][y - 1] > 0 && board[x - 2][y - 2] == 0)
-				) {
-					m.from.x = x;
-					m.from.y = y;
-					m.path[0].x = x;
-					m.path[0].y = y;
-					blackcapture(board, movelist, m, x, y, 0);
-				}
-			}
-		}
-
-		/* search for moves with black kings */
-		if (n > 0) {
-			*isjump = 1;
-			return(n);
-		}
-
-		if (nbk > 0) {
-			for (i = 0; i < nbk; i++) {
-				x = bk[i].x;
-				y = bk[i].y;
-				if (board[x + 1][y + 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x + 1;
-					movelist[n].to.y = y + 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x + 1;
-					movelist[n].path[1].y = y + 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = -2;
-					movelist[n].oldpiece = -2;
-					n++;
-				}
-
-				if (board[x + 1][y - 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x + 1;
-					movelist[n].to.y = y - 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x + 1;
-					movelist[n].path[1].y = y - 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = -2;
-					movelist[n].oldpiece = -2;
-					n++;
-				}
+		to = stack[d].landings & (0 - stack[d].landings);
+		stack[d].landings ^= to;
+		cmovesetsquare(*m, d + 1, LSB(to));
+		nextking = stack[d].king || (rules->crowncontinue && (to & promotion));
+		if (d + 1 == CMOVE_MAXLANDINGS) {
 
-				if (board[x - 1][y + 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x - 1;
-					movelist[n].to.y = y + 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x - 1;
-					movelist[n].path[1].y = y + 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = -2;
-					movelist[n].oldpiece = -2;
-					n++;
-				}
-
-				if (board[x - 1][y - 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x - 1;
-					movelist[n].to.y = y - 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x - 1;
-					movelist[n].path[1].y = y - 1;
-					movelist[n].del[0].x = -1;
-					movelist[n].newpiece = -2;
-					movelist[n].oldpiece = -2;
-					n++;
-				}
-			}
-		}
-
-		/* search for moves with black stones */
-		if (nbs > 0) {
-			for (i = 0; i < nbs; i++) {
-				x = bs[i].x;
-				y = bs[i].y;
-				if (board[x + 1][y - 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x + 1;
-					movelist[n].to.y = y - 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x + 1;
-					movelist[n].path[1].y = y - 1;
-					movelist[n].del[0].x = -1;
-					if (y == 3) {
-						movelist[n].newpiece = -2;
-					}
-					else
-						movelist[n].newpiece = -1;
-					movelist[n].oldpiece = -1;
-					n++;
-				}
-
-				if (board[x - 1][y - 1] == 0) {
-					movelist[n].jumps = 0;
-					movelist[n].from.x = x;
-					movelist[n].from.y = y;
-					movelist[n].to.x = x - 1;
-					movelist[n].to.y = y - 1;
-					movelist[n].path[0].x = x;
-					movelist[n].path[0].y = y;
-					movelist[n].path[1].x = x - 1;
-					movelist[n].path[1].y = y - 1;
-					movelist[n].del[0].x = -1;
-					if (y == 3) {
-						movelist[n].newpiece = -2;
-					}
-					else
-						movelist[n].newpiece = -1;
-					movelist[n].oldpiece = -1;
-					n++;
-				}
-			}
+			/* no room for more landing squares in a Cmove. */
+			addcapture(rules, movelist, n, m, d + 1, to, nextking, promotion);
+			continue;
 		}
+		d++;
+		stack[d].square = to;
+		stack[d].over = 0;
+		stack[d].landings = 0;
+		stack[d].dir = nextking ? UPLEFT : firstdir;
+		stack[d].king = nextking;
+		stack[d].found = 0;
 	}
+}
 
+static int filtercaptures(Cmove movelist[MAXMOVES], int n, const movegenrules *rules)
+{
+	// removes from movelist the captures that the priority rule does not allow, and with
+	// flying kings the duplicates. addcapture() also calls it for the captures found so
+	// far when movelist is full. this does not change the final list: a capture that the
+	// rule drops from a part of the list is also dropped from the whole list, and
+	// duplicates capture the same pieces, so they have the same priority.
+	// returns the number of captures that are left.
+	if (rules->priority != PRIORITY_NONE)
+		n = capturepriority(movelist, n, rules->priority);
+	if (rules->flyingkings)
+		n = removeduplicates(movelist, n);
 	return(n);
 }
 
-void whitecapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d)
+static uint32_t capturekey(Cmove &m, int priority)
 {
-	int b[12][12];
-	CBmove mm;
-	int end = 1;
-
-	mm = m;
-	if (y < 8) {
-		if (board[x + 1][y + 1] < 0 && board[x + 2][y + 2] == 0) {
-			memcpy(b, board, 144 * sizeof(int));
-			b[x][y] = 0;
-			b[x + 1][y + 1] = 0;
-			b[x + 2][y + 2] = 1;
-			mm.to.x = x + 2;
-			mm.to.y = y + 2;
-			mm.path[d + 1].x = x + 2;
-			mm.path[d + 1].y = y + 2;
-			mm.del[d].x = x + 1;
-			mm.del[d].y = y + 1;
-			mm.delpiece[d] = board[x + 1][y + 1];
-			mm.del[d + 1].x = -1;
-			if (y == 7)
-				mm.newpiece = 2;
-			else
-				mm.newpiece = 1;
-
-			whitecapture(b, movelist, mm, x + 2, y + 2, d + 1);
-			end = 0;
-		}
-
-		mm = m;
-		if (board[x - 1][y + 1] < 0 && board[x - 2][y + 2] == 0) {
-			memcpy(b, board, 144 * sizeof(int));
-			b[x][y] = 0;
-			b[x - 1][y + 1] = 0;
-			b[x - 2][y + 2] = 1;
-			mm.to.x = x - 2;
-			mm.to.y = y + 2;
-			mm.path[d + 1].x = x - 2;
-			mm.path[d + 1].y = y + 2;
-			mm.del[d].x = x - 1;
-			mm.del[d].y = y + 1;
-			mm.del[d + 1].x = -1;
-			mm.delpiece[d] = board[x - 1][y + 1];
-			if (y == 7)
-				mm.newpiece = 2;
-			else
-				mm.newpiece = 1;
-
-			whitecapture(b, movelist, mm, x - 2, y + 2, d + 1);
-			end = 0;
+	// returns a number that is larger for the captures that the priority rule prefers.
+	int i, order;
+	coor a, b, c;
+
+	switch (priority) {
+	case PRIORITY_MOST:
+		return(cmovejumps(m));
+
+	case PRIORITY_MOSTKINGS:
+		return((cmovejumps(m) << 8) | __popcnt(m.kings));
+
+	case PRIORITY_KING:
+		return((cmoveoldpiece(m) & CB_KING) ? 1 : 0);
+
+	default:
+		/* italian kings jump short, so the piece captured by the ith jump lies halfway between
+		 * two landing squares. the earlier the kings are captured, the smaller is order.
+		 */
+		order = 0;
+		for (i = 1; i <= cmovejumps(m) && m.kings; i++) {
+			a = squaretocoor(cmovesquare(m, i - 1));
+			b = squaretocoor(cmovesquare(m, i));
+			c.x = (a.x + b.x) / 2;
+			c.y = (a.y + b.y) / 2;
+			if (m.kings & (1 << coortosquare(c)))
+				order += 1 << i;
 		}
-	}
-
-	if (end) {
-		m.jumps = d;
-		movelist[n] = m;
-		movelist[n].oldpiece = 1;
-		n++;
+		return((cmovejumps(m) << 24) | (((cmoveoldpiece(m) & CB_KING) ? 1 : 0) << 20) | (__popcnt(m.kings) << 16) | (0xFFFF - order));
 	}
 }
 
-void whitekingcapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d)
+static int capturepriority(Cmove movelist[MAXMOVES], int n, int priority)
 {
-	int b[12][12];
-	CBmove mm;
-	int end = 1;
-
-	mm = m;
-	if (board[x + 1][y + 1] < 0 && board[x + 2][y + 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x + 1][y + 1] = 0;
-		b[x + 2][y + 2] = 2;
-		mm.to.x = x + 2;
-		mm.to.y = y + 2;
-		mm.path[d + 1].x = x + 2;
-		mm.path[d + 1].y = y + 2;
-		mm.del[d].x = x + 1;
-		mm.del[d].y = y + 1;
-		mm.del[d + 1].x = -1;
-		mm.delpiece[d] = board[x + 1][y + 1];
-		mm.newpiece = 2;
-
-		whitekingcapture(b, movelist, mm, x + 2, y + 2, d + 1);
-		end = 0;
-	}
-
-	mm = m;
-	if (board[x - 1][y + 1] < 0 && board[x - 2][y + 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x - 1][y + 1] = 0;
-		b[x - 2][y + 2] = 2;
-		mm.to.x = x - 2;
-		mm.to.y = y + 2;
-		mm.path[d + 1].x = x - 2;
-		mm.path[d + 1].y = y + 2;
-		mm.del[d].x = x - 1;
-		mm.del[d].y = y + 1;
-		mm.delpiece[d] = board[x - 1][y + 1];
-		mm.del[d + 1].x = -1;
-		mm.newpiece = 2;
-
-		whitekingcapture(b, movelist, mm, x - 2, y + 2, d + 1);
-		end = 0;
-	}
-
-	if (board[x + 1][y - 1] < 0 && board[x + 2][y - 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x + 1][y - 1] = 0;
-		b[x + 2][y - 2] = 2;
-		mm.to.x = x + 2;
-		mm.to.y = y - 2;
-		mm.path[d + 1].x = x + 2;
-		mm.path[d + 1].y = y - 2;
-		mm.del[d].x = x + 1;
-		mm.del[d].y = y - 1;
-		mm.delpiece[d] = board[x + 1][y - 1];
-		mm.del[d + 1].x = -1;
-		mm.newpiece = 2;
-
-		whitekingcapture(b, movelist, mm, x + 2, y - 2, d + 1);
-		end = 0;
-	}
-
-	mm = m;
-	if (board[x - 1][y - 1] < 0 && board[x - 2][y - 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x - 1][y - 1] = 0;
-		b[x - 2][y - 2] = 2;
-		mm.to.x = x - 2;
-		mm.to.y = y - 2;
-		mm.path[d + 1].x = x - 2;
-		mm.path[d + 1].y = y - 2;
-		mm.del[d].x = x - 1;
-		mm.del[d].y = y - 1;
-		mm.delpiece[d] = board[x - 1][y - 1];
-		mm.del[d + 1].x = -1;
-		mm.newpiece = 2;
-
-		whitekingcapture(b, movelist, mm, x - 2, y - 2, d + 1);
-		end = 0;
+	// removes the captures that the priority rule does not allow from movelist:
+	// PRIORITY_MOST (brazilian): the most pieces must be captured.
+	// PRIORITY_MOSTKINGS (spanish): the most pieces, and of those, the most kings.
+	// PRIORITY_ITALIAN: the most pieces; with a king rather than a man; the most kings;
+	// the kings as early as possible.
+	// PRIORITY_KING (czech): a king must capture if it can.
+	// returns the number of captures that are left.
+	int i, n2;
+	uint32_t key[MAXMOVES], best;
+
+	best = 0;
+	for (i = 0; i < n; i++) {
+		key[i] = capturekey(movelist[i], priority);
+		if (key[i] > best)
+			best = key[i];
 	}
 
-	if (end) {
-		m.jumps = d;
-		movelist[n] = m;
-		movelist[n].oldpiece = 2;
-		n++;
+	n2 = 0;
+	for (i = 0; i < n; i++) {
+		if (key[i] == best)
+			movelist[n2++] = movelist[i];
 	}
+	return(n2);
 }
 
-void blackcapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d)
+static int removeduplicates(Cmove movelist[MAXMOVES], int n)
 {
-	int b[12][12];
-	CBmove mm;
-	int end = 1;
-
-	mm = m;
-	if (y > 3) {
-		if (board[x + 1][y - 1] > 0 && board[x + 2][y - 2] == 0) {
-			memcpy(b, board, 144 * sizeof(int));
-			b[x][y] = 0;
-			b[x + 1][y - 1] = 0;
-			b[x + 2][y - 2] = -1;
-			mm.to.x = x + 2;
-			mm.to.y = y - 2;
-			mm.path[d + 1].x = x + 2;
-			mm.path[d + 1].y = y - 2;
-			mm.del[d].x = x + 1;
-			mm.del[d].y = y - 1;
-			mm.delpiece[d] = board[x + 1][y - 1];
-			mm.del[d + 1].x = -1;
-			if (y == 4)
-				mm.newpiece = -2;
-			else
-				mm.newpiece = -1;
-
-			blackcapture(b, movelist, mm, x + 2, y - 2, d + 1);
-			end = 0;
-		}
+	// with flying kings, as in international draughts, captures of the same pieces from and to the
+	// same squares are one move, however the king went; only the first path of each is kept.
+	// returns the number of captures that are left.
+	int i, j, n2;
 
-		mm = m;
-		if (board[x - 1][y - 1] > 0 && board[x - 2][y - 2] == 0) {
-			memcpy(b, board, 144 * sizeof(int));
-			b[x][y] = 0;
-			b[x - 1][y - 1] = 0;
-			b[x - 2][y - 2] = -1;
-			mm.to.x = x - 2;
-			mm.to.y = y - 2;
-			mm.path[d + 1].x = x - 2;
-			mm.path[d + 1].y = y - 2;
-			mm.del[d].x = x - 1;
-			mm.del[d].y = y - 1;
-			mm.delpiece[d] = board[x - 1][y - 1];
-			mm.del[d + 1].x = -1;
-			if (y == 4)
-				mm.newpiece = -2;
-			else
-				mm.newpiece = -1;
-
-			blackcapture(b, movelist, mm, x - 2, y - 2, d + 1);
-			end = 0;
+	n2 = 0;
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n2; j++) {
+			if (movelist[j].captures == movelist[i].captures && cmovefrom(movelist[j]) == cmovefrom(movelist[i]) &&
+						cmoveto(movelist[j]) == cmoveto(movelist[i]))
+				break;
 		}
+		if (j == n2)
+			movelist[n2++] = movelist[i];
 	}
-
-	if (end) {
-		m.jumps = d;
-		movelist[n] = m;
-		movelist[n].oldpiece = -1;
-		n++;
-	}
-}
-
-void blackkingcapture(int board[12][12], CBmove movelist[MAXMOVES], CBmove m, int x, int y, int d)
-{
-	int b[12][12];
-	CBmove mm;
-	int end = 1;
-
-	mm = m;
-	if (board[x + 1][y + 1] > 0 && board[x + 2][y + 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x + 1][y + 1] = 0;
-		b[x + 2][y + 2] = 2;
-		mm.to.x = x + 2;
-		mm.to.y = y + 2;
-		mm.path[d + 1].x = x + 2;
-		mm.path[d + 1].y = y + 2;
-		mm.del[d].x = x + 1;
-		mm.del[d].y = y + 1;
-		mm.delpiece[d] = board[x + 1][y + 1];
-		mm.del[d + 1].x = -1;
-		mm.newpiece = -2;
-
-		blackkingcapture(b, movelist, mm, x + 2, y + 2, d + 1);
-		end = 0;
-	}
-
-	mm = m;
-	if (board[x - 1][y + 1] > 0 && board[x - 2][y + 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x - 1][y + 1] = 0;
-		b[x - 2][y + 2] = 2;
-		mm.to.x = x - 2;
-		mm.to.y = y + 2;
-		mm.path[d + 1].x = x - 2;
-		mm.path[d + 1].y = y + 2;
-		mm.del[d].x = x - 1;
-		mm.del[d].y = y + 1;
-		mm.delpiece[d] = board[x - 1][y + 1];
-		mm.del[d + 1].x = -1;
-		mm.newpiece = -2;
-
-		blackkingcapture(b, movelist, mm, x - 2, y + 2, d + 1);
-		end = 0;
-	}
-
-	if (board[x + 1][y - 1] > 0 && board[x + 2][y - 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x + 1][y - 1] = 0;
-		b[x + 2][y - 2] = 2;
-		mm.to.x = x + 2;
-		mm.to.y = y - 2;
-		mm.path[d + 1].x = x + 2;
-		mm.path[d + 1].y = y - 2;
-		mm.del[d].x = x + 1;
-		mm.del[d].y = y - 1;
-		mm.delpiece[d] = board[x + 1][y - 1];
-		mm.del[d + 1].x = -1;
-		mm.newpiece = -2;
-
-		blackkingcapture(b, movelist, mm, x + 2, y - 2, d + 1);
-		end = 0;
-	}
-
-	mm = m;
-	if (board[x - 1][y - 1] > 0 && board[x - 2][y - 2] == 0) {
-		memcpy(b, board, 144 * sizeof(int));
-		b[x][y] = 0;
-		b[x - 1][y - 1] = 0;
-		b[x - 2][y - 2] = 2;
-		mm.to.x = x - 2;
-		mm.to.y = y - 2;
-		mm.path[d + 1].x = x - 2;
-		mm.path[d + 1].y = y - 2;
-		mm.del[d].x = x - 1;
-		mm.del[d].y = y - 1;
-		mm.delpiece[d] = board[x - 1][y - 1];
-		mm.del[d + 1].x = -1;
-		mm.newpiece = -2;
-
-		blackkingcapture(b, movelist, mm, x - 2, y - 2, d + 1);
-		end = 0;
-	}
-
-	if (end) {
-		m.jumps = d;
-		movelist[n] = m;
-		movelist[n].oldpiece = -2;
-		n++;
-	}
+	return(n2);
 }
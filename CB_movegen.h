@@ -3,8 +3,12 @@
 #include <windows.h>
 #include "standardheader.h"
 #include "cb_interface.h"
+#include "bitboard.h"
 #include "CB_movegen.h"
 
-#define MAXMOVES 28
+/* flying kings can have many more moves than english kings. */
+#define MAXMOVES 128
 
-int getmovelist(int color, CBmove movelist[MAXMOVES], Board8x8 board, int *isjump);
+int getmovelist(int color, Cmove movelist[MAXMOVES], Board8x8 board, int *isjump, int gametype);
+int bitboardmovelist(int color, Cmove movelist[MAXMOVES], pos *p, int *isjump, int gametype);
+int builtinmovelist(int gametype);
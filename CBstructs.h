@@ -16,11 +16,16 @@ enum EM_START_POSITIONS {
 	START_POS_3MOVE, START_POS_FROM_FILE
 };
 
+/* Is part of the crc of the saved CBoptions. Increment it when the fields change in a way that
+ * sizeof(CBoptions) does not show, so that options saved by an older version are not loaded.
+ */
+#define CBOPTIONS_VERSION 1
+
 struct CBoptions {
 	// holds all options of CB.
 	// the point is that it is much easier to store one struct in the registry
 	// than to save every value separately.
-	unsigned int crc;					/* The crc is calculated on the whole struct using the sizeof(CBoptions) in the crc field. */
+	unsigned int crc;					/* The crc is calculated on the whole struct using sizeof(CBoptions) and CBOPTIONS_VERSION in the crc field. */
 	char userdirectory[256];
 	char matchdirectory[256];
 	char EGTBdirectory[256];
@@ -53,6 +58,7 @@ struct CBoptions {
 	int addoffset;
 	int language;
 	int piecesetindex;
+	bool ponder;				/* engine searches on the opponent's time. */
 };
 
 struct BALLOT_INFO {
@@ -70,7 +76,7 @@ struct RESULT_COUNTS {
 
 /* A game move with associated move text, comments, and analysis text. */
 struct gamebody_entry {
-	CBmove move;						// move
+	Cmove move;							// move
 	char PDN[64];						// PDN of move, e.g. 8-11 or 8x15
 	char comment[COMMENTLENGTH];		// user comment
 	char analysis[COMMENTLENGTH];		// engine analysis comment - separate from above so they can coexist
@@ -59,6 +59,7 @@
 #include "bmp.h"
 #include "coordinates.h"
 #include "bitboard.h"
+#include "lsb.h"
 #include "utility.h"
 #include "fen.h"
 #include "resource.h"
@@ -82,8 +83,8 @@ CBoptions cboptions;
 
 int g_app_instance;					/* 0, 1, 2, ... */
 char g_app_instance_suffix[10];		/* "", "[1]", "[2]", ... */
-DWORD g_SearchThreadId, g_AniThreadId, AutoThreadId;
-HANDLE hSearchThread, hAniThread, hAutoThread;
+DWORD g_SearchThreadId, g_AniThreadId, AutoThreadId, g_PonderThreadId;
+HANDLE hSearchThread, hAniThread, hAutoThread, hPonderThread;
 int enginethreadpriority = THREAD_PRIORITY_NORMAL;	/* default priority setting*/
 int usersetpriority = THREAD_PRIORITY_NORMAL;		/* default priority setting*/
 HICON hIcon;						/* CB icon for the window */
@@ -116,6 +117,11 @@ static int addcomment;
 int handicap;
 int testset_number;
 int playnow;						/* playnow is passed to the checkers engines, it is set to nonzero if the user chooses 'play' */
+int pondernow;						/* passed to the pondering engine as its playnow, set to stop the ponder search */
+int ponderengine;					/* engine that is pondering (1 or 2), 0 if none */
+static Board8x8 ponderboard;		/* position after the pondering engine's move */
+static int pondercolor;
+static char ponder_txt[1024];		/* search info of the ponder search, not displayed */
 bool reset_move_history;			/* send option to engine to reset its list of game moves. */
 int gameindex;						/* game to load/replace from/in a database */
 
@@ -134,6 +140,7 @@ CB_ENGINECOMMAND enginecommand1, enginecommand2;
 
 // multi-version support
 CB_ISLEGAL islegal, islegal1, islegal2;
+CB_GETMOVELIST enginemovelist, enginemovelist1, enginemovelist2;
 CB_GETSTRING enginename1, enginename2;
 CB_GETGAMETYPE CBgametype;			// built in gametype and islegal functions
 
@@ -185,7 +192,7 @@ int reindex = 1;
 int re_search_ok;
 char piecesetname[MAXPIECESET][256];
 int maxpieceset;
-CRITICAL_SECTION ani_criticalsection, engine_criticalsection;
+CRITICAL_SECTION ani_criticalsection, engine_criticalsection, ponder_criticalsection;
 int handletooltiprequest(LPTOOLTIPTEXT TTtext);
 void reset_game(PDNgame &game);
 void forward_to_game_end(void);
@@ -486,6 +493,7 @@ LRESULT CALLBACK WindowFunc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
 	case WM_CREATE:
 		InitializeCriticalSection(&ani_criticalsection);
 		InitializeCriticalSection(&engine_criticalsection);
+		InitializeCriticalSection(&ponder_criticalsection);
 		PostMessage(hwnd, WM_COMMAND, LOADENGINES, 0);
 		break;
 
@@ -1427,6 +1435,18 @@ LRESULT CALLBACK WindowFunc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
 			book_state = atoi(Lstr);
 			break;
 
+		case ENGINEPONDER:
+			if (cboptions.ponder) {
+				cboptions.ponder = false;
+				stop_pondering();
+				CheckMenuItem(hmenu, ENGINEPONDER, MF_UNCHECKED);
+			}
+			else {
+				cboptions.ponder = true;
+				CheckMenuItem(hmenu, ENGINEPONDER, MF_CHECKED);
+			}
+			break;
+
 		case ENGINEEVAL:
 			// static eval of the current positions
 			board8toFEN(cbboard8, str2, cbcolor, cbgame.gametype);
@@ -1635,6 +1655,7 @@ LRESULT CALLBACK WindowFunc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
 		savesettings(&cboptions);
 
 		// unload engines
+		stop_pondering();
 		{
 			BOOL fFreeResult = FreeLibrary(hinstLib1);
 			fFreeResult = FreeLibrary(hinstLib2);
@@ -1901,9 +1922,9 @@ int handle_lbuttondown(int x, int y)
 		// if there is only one move with this piece, then do it!
 		if (islegal != NULL) {
 			legal = 0;
-			if (has_getmovelist || cbgame.gametype == GT_ENGLISH) {
+			if (have_movelist(cbgame.gametype)) {
 
-				/* We can do a better job for English since we have a movelist generator. */
+				/* We can do a better job when we have a movelist generator. */
 				legal = num_matching_moves(cbboard8, cbcolor, clicks, localmove, cbgame.gametype);
 			}
 			else {
@@ -1941,8 +1962,8 @@ int handle_lbuttondown(int x, int y)
 				// if we are in user book mode, add it to user book!
 
 				// a legal move! Add move to the game list.
-				// For English checkers we can fully describe ambiguous captures.
-				if (has_getmovelist || cbgame.gametype == GT_ENGLISH) {
+				// With a movelist we can fully describe ambiguous captures.
+				if (have_movelist(cbgame.gametype)) {
 					char pdn[40];
 					move_to_pdn_english(cbboard8, cbcolor, &localmove, pdn, cbgame.gametype);
 					addmovetogame(localmove, pdn);
@@ -2020,9 +2041,9 @@ int handle_lbuttondown(int x, int y)
 			legal = 0;
 			legalmovenumber = 0;
 			if (islegal != NULL) {
-				if (has_getmovelist || cbgame.gametype == GT_ENGLISH) {
+				if (have_movelist(cbgame.gametype)) {
 
-					/* We can do a better job for English since we have a movelist generator. */
+					/* We can do a better job when we have a movelist generator. */
 					legal = num_matching_moves(cbboard8, cbcolor, clicks, localmove, cbgame.gametype);
 				}
 				else {
@@ -2041,7 +2062,7 @@ int handle_lbuttondown(int x, int y)
 
 				// only one legal move
 				// insert move in the linked list
-				if (has_getmovelist || cbgame.gametype == GT_ENGLISH) {
+				if (have_movelist(cbgame.gametype)) {
 					char pdn[40];
 					move_to_pdn_english(cbboard8, cbcolor, &localmove, pdn, cbgame.gametype);
 					addmovetogame(localmove, pdn);
@@ -2079,9 +2100,9 @@ int handle_lbuttondown(int x, int y)
 		// check move and if ok
 		if (islegal != NULL) {
 			legal = 0;
-			if (has_getmovelist || cbgame.gametype == GT_ENGLISH) {
+			if (have_movelist(cbgame.gametype)) {
 
-				/* We can do a better job for English since we have a movelist generator. */
+				/* We can do a better job when we have a movelist generator. */
 				legal = num_matching_moves(cbboard8, cbcolor, clicks, localmove, cbgame.gametype);
 				if (legal > 1) {
 
@@ -2099,7 +2120,7 @@ int handle_lbuttondown(int x, int y)
 
 				// a legal move!
 				// insert move in the game
-				if (has_getmovelist || cbgame.gametype == GT_ENGLISH) {
+				if (have_movelist(cbgame.gametype)) {
 					char pdn[40];
 					move_to_pdn_english(cbboard8, cbcolor, &localmove, pdn, cbgame.gametype);
 					addmovetogame(localmove, pdn);
@@ -3271,7 +3292,7 @@ DWORD SearchThreadFunc(LPVOID param)
 {
 	int i, nmoves;
 	Board8x8 original8board, b8copy, originalcopy;
-	CBmove movelist[MAXMOVES];
+	Cmove movelist[MAXMOVES];
 	CBmove localmove;
 	char PDN[40];
 	bool found_move, have_valid_movelist;
@@ -3281,6 +3302,11 @@ DWORD SearchThreadFunc(LPVOID param)
 
 	PDN[0] = 0;
 	found_move = false;
+
+	// if this engine has been pondering, stop it, its search of the position goes on in getmove
+	if (currentengine == ponderengine)
+		stop_pondering();
+
 	if (cboptions.use_incremental_time && CBstate != ENGINEMATCH && CBstate != AUTOPLAY && CBstate != ENGINEGAME) {
 
 		/* Player must have just made a move.
@@ -3300,13 +3326,13 @@ DWORD SearchThreadFunc(LPVOID param)
 	abortcalculation = 0;				// if this remains 0, we will execute the move - else not
 
 	/* Test if there is a move at all.
-	 * If the engine has the optional "get movelist" engine command then query that, otherwise
-	 * checkerboard rather recklessly uses the English checkers built-in movelist generator,
-	 * regardless of game type.
+	 * The built-in generator knows the rules of all the usual game types. For any other game type,
+	 * the engine is asked with its optional "get movelist" engine command, and if it does not have
+	 * that either, checkerboard rather recklessly uses the English checkers rules.
 	 */
-	if (get_movelist_from_engine(cbboard8, cbcolor, movelist, &nmoves, &iscapture)) {
-		nmoves = getmovelist(cbcolor, movelist, cbboard8, &iscapture);
-		have_valid_movelist = (gametype() == GT_ENGLISH);
+	if (get_legal_movelist(cbboard8, cbcolor, movelist, &nmoves, &iscapture, gametype())) {
+		nmoves = getmovelist(cbcolor, movelist, cbboard8, &iscapture, GT_ENGLISH);
+		have_valid_movelist = false;
 	}
 	else
 		have_valid_movelist = true;
@@ -3472,16 +3498,16 @@ DWORD SearchThreadFunc(LPVOID param)
 			// determine the move that was made: we only do this if we have a real movelist
 			// else the engine must return the appropriate information in localmove
 			if (have_valid_movelist) {
-				cbmove = movelist[0];
+				cmovetocbmove(&movelist[0], &cbmove);
 				for (i = 0; i < nmoves; i++) {
 
 					//put original board8 in b8copy, execute move and compare with returned board8...
 					memcpy(b8copy, original8board, sizeof(b8copy));
 					domove(movelist[i], b8copy);
 					if (memcmp(cbboard8, b8copy, sizeof(cbboard8)) == 0) {
-						cbmove = movelist[i];
+						cmovetocbmove(&movelist[i], &cbmove);
 						found_move = true;
-						move_to_pdn_english(nmoves, movelist, &cbmove, PDN, gametype());
+						move_to_pdn_english(nmoves, movelist, &movelist[i], PDN, gametype());
 						break;
 					}
 				}
@@ -3491,7 +3517,7 @@ DWORD SearchThreadFunc(LPVOID param)
 			}
 			else {
 
-				// gametype not GT_ENGLISH and we don't have a real movelist, use the move of the engine
+				// we don't have a real movelist for this game type, use the move of the engine
 				cbmove = localmove;
 				move4tonotation(localmove, PDN);
 				memcpy(cbboard8, original8board, sizeof(cbboard8));
@@ -3580,6 +3606,13 @@ DWORD SearchThreadFunc(LPVOID param)
 		if (cboptions.sound)
 			PlaySound("start.wav", NULL, SND_FILENAME | SND_ASYNC);
 
+		// let the engine think on the opponent's time
+		if (!gameover) {
+			memcpy(b8copy, original8board, sizeof(b8copy));
+			domove(cbmove, b8copy);
+			start_pondering(currentengine, b8copy, CB_CHANGECOLOR(cbcolor));
+		}
+
 		start_animation_thread();
 	}
 
@@ -3589,6 +3622,81 @@ DWORD SearchThreadFunc(LPVOID param)
 	return 1;
 }
 
+/*
+ * Return true if engine enginenum (1 or 2) can think on the opponent's time in the current mode.
+ */
+static bool engine_can_ponder(int enginenum)
+{
+	char reply[ENGINECOMMAND_REPLY_SIZE];
+	CB_ENGINECOMMAND command;
+
+	if (!cboptions.ponder)
+		return(false);
+	if (CBstate != NORMAL && CBstate != ENGINEMATCH)
+		return(false);
+
+	// if both engines are the same dll, they share one search and cannot ponder while the other one searches
+	if (CBstate == ENGINEMATCH && hinstLib1 == hinstLib2)
+		return(false);
+
+	command = (enginenum == 1) ? enginecommand1 : enginecommand2;
+	sprintf(reply, "");
+	if (command == NULL || !command("get ponder", reply))
+		return(false);
+	return(atoi(reply) != 0);
+}
+
+DWORD PonderThreadFunc(LPVOID param)
+// PonderThreadFunc lets the engine that has just moved search on the opponent's time.
+// getmove is called with the CB_PONDER info bit on the position after the engine's move,
+// the engine searches until pondernow is set and does not make a move.
+{
+	CB_GETMOVE ponder_getmove;
+	CBmove localmove;
+
+	ponder_getmove = (ponderengine == 1) ? getmove1 : getmove2;
+	SetCurrentDirectory(CBdirectory);
+	(ponder_getmove)(ponderboard, pondercolor, 0, ponder_txt, &pondernow, CB_PONDER, 0, &localmove);
+	return 1;
+}
+
+/*
+ * Start a ponder search of engine enginenum. board is the position after its move, color the opponent.
+ * A ponder search that is running is stopped first.
+ */
+void start_pondering(int enginenum, Board8x8 board, int color)
+{
+	stop_pondering();
+	if (!engine_can_ponder(enginenum))
+		return;
+
+	EnterCriticalSection(&ponder_criticalsection);
+	memcpy(ponderboard, board, sizeof(ponderboard));
+	pondercolor = color;
+	ponderengine = enginenum;
+	pondernow = 0;
+	hPonderThread = CreateThread(NULL, 100000, (LPTHREAD_START_ROUTINE)PonderThreadFunc, (LPVOID) 0, 0, &g_PonderThreadId);
+	if (hPonderThread == NULL)
+		ponderengine = 0;
+	LeaveCriticalSection(&ponder_criticalsection);
+}
+
+/*
+ * Stop the ponder search, if any, and wait for the engine to return from it.
+ */
+void stop_pondering(void)
+{
+	EnterCriticalSection(&ponder_criticalsection);
+	if (hPonderThread != NULL) {
+		pondernow = 1;
+		WaitForSingleObject(hPonderThread, INFINITE);
+		CloseHandle(hPonderThread);
+		hPonderThread = NULL;
+	}
+	ponderengine = 0;
+	LeaveCriticalSection(&ponder_criticalsection);
+}
+
 bool read_user_ballots_file(void)
 {
 	char *pdnstring, *p;
@@ -3633,7 +3741,7 @@ bool read_user_ballots_file(void)
 		for (int i = 0; i < (int)game.moves.size(); ++i) {
 			int status;
 			Squarelist squares;
-			CBmove move;
+			Cmove move;
 
 			PDNparseMove(game.moves[i].PDN, squares);
 			status = islegal_check(ballot.board, ballot.color, squares, &move, gametype());
@@ -4569,11 +4677,13 @@ void setcurrentengine(int engineN)
 	if (engineN == 1) {
 		getmove = getmove1;
 		islegal = islegal1;
+		enginemovelist = enginemovelist1;
 	}
 
 	if (engineN == 2) {
 		getmove = getmove2;
 		islegal = islegal2;
+		enginemovelist = enginemovelist2;
 	}
 
 	currentengine = engineN;
@@ -4618,10 +4728,14 @@ int gametype(void)
 int enginecommand(char command[MAXNAME], char reply[ENGINECOMMAND_REPLY_SIZE])
 // sends a command to the current engine, defined with the currentengine variable
 // wraps a 'safety layer around calls to engine command by checking if this is supported */
+// a command that may change the engine's settings first stops its ponder search.
 {
 	int result = 0;
 	sprintf(reply, "");
 
+	if (currentengine == ponderengine && strncmp(command, "get ", 4) != 0)
+		stop_pondering();
+
 	if (currentengine == 1 && enginecommand1 != 0)
 		result = enginecommand1(command, reply);
 
@@ -4708,6 +4822,46 @@ int undomove(CBmove m, Board8x8 b)
 	return 1;
 }
 
+int domove(Cmove &m, Board8x8 b)
+{
+	// do the compact move m on board b
+	uint32_t captures;
+	coor c;
+
+	c = squaretocoor(cmovefrom(m));
+	b[c.x][c.y] = 0;
+	for (captures = m.captures; captures; captures &= captures - 1) {
+		c = squaretocoor(LSB(captures));
+		b[c.x][c.y] = 0;
+	}
+	c = squaretocoor(cmoveto(m));
+	b[c.x][c.y] = cmovenewpiece(m);
+
+	return 1;
+}
+
+int undomove(Cmove &m, Board8x8 b)
+{
+	// take back the compact move m on board b
+	int oldpiece, capturedcolor, square;
+	uint32_t captures;
+	coor c;
+
+	oldpiece = cmoveoldpiece(m);
+	capturedcolor = CB_CHANGECOLOR(oldpiece & (CB_BLACK | CB_WHITE));
+	c = squaretocoor(cmoveto(m));
+	b[c.x][c.y] = 0;
+	c = squaretocoor(cmovefrom(m));
+	b[c.x][c.y] = oldpiece;
+	for (captures = m.captures; captures; captures &= captures - 1) {
+		square = LSB(captures);
+		c = squaretocoor(square);
+		b[c.x][c.y] = capturedcolor | ((m.kings & (1 << square)) ? CB_KING : CB_MAN);
+	}
+
+	return 1;
+}
+
 void move4tonotation(CBmove m, char s[80])
 // takes a move in coordinates, and transforms it to numbers.
 {
@@ -4841,7 +4995,7 @@ void addmovetogame(CBmove &move, char *pdn)
 
 	entry.analysis[0] = 0;
 	entry.comment[0] = 0;
-	entry.move = move;
+	cbmovetocmove(&move, &entry.move);
 	if (pdn != nullptr && pdn[0])
 		strcpy(entry.PDN, pdn);
 	else
@@ -4942,7 +5096,7 @@ bool pdntogame(PDNgame &game, Board8x8 startposition, int startcolor, std::strin
 	/* called by loadgame and gamepaste */
 	int i, color;
 	Board8x8 b8;
-	CBmove legalmove;
+	Cmove legalmove;
 
 	/* set the starting values */
 	color = startcolor;
@@ -4972,33 +5126,30 @@ bool pdntogame(PDNgame &game, Board8x8 startposition, int startcolor, std::strin
 	return(false);
 }
 
-int builtinislegal(Board8x8 board8, int color, Squarelist &squares, CBmove *move, int gametype)
+int builtinislegal(Board8x8 board8, int color, Squarelist &squares, Cmove *move, int gametype)
 {
 	// make all moves and try to find out if this move is legal
 	int i, n;
 	int Lfrom, Lto;
 	int isjump;
-	CBmove movelist[MAXMOVES];
+	Cmove movelist[MAXMOVES];
+	const CBsquaremap *map = get_squaremap(gametype);
 
-	if (has_getmovelist)
-		get_movelist_from_engine(board8, color, movelist, &n, &isjump);
-	else {
-		n = getmovelist(color, movelist, board8, &isjump);
-		assert(gametype == GT_ENGLISH);
-	}
+	if (get_legal_movelist(board8, color, movelist, &n, &isjump, gametype))
+		return(0);
 	for (i = 0; i < n; i++) {
-		Lfrom = coortonumber(movelist[i].from, gametype);
-		Lto = coortonumber(movelist[i].to, gametype);
+		Lfrom = map->bitnumber[cmovefrom(movelist[i])];
+		Lto = map->bitnumber[cmoveto(movelist[i])];
 		if (Lfrom == squares.first() && Lto == squares.last()) {
 
 			/* If more than 2 squares, the intermediates have to match also. */
 			if (squares.size() > 2) {
-				if (squares.size() - 2 != movelist[i].jumps - 1)	/* jumps has the number of landed squares in path[]. */
+				if (squares.size() - 2 != cmovejumps(movelist[i]) - 1)	/* jumps has the number of landed squares in path. */
 					continue;
 
 				bool match = true;
 				for (int k = 1; k < squares.size() - 1; ++k) {
-					int intermediate = coortonumber(movelist[i].path[k], gametype);
+					int intermediate = map->bitnumber[cmovesquare(movelist[i], k)];
 					if (squares.read(k) != intermediate) {
 						match = false;
 						break;
@@ -5027,59 +5178,72 @@ int builtinislegal(Board8x8 board8, int color, Squarelist &squares, CBmove *move
 }
 
 /*
- * Although we assign the islegal function pointer to this function for English checkers, it
- * does not get used. All islegal decisions are made through islegal_check().
+ * Although we assign the islegal function pointer to this function for engines that do not export
+ * islegal, it does not get used. All islegal decisions are made through islegal_check().
  */
 int builtinislegal(Board8x8 board8, int color, int from, int to, CBmove *move)
 {
 	Squarelist squares;
+	Cmove legalmove;
 
 	squares.append(from);
 	squares.append(to);
-	return(builtinislegal(board8, color, squares, move, GT_ENGLISH));
+	if (!builtinislegal(board8, color, squares, &legalmove, gametype()))
+		return(0);
+	cmovetocbmove(&legalmove, move);
+	return(1);
 }
 
 /*
- * For English game type we can use the builtin legal checker to resolve ambiguous moves, so send
+ * When we have a movelist we can use the builtin legal checker to resolve ambiguous moves, so send
  * it all squares that are needed to uniquely describe the move. Unfortunately, the interface to the 
  * engines does not allow sending intermediate squares, so we can't do this for the other game types.
  */
-int islegal_check(Board8x8 board8, int color, Squarelist &squares, CBmove *move, int gametype)
+int islegal_check(Board8x8 board8, int color, Squarelist &squares, Cmove *move, int gametype)
 {
-	if (has_getmovelist || gametype == GT_ENGLISH)
+	CBmove legalmove;
+
+	if (have_movelist(gametype))
 		return(builtinislegal(board8, color, squares, move, gametype));
-	else
-		return(islegal(board8, color, squares.first(), squares.last(), move));
+
+	if (!islegal(board8, color, squares.first(), squares.last(), &legalmove))
+		return(0);
+	cbmovetocmove(&legalmove, move);
+	return(1);
 }
 
 /*
- * For gametype English only.
+ * The functions from here to move_to_pdn_english() match moves against the movelist of
+ * the position, so they are only for game types with a movelist, see have_movelist().
+ */
+
+/*
  * Return true if square is a from, to, or intermediate landed square in move.
  */
-bool square_in_move(int square, CBmove &move, int gametype)
+bool square_in_move(int square, Cmove &move, int gametype)
 {
-	if (square == coortonumber(move.from, gametype))
+	if (square == squaretonumber(cmovefrom(move), gametype))
 		return(true);
-	if (square == coortonumber(move.to, gametype))
+	if (square == squaretonumber(cmoveto(move), gametype))
 		return(true);
-	for (int i = 1; i < move.jumps; ++i)
-		if (square == coortonumber(move.path[i], gametype))
+	for (int i = 1; i < cmovejumps(move); ++i)
+		if (square == squaretonumber(cmovesquare(move, i), gametype))
 			return(true);
 
 	return(false);
 }
 
 /*
- * For gametype English only.
  * Return true if every square in squares is either a from, to, or intermediate landed square in move.
  */
-bool all_squares_match(Squarelist &squares, CBmove &move, int gametype)
+bool all_squares_match(Squarelist &squares, Cmove &move, int gametype)
 {
 	/* Special case for 2 squares that both match the from square. They must also match
 	 * the to square to return true.
 	 */
 	if (squares.size() == 2 && squares.first() == squares.last())
-		return(squares.first() == coortonumber(move.from, gametype) && squares.last() == coortonumber(move.to, gametype));
+		return(squares.first() == squaretonumber(cmovefrom(move), gametype) &&
+				squares.last() == squaretonumber(cmoveto(move), gametype));
 
 	for (int i = 0; i < squares.size(); ++i)
 		if (!square_in_move(squares.read(i), move, gametype))
@@ -5089,24 +5253,22 @@ bool all_squares_match(Squarelist &squares, CBmove &move, int gametype)
 }
 
 /*
- * For gametype English only.
  * Return the sum of the from, to, and intermediate landed squares in move.
  * Used as a check to see if two moves are identical.
  */
-uint32_t get_sum_squares(CBmove &move)
+uint32_t get_sum_squares(Cmove &move)
 {
 	uint32_t sum;
 
-	sum = coortonumber(move.from, GT_ENGLISH);
-	sum += coortonumber(move.to, GT_ENGLISH);
-	for (int i = 1; i < move.jumps; ++i)
-		sum += coortonumber(move.path[i], GT_ENGLISH);
+	sum = squaretonumber(cmovefrom(move), GT_ENGLISH);
+	sum += squaretonumber(cmoveto(move), GT_ENGLISH);
+	for (int i = 1; i < cmovejumps(move); ++i)
+		sum += squaretonumber(cmovesquare(move, i), GT_ENGLISH);
 
 	return(sum);
 }
 
 /*
- * For gametype English only.
  * We've already determined that every square in squares matches a square in move (but there may be
  * more than one move that meets that constraint).
  * If we find that every square in move is matched by a square in squares, then we have found the move.
@@ -5116,27 +5278,28 @@ uint32_t get_sum_squares(CBmove &move)
  *		the move 2x9x18x11x2 is matched.
  * 3) To capture 2x9x18x27x20x11x4, click 2, 9, 20, and 4.
  */
-bool all_move_squares_matched(Squarelist &squares, CBmove &move, int gametype)
+bool all_move_squares_matched(Squarelist &squares, Cmove &move, int gametype)
 {
-	if (squares.first() != coortonumber(move.from, gametype))
+	if (squares.first() != squaretonumber(cmovefrom(move), gametype))
 		return(false);
-	if (!squares.frequency(coortonumber(move.to, gametype)))
+	if (!squares.frequency(squaretonumber(cmoveto(move), gametype)))
 		return(false);
 
-	for (int i = 1; i < move.jumps; ++i)
-		if (!squares.frequency(coortonumber(move.path[i], gametype)))
+	for (int i = 1; i < cmovejumps(move); ++i)
+		if (!squares.frequency(squaretonumber(cmovesquare(move, i), gametype)))
 			return(false);
 
 	return(true);
 }
 
-int num_moves_matching_fromto(CBmove movelist[], int nmoves, int from, int to, CBmove &move, int gametype)
+int num_moves_matching_fromto(Cmove movelist[], int nmoves, int from, int to, Cmove &move, int gametype)
 {
 	int nmatches, sum_squares;
+	const CBsquaremap *map = get_squaremap(gametype);
 
 	nmatches = 0;
 	for (int i = 0; i < nmoves; ++i) {
-		if (from == coortonumber(movelist[i].from, gametype) && to == coortonumber(movelist[i].to, gametype)) {
+		if (from == map->bitnumber[cmovefrom(movelist[i])] && to == map->bitnumber[cmoveto(movelist[i])]) {
 			if (nmatches == 0) {
 				++nmatches;
 				move = movelist[i];
@@ -5154,12 +5317,11 @@ int num_moves_matching_fromto(CBmove movelist[], int nmoves, int from, int to, C
 }
 
 /*
- * For gametype English only.
  * Return the number of moves in movelist that match the squares in the Squarelist.
  * The squares can be any of from, to, or any intermediate landing square during a capture.
  * If a single matching move is found, it is returned in move.
  */
-int num_matching_moves(CBmove movelist[], int nmoves, Squarelist &squares, CBmove &move, int gametype)
+int num_matching_moves(Cmove movelist[], int nmoves, Squarelist &squares, Cmove &move, int gametype)
 {
 	int nmatches, sum_squares;
 
@@ -5195,64 +5357,66 @@ int num_matching_moves(CBmove movelist[], int nmoves, Squarelist &squares, CBmov
 }
 
 /*
- * For gametype English only or Engines that have the optional getmovelist command.
  * Return the number of moves in the current position that match the squares in the Squarelist.
  * The squares can be any of from, to, or any intermediate landing square during a capture.
  * If a single matching move is found, it is returned in move.
  */
 int num_matching_moves(Board8x8 board8, int color, Squarelist &squares, CBmove &move, int gametype)
 {
-	int nmoves, isjump;
-	CBmove movelist[MAXMOVES];
-
-	if (has_getmovelist)
-		get_movelist_from_engine(board8, color, movelist, &nmoves, &isjump);
-	else
-		nmoves = getmovelist(color, movelist, board8, &isjump);
-	return(num_matching_moves(movelist, nmoves, squares, move, gametype));
+	int nmoves, nmatches, isjump;
+	Cmove movelist[MAXMOVES];
+	Cmove matching_move;
+
+	if (get_legal_movelist(board8, color, movelist, &nmoves, &isjump, gametype))
+		nmoves = 0;
+	nmatches = num_matching_moves(movelist, nmoves, squares, matching_move, gametype);
+	if (nmatches)
+		cmovetocbmove(&matching_move, &move);
+	return(nmatches);
 }
 
 /*
- * For gametype English only or Engines that have the optional getmovelist command.
  * Take a CBmove and write the move in PDN text format.
  * Write capture moves in long format if needed to unambiguously describe them.
- * This function is only for English checkers.
  * Return true on error, false on success.
  */
-bool move_to_pdn_english(int nmoves, CBmove movelist[MAXMOVES], CBmove *move, char *pdn, int gametype)
+bool move_to_pdn_english(int nmoves, Cmove movelist[MAXMOVES], Cmove *move, char *pdn, int gametype)
 {
-	int i, fromto_count, all_match_count;
+	int i, from, to, jumps, fromto_count, all_match_count;
 	char separator;
-	CBmove matching_move;
+	Cmove matching_move;
 	Squarelist squares;
 
 	/* Find the number of moves that match the from and to squares. */
 	pdn[0] = 0;
-	fromto_count = num_moves_matching_fromto(movelist, nmoves, coortonumber(move->from, gametype), coortonumber(move->to, gametype), matching_move, gametype);
+	from = squaretonumber(cmovefrom(*move), gametype);
+	to = squaretonumber(cmoveto(*move), gametype);
+	jumps = cmovejumps(*move);
+	fromto_count = num_moves_matching_fromto(movelist, nmoves, from, to, matching_move, gametype);
 	if (fromto_count == 0)
 		return(true);
 
-	separator = move->jumps ? 'x' : '-';
+	separator = jumps ? 'x' : '-';
 	if (fromto_count == 1)
-		sprintf(pdn, "%d%c%d", coortonumber(move->from, gametype), separator, coortonumber(move->to, gametype));
+		sprintf(pdn, "%d%c%d", from, separator, to);
 	else {
 		/* Add the path squares to the squares array. */
-		squares.append(coortonumber(move->from, gametype));
-		for (i = 1; i <= move->jumps; ++i)
-			squares.append(coortonumber(move->path[i], gametype));
-		squares.append(coortonumber(move->to, gametype));
+		squares.append(from);
+		for (i = 1; i <= jumps; ++i)
+			squares.append(squaretonumber(cmovesquare(*move, i), gametype));
+		squares.append(to);
 
 		/* Get count of moves that match all the squares. */
 		all_match_count = num_matching_moves(movelist, nmoves, squares, matching_move, gametype);
 		if (fromto_count > all_match_count) {
 			/* Need to use the full move notation. */
-			sprintf(pdn, "%d%c", coortonumber(move->from, gametype), separator);
-			for (i = 1; i < move->jumps; ++i)
-				sprintf(pdn + strlen(pdn), "%d%c", coortonumber(move->path[i], gametype), separator);
-			sprintf(pdn + strlen(pdn), "%d", coortonumber(move->to, gametype));
+			sprintf(pdn, "%d%c", from, separator);
+			for (i = 1; i < jumps; ++i)
+				sprintf(pdn + strlen(pdn), "%d%c", squaretonumber(cmovesquare(*move, i), gametype), separator);
+			sprintf(pdn + strlen(pdn), "%d", to);
 		}
 		else
-			sprintf(pdn, "%d%c%d", coortonumber(move->from, gametype), separator, coortonumber(move->to, gametype));
+			sprintf(pdn, "%d%c%d", from, separator, to);
 	}
 	return(false);
 }
@@ -5260,13 +5424,13 @@ bool move_to_pdn_english(int nmoves, CBmove movelist[MAXMOVES], CBmove *move, ch
 bool move_to_pdn_english(Board8x8 board8, int color, CBmove *move, char *pdn, int gametype)
 {
 	int isjump, nmoves;
-	CBmove movelist[MAXMOVES];
+	Cmove movelist[MAXMOVES];
+	Cmove cmove;
 
-	if (has_getmovelist)
-		get_movelist_from_engine(board8, color, movelist, &nmoves, &isjump);
-	else
-		nmoves = getmovelist(color, movelist, board8, &isjump);
-	return(move_to_pdn_english(nmoves, movelist, move, pdn, gametype));
+	if (get_legal_movelist(board8, color, movelist, &nmoves, &isjump, gametype))
+		nmoves = 0;
+	cbmovetocmove(move, &cmove);
+	return(move_to_pdn_english(nmoves, movelist, &cmove, pdn, gametype));
 }
 
 void newgame(void)
@@ -5463,6 +5627,7 @@ int load_engine
 		CB_GETSTRING *namefn,
 		CB_GETMOVE *getmovefn,
 		CB_ISLEGAL *islegalfn,
+		CB_GETMOVELIST *movelistfn,
 		char *pri_or_sec
 	)
 {
@@ -5484,6 +5649,7 @@ int load_engine
 		*islegalfn = (CB_ISLEGAL) GetProcAddress(*lib, "islegal");
 		if (*islegalfn == NULL)
 			*islegalfn = builtinislegal;
+		*movelistfn = (CB_GETMOVELIST) GetProcAddress(*lib, "getmovelist");
 		return(0);
 	}
 	else {
@@ -5496,6 +5662,7 @@ int load_engine
 		*namefn = NULL;
 		*getmovefn = NULL;
 		*islegalfn = NULL;
+		*movelistfn = NULL;
 		return(1);
 	}
 }
@@ -5514,6 +5681,9 @@ void loadengines(char *pri_fname, char *sec_fname)
 	HMODULE primaryhandle, secondaryhandle;
 	char Lstr[256];
 
+	// an engine must not be unloaded while it is pondering
+	stop_pondering();
+
 	// set built in functions
 	CBgametype = (CB_GETGAMETYPE) builtingametype;
 
@@ -5549,6 +5719,7 @@ void loadengines(char *pri_fname, char *sec_fname)
 			enginename1 = NULL;
 			getmove1 = NULL;
 			islegal1 = NULL;
+			enginemovelist1 = NULL;
 		}
 	}
 
@@ -5563,6 +5734,7 @@ void loadengines(char *pri_fname, char *sec_fname)
 			enginename2 = NULL;
 			getmove2 = NULL;
 			islegal2 = NULL;
+			enginemovelist2 = NULL;
 		}
 	}
 
@@ -5571,7 +5743,7 @@ void loadengines(char *pri_fname, char *sec_fname)
 	 * if the presently loaded primary engine handle is same as the secondary engine handle).
 	 */
 	if (!hinstLib1 || strcmp(pri_fname, cboptions.primaryenginestring)) {
-		status = load_engine(&hinstLib1, pri_fname, &enginecommand1, &enginename1, &getmove1, &islegal1, "primary");
+		status = load_engine(&hinstLib1, pri_fname, &enginecommand1, &enginename1, &getmove1, &islegal1, &enginemovelist1, "primary");
 		if (!status)
 			strcpy(cboptions.primaryenginestring, pri_fname);	/* Success. */
 		else {
@@ -5582,6 +5754,7 @@ void loadengines(char *pri_fname, char *sec_fname)
 									 &enginename1,
 									 &getmove1,
 									 &islegal1,
+									 &enginemovelist1,
 									 "primary");
 				if (status)
 					cboptions.primaryenginestring[0] = 0;
@@ -5590,7 +5763,7 @@ void loadengines(char *pri_fname, char *sec_fname)
 	}
 
 	if (!hinstLib2 || strcmp(sec_fname, cboptions.secondaryenginestring)) {
-		status = load_engine(&hinstLib2, sec_fname, &enginecommand2, &enginename2, &getmove2, &islegal2, "secondary");
+		status = load_engine(&hinstLib2, sec_fname, &enginecommand2, &enginename2, &getmove2, &islegal2, &enginemovelist2, "secondary");
 		if (!status)
 			strcpy(cboptions.secondaryenginestring, sec_fname); /* Success. */
 		else {
@@ -5601,6 +5774,7 @@ void loadengines(char *pri_fname, char *sec_fname)
 									 &enginename2,
 									 &getmove2,
 									 &islegal2,
+									 &enginemovelist2,
 									 "secondary");
 				if (status)
 					cboptions.secondaryenginestring[0] = 0;
@@ -5798,6 +5972,7 @@ void abortengine()
 {
 	clock_t t0;
 
+	stop_pondering();
 	if (!getenginebusy())
 		return;
 
@@ -5881,15 +6056,53 @@ int getmltok(char msg[], int &idx, char num[])
 }
 
 /*
- * If the current engine has the optional "get movelist" engine command, then use it to obtain a movelist
- * The function returns a non-zero value if the engine cannot use "get movelist" engine command.
+ * Return true if a movelist can be had for gametype, from the built-in generator or from the engine.
+ */
+bool have_movelist(int gametype)
+{
+	return(builtinmovelist(gametype) || enginemovelist != NULL || has_getmovelist);
+}
+
+/*
+ * Get the legal moves of color on board8. The built-in generator is used for the game types whose
+ * rules it knows, for other game types the engine is asked through get_movelist_from_engine().
+ * The function returns a non-zero value if no movelist could be obtained.
  */
-int get_movelist_from_engine(Board8x8 board8, int color, CBmove movelist[], int *nmoves, int *iscapture)
+int get_legal_movelist(Board8x8 board8, int color, Cmove movelist[], int *nmoves, int *iscapture, int gametype)
 {
-	int idx, square;
+	if (builtinmovelist(gametype)) {
+		*nmoves = getmovelist(color, movelist, board8, iscapture, gametype);
+		return(0);
+	}
+	return(get_movelist_from_engine(board8, color, movelist, nmoves, iscapture));
+}
+
+/*
+ * Obtain a movelist from the current engine. If the engine exports the optional getmovelist function,
+ * its moves are taken directly; otherwise, or if that fails, the optional "get movelist" engine command
+ * is used.
+ * The function returns a non-zero value if the engine can do neither.
+ */
+int get_movelist_from_engine(Board8x8 board8, int color, Cmove movelist[], int *nmoves, int *iscapture)
+{
+	int i, n, idx, square;
 	char buf[256];
 	char command[256];
 	char reply[ENGINECOMMAND_REPLY_SIZE];
+	CBmove move;
+	CBmove cbmovelist[MAXMOVES];
+	const CBsquaremap *map = get_squaremap(cbgame.gametype);
+
+	if (enginemovelist != NULL) {
+		n = enginemovelist(board8, color, cbmovelist, MAXMOVES);
+		if (n >= 0 && n <= MAXMOVES) {
+			for (i = 0; i < n; ++i)
+				cbmovetocmove(&cbmovelist[i], &movelist[i]);
+			*nmoves = n;
+			*iscapture = n ? cmovejumps(movelist[0]) : 0;
+			return(0);
+		}
+	}
 
 	if (!has_getmovelist)
 		return(1);
@@ -5918,63 +6131,72 @@ int get_movelist_from_engine(Board8x8 board8, int color, CBmove movelist[], int
 	for (int mv = 0; mv < *nmoves; ++mv) {
 		if (getmltok(reply, idx, buf) != MLNUM)
 			return(1);
-		movelist[mv].jumps = atoi(buf);
+		move.jumps = atoi(buf);
 
 		if (getmltok(reply, idx, buf) != MLCOMMA)
 			return(1);
 		if (getmltok(reply, idx, buf) != MLNUM)
 			return(1);
-		movelist[mv].oldpiece = atoi(buf);
+		move.oldpiece = atoi(buf);
 
 		if (getmltok(reply, idx, buf) != MLCOMMA)
 			return(1);
 		if (getmltok(reply, idx, buf) != MLNUM)
 			return(1);
-		movelist[mv].newpiece = atoi(buf);
+		move.newpiece = atoi(buf);
 
 		if (getmltok(reply, idx, buf) != MLCOMMA)
 			return(1);
 		if (getmltok(reply, idx, buf) != MLNUM)
 			return(1);
 		square = atoi(buf);
-		numbertocoors(square, &movelist[mv].from, cbgame.gametype);
+		if (square < 1 || square > 32)
+			return(1);
+		move.from = map->coors[square];
 
 		if (getmltok(reply, idx, buf) != MLCOMMA)
 			return(1);
 		if (getmltok(reply, idx, buf) != MLNUM)
 			return(1);
 		square = atoi(buf);
-		numbertocoors(square, &movelist[mv].to, cbgame.gametype);
+		if (square < 1 || square > 32)
+			return(1);
+		move.to = map->coors[square];
 
-		for (int i = 0; i < movelist[mv].jumps; ++i) {
+		for (int i = 0; i < move.jumps; ++i) {
 			if (getmltok(reply, idx, buf) != MLCOMMA)
 				return(1);
 			if (getmltok(reply, idx, buf) != MLNUM)
 				return(1);
 			square = atoi(buf);
-			numbertocoors(square, &movelist[mv].path[i + 1], cbgame.gametype);
+			if (square < 1 || square > 32)
+				return(1);
+			move.path[i + 1] = map->coors[square];
 
 			if (getmltok(reply, idx, buf) != MLCOMMA)
 				return(1);
 			if (getmltok(reply, idx, buf) != MLNUM)
 				return(1);
 			square = atoi(buf);
-			numbertocoors(square, &movelist[mv].del[i], cbgame.gametype);
+			if (square < 1 || square > 32)
+				return(1);
+			move.del[i] = map->coors[square];
 
 			if (getmltok(reply, idx, buf) != MLCOMMA)
 				return(1);
 			if (getmltok(reply, idx, buf) != MLNUM)
 				return(1);
-			movelist[mv].delpiece[i] = atoi(buf);
+			move.delpiece[i] = atoi(buf);
 		}
 
 		if (getmltok(reply, idx, buf) != MLSEMI)
 			return(1);
+		cbmovetocmove(&move, &movelist[mv]);
 	}
 	if (getmltok(reply, idx, buf) != MLEND)
 		return(1);
 
-	*iscapture = movelist[0].jumps;
+	*iscapture = cmovejumps(movelist[0]);
 	return(0);
 }
 
@@ -41,21 +41,23 @@ LRESULT CALLBACK CB_edit_func(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPa
 // thread functions
 DWORD AutoThreadFunc(LPVOID param);
 DWORD SearchThreadFunc(LPVOID param);
+DWORD PonderThreadFunc(LPVOID param);
 
 // my functions in alphabetical list
 void abortengine();
 int addmovetouserbook(Board8x8 board, CBmove *move);
 void add_piecesets_to_menu(HMENU hmenu);
 void addmovetogame(CBmove &move, char *pdn);
-int islegal_check(Board8x8 board, int color, Squarelist &squares, CBmove *move, int gametype);
+int islegal_check(Board8x8 board, int color, Squarelist &squares, Cmove *move, int gametype);
 int num_matching_moves(Board8x8 board, int color, Squarelist &squares, CBmove &move, int gametype);
-bool move_to_pdn_english(int nmoves, CBmove movelist[MAXMOVES], CBmove *move, char *pdn, int gametype);
+bool move_to_pdn_english(int nmoves, Cmove movelist[MAXMOVES], Cmove *move, char *pdn, int gametype);
 bool move_to_pdn_english(Board8x8 board, int color, CBmove *move, char *pdn, int gametype);
 int changeCBstate(int newstate);
 HWND CreateAToolBar(HWND hwndParent);
 int createcheckerboard(HWND hwnd);
 bool doload(PDNgame *PDNgame, const char *gamestring, int *color, Board8x8 board, std::string &errormsg);
 int domove(CBmove m, Board8x8 board);
+int domove(Cmove &m, Board8x8 board);
 int update_match_stats(int result, int movecount, int gamenumber, emstats_t *stats);
 void emlog_filename(char *filename);
 void empdn_filename(char *filename);
@@ -72,7 +74,7 @@ int getfilename(char filename[255], int what);
 int getanimationbusy(void);
 int getenginebusy(void);
 int getenginestarting(void);
-int getmovelist(int color, CBmove movelist[MAXMOVES], Board8x8 board, int *isjump);
+int getmovelist(int color, Cmove movelist[MAXMOVES], Board8x8 board, int *isjump, int gametype);
 int gametype(void);
 int handlegamereplace(int replaceindex, char *databasename);
 int handlesetupcc(int *color);
@@ -107,8 +109,13 @@ int setenginebusy(int value);
 int setenginestarting(int value);
 int showfile(char *filename);
 int start3move(int opening_index);
+void start_pondering(int enginenum, Board8x8 board, int color);
+void stop_pondering(void);
 int undomove(CBmove m, Board8x8 board);
-int get_movelist_from_engine(Board8x8 board, int color, CBmove movelist[], int *nmoves, int *iscapture);
+int undomove(Cmove &m, Board8x8 board);
+int get_movelist_from_engine(Board8x8 board, int color, Cmove movelist[], int *nmoves, int *iscapture);
+int get_legal_movelist(Board8x8 board, int color, Cmove movelist[], int *nmoves, int *iscapture, int gametype);
+bool have_movelist(int gametype);
 
 extern char CBdirectory[MAX_PATH];	// holds the directory from where CB is started:
 extern char CBdocuments[MAX_PATH];
@@ -230,6 +237,7 @@ extern char CBdocuments[MAX_PATH];
 #define ENGINEABOUT 602
 #define ENGINEHELP 603
 #define ENGINEOPTIONS 604
+#define ENGINEPONDER 605
 
 #define CM_ENGINEMATCH 800
 #define CM_ADDCOMMENT 802
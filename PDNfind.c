@@ -265,7 +265,7 @@ int pdnopen(char filename[256], int gametype)
 		while (1) {
 			int status;
 			const char *lastp;
-			CBmove move;
+			Cmove move;
 
 			lastp = starttoken;
 			if (!PDNparseGetnexttoken(&starttoken, token, sizeof(token)))
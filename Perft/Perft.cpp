@@ -2,19 +2,76 @@
 #include <tchar.h>
 #include <time.h>
 #include <assert.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include "cb_interface.h"
 #include "bitboard.h"
 #include "board46_intf.h"
+#include "movegen_intf.h"
 #include "enginedefs.h"
 
 
 #define TDIFF(start) (((double)(clock() + 1 - start)) / (double)CLOCKS_PER_SEC)	/* Add 1ms to prevent division by 0. */
+#define MAXTHREADS 64
 
-INT64 Perft(int board[46], int color, int depth, int ply, int printpos);
+/* A subtree of the perft tree, rooted splitdepth plies below the root. */
+struct PERFT_WORK {
+	int board[46];
+	int color;
+	uint64_t key;
+	int rootmove;				/* index of the root move that leads to this subtree */
+	INT64 nodes;
+};
+
+/* Each thread owns the work items [head, tail). It takes work from the head of its own
+ * range, and when that is empty it steals from the tail of another thread's range.
+ */
+struct PERFT_THREAD {
+	int id;
+	HANDLE handle;
+	CRITICAL_SECTION lock;
+	int head, tail;
+	INT64 nodes;
+	int items;
+	int stolen;
+	INT64 probes;
+	INT64 hits;
+};
+
+/* The perft hashtable is shared by all threads without locking. An entry is only used if
+ * check xor data gives the key of the position, so an entry that was torn by two threads
+ * writing it at the same time is not used. A bucket has two entries, the first keeps the
+ * deepest subtree, the second is always replaced.
+ */
+struct PERFT_HASHENTRY {
+	uint64_t check;				/* zobrist key xor data. */
+	uint64_t data;				/* bits 0 - 7: remaining depth, bits 8 - 63: node count. */
+};
+
+INT64 Perft(PERFT_THREAD *t, int board[46], int color, uint64_t key, int depth);
+INT64 parallel_perft(int board[46], int color, uint64_t key, int depth, INT64 rootnodes[MAXMOVES]);
+INT64 divide(int board[46], int color, uint64_t key, int depth, INT64 rootnodes[MAXMOVES]);
+void print_divide(int board[46], int color, INT64 rootnodes[MAXMOVES]);
+void print_stats(int depth);
+int run_suite(char *filename, int maxdepth);
 void usage();
 
+static int perftthreads = 1;
+static int gametype;				/* if not 0, use the move generator of CheckerBoard for this game type */
+static int splitdepth = 3;
+static PERFT_THREAD workers[MAXTHREADS];
+static PERFT_WORK *work;
+static int numwork, worksize;
+static int workdepth;				/* remaining depth of each work item */
+static PERFT_HASHENTRY *hashtable;
+static uint64_t hashmask;			/* number of buckets - 1 */
+static int hashsize_MB;
+static uint64_t zobrist[46][32];	/* indexed by square and the value of b[square] */
+static uint64_t zobrist_color;
+
 
 
 int build_movelist(int board[46], int color, move2 movelist[MAXMOVES])
@@ -28,18 +85,146 @@ int build_movelist(int board[46], int color, move2 movelist[MAXMOVES])
 }
 
 
+void init_hashkeys()
+{
+	int i, j;
+	uint64_t x = 0x9e3779b97f4a7c15ULL;
+
+	for (i = 0; i < 46; i++) {
+		for (j = 0; j < 32; j++) {
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+			zobrist[i][j] = x;
+		}
+	}
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	zobrist_color = x;
+}
+
+
+/*
+ * Allocate a hashtable of at most megabytes MB, rounded down to a power of 2 buckets.
+ * Return 1 on success, 0 if the memory could not be allocated.
+ */
+int set_hashsize(int megabytes)
+{
+	uint64_t buckets;
+
+	buckets = 1;
+	while (buckets * 4 * sizeof(PERFT_HASHENTRY) <= (uint64_t)megabytes * 1024 * 1024)
+		buckets *= 2;
+
+	hashtable = (PERFT_HASHENTRY *)calloc((size_t)(2 * buckets), sizeof(PERFT_HASHENTRY));
+	if (hashtable == NULL)
+		return(0);
+	hashmask = buckets - 1;
+	hashsize_MB = megabytes;
+	return(1);
+}
+
+
+uint64_t hash_position(int board[46], int color)
+{
+	int i;
+	uint64_t key;
+
+	key = 0;
+	for (i = 0; i < 46; ++i)
+		key ^= zobrist[i][board[i] & 31];
+	if (color == CB_WHITE)
+		key ^= zobrist_color;
+	return(key);
+}
+
+
+/*
+ * Return the change in the zobrist key made by move, including the change of the side to move.
+ */
+uint64_t hash_move(move2 &move)
+{
+	int i, square;
+	uint64_t key;
+
+	key = zobrist_color;
+	for (i = 0; i < move.n; ++i) {
+		square = move.m[i] % 256;
+		key ^= zobrist[square][(move.m[i] >> 8) & 31] ^ zobrist[square][(move.m[i] >> 16) & 31];
+	}
+	return(key);
+}
+
+
+int hash_lookup(uint64_t key, int depth, INT64 *nodes)
+{
+	int i;
+	uint64_t check, data;
+	PERFT_HASHENTRY *bucket;
+
+	bucket = hashtable + 2 * (key & hashmask);
+	for (i = 0; i < 2; ++i) {
+		check = bucket[i].check;
+		data = bucket[i].data;
+		if ((check ^ data) == key && (int)(data & 255) == depth) {
+			*nodes = (INT64)(data >> 8);
+			return(1);
+		}
+	}
+	return(0);
+}
+
+
+void hash_store(uint64_t key, int depth, INT64 nodes)
+{
+	uint64_t data;
+	PERFT_HASHENTRY *entry;
+
+	data = ((uint64_t)nodes << 8) | (uint64_t)depth;
+	entry = hashtable + 2 * (key & hashmask);
+	if ((int)(entry->data & 255) > depth)
+		++entry;
+	entry->check = key ^ data;
+	entry->data = data;
+}
+
+
+/*
+ * Return the fraction of used entries, estimated from the first entries of the table.
+ */
+double hash_usage()
+{
+	uint64_t i, n, used;
+
+	n = min(2 * (hashmask + 1), (uint64_t)65536);
+	used = 0;
+	for (i = 0; i < n; ++i)
+		if (hashtable[i].data)
+			++used;
+	return((double)used / (double)n);
+}
+
+
 int _tmain(int argc, _TCHAR *argv[])
 {
 	int i, color, depth;
 	int board46[46];
+	pos apppos;
 	INT64 nodes;
-	int printpos;
-	char *p, *fenpos;
+	int printpos, hashsize;
+	char *p, *fenpos, *suitefile;
 	clock_t t0;
+	double sec;
+	uint64_t key;
+	INT64 rootnodes[MAXMOVES];
 
 	fenpos = 0;
+	suitefile = 0;
 	printpos = 0;
-	depth = 12;
+	hashsize = 0;
+	depth = 0;
 	if (argc == 1)
 		usage();
 	for (i = 1; i < argc; ++i) {
@@ -64,11 +249,119 @@ int _tmain(int argc, _TCHAR *argv[])
 				}
 				break;
 
+			case 'g':
+				if (p[2])
+					gametype = atoi(p + 2);
+				else {
+					++i;
+					gametype = atoi(argv[i]);
+				}
+				break;
+
+			case 'H':
+				if (p[2])
+					hashsize = atoi(p + 2);
+				else {
+					++i;
+					hashsize = atoi(argv[i]);
+				}
+				break;
+
 			case 'p':
 				printpos = 1;
 				break;
+
+			case 'S':
+				if (p[2])
+					suitefile = p + 2;
+				else {
+					++i;
+					suitefile = argv[i];
+				}
+				break;
+
+			case 's':
+				if (p[2])
+					splitdepth = atoi(p + 2);
+				else {
+					++i;
+					splitdepth = atoi(argv[i]);
+				}
+				break;
+
+			case 't':
+				if (p[2])
+					perftthreads = atoi(p + 2);
+				else {
+					++i;
+					perftthreads = atoi(argv[i]);
+				}
+				break;
+
+			default:
+				printf("Unknown option %s\n\n", p);
+				usage();
+				exit(1);
 			}
 		}
+		else {
+			printf("Unknown argument %s\n\n", p);
+			usage();
+			exit(1);
+		}
+	}
+
+	if (gametype && !builtinmovelist(gametype)) {
+		printf("No move generator for game type %d\n", gametype);
+		exit(1);
+	}
+	if (perftthreads < 1)
+		perftthreads = 1;
+	if (perftthreads > MAXTHREADS)
+		perftthreads = MAXTHREADS;
+	if (splitdepth < 1)
+		splitdepth = 1;
+	for (i = 0; i < perftthreads; ++i) {
+		workers[i].id = i;
+		InitializeCriticalSection(&workers[i].lock);
+	}
+
+	if (hashsize > 0) {
+		if (!set_hashsize(hashsize)) {
+			printf("Cannot allocate a %d MB hashtable\n", hashsize);
+			exit(1);
+		}
+		printf("hashtable %d MB, %I64d entries\n", hashsize_MB, (INT64)(2 * (hashmask + 1)));
+	}
+	init_hashkeys();
+
+	if (suitefile) {
+		i = run_suite(suitefile, depth);
+		exit(i ? 1 : 0);
+	}
+
+	if (gametype) {
+		if (fenpos == 0) {
+			printf("Use -f to set the root position for game type %d\n", gametype);
+			exit(1);
+		}
+		if (app_parse_fen(fenpos, gametype, &apppos, &color)) {
+			printf("Error in app_parse_fen()\n");
+			exit(1);
+		}
+		if (depth == 0)
+			depth = 12;
+		for (i = 1; i <= depth; ++i) {
+			t0 = clock();
+			if (printpos)
+				nodes = app_print_divide(&apppos, color, i, gametype);
+			else
+				nodes = app_perft(&apppos, color, i, gametype);
+			sec = TDIFF(t0);
+			printf("perft(%d) %I64d nodes, %.2f sec, %.0f knodes/sec\n",
+				i, nodes, sec, (double)nodes / (1000.0 * sec));
+		}
+		exit(0);
 	}
 
 	if (fenpos) {
@@ -79,24 +372,351 @@ int _tmain(int argc, _TCHAR *argv[])
 	}
 	else
 		get_start_pos(board46, &color);
+	key = hash_position(board46, color);
 
+	if (depth == 0)
+		depth = 12;
 	for (i = 1; i <= depth; ++i) {
 		t0 = clock();
-		nodes = Perft(board46, color, i, 0, printpos);
+		nodes = divide(board46, color, key, i, rootnodes);
+		sec = TDIFF(t0);
+		if (printpos)
+			print_divide(board46, color, rootnodes);
 		printf("perft(%d) %I64d nodes, %.2f sec, %.0f knodes/sec\n",
-			i, nodes, TDIFF(t0), (double)nodes / (1000.0 * TDIFF(t0)));
+			i, nodes, sec, (double)nodes / (1000.0 * sec));
+		print_stats(i);
 	}
+	for (i = 0; i < perftthreads; ++i)
+		DeleteCriticalSection(&workers[i].lock);
+	free(work);
+	free(hashtable);
 	return 0;
 }
 
 
-INT64 Perft(int board[46], int color, int depth, int ply, int printpos)
+/*
+ * Run the perft tests in filename. Each line has a FEN string followed by the expected
+ * node counts, as in
+ *     B:W21-32:B1-12 ;D1 7 ;D2 49 ;D3 302
+ * Empty lines and lines starting with '#' are skipped, as are depths greater than maxdepth
+ * if it is not 0. A result line is printed for each test, and the divide output if the
+ * count is wrong. With -g the positions are in the square numbers of that game type and are
+ * counted with the move generator of CheckerBoard. Return the number of failed tests.
+ */
+int run_suite(char *filename, int maxdepth)
+{
+	int board46[46];
+	pos apppos;
+	int i, color, depth, position, tests, failed, pass;
+	char line[1024];
+	char *p, *fen;
+	INT64 nodes, expected;
+	INT64 rootnodes[MAXMOVES];
+	uint64_t key;
+	clock_t t0, tstart;
+	double sec;
+	FILE *fp;
+
+	fp = fopen(filename, "r");
+	if (fp == NULL) {
+		printf("Cannot open %s\n", filename);
+		return(1);
+	}
+
+	position = 0;
+	tests = 0;
+	failed = 0;
+	tstart = clock();
+	while (fgets(line, sizeof(line), fp)) {
+		for (p = line; *p == ' ' || *p == '\t'; ++p)
+			;
+		if (*p == 0 || *p == '\n' || *p == '\r' || *p == '#')
+			continue;
+
+		fen = p;
+		p = strchr(p, ';');
+		if (p)
+			*p++ = 0;
+		for (i = (int)strlen(fen); i > 0 && isspace((unsigned char)fen[i - 1]); --i)
+			fen[i - 1] = 0;
+		++position;
+		if (gametype) {
+			if (app_parse_fen(fen, gametype, &apppos, &color)) {
+				printf("position %d: error in app_parse_fen()\n", position);
+				++failed;
+				continue;
+			}
+		}
+		else if (parse_fen(fen, board46, &color)) {
+			printf("position %d: error in parse_fen()\n", position);
+			++failed;
+			continue;
+		}
+		key = gametype ? 0 : hash_position(board46, color);
+		printf("position %d %s\n", position, fen);
+
+		/* The expected counts are ";D<depth> <nodes>" fields. */
+		while (p) {
+			while (*p == ' ')
+				++p;
+			if (toupper(*p) != 'D')
+				break;
+			depth = atoi(p + 1);
+			while (*p && *p != ' ')
+				++p;
+			expected = _atoi64(p);
+			p = strchr(p, ';');
+			if (p)
+				++p;
+			if (depth < 1 || (maxdepth && depth > maxdepth))
+				continue;
+
+			t0 = clock();
+			if (gametype)
+				nodes = app_perft(&apppos, color, depth, gametype);
+			else
+				nodes = divide(board46, color, key, depth, rootnodes);
+			sec = TDIFF(t0);
+			pass = (nodes == expected);
+			++tests;
+			if (!pass)
+				++failed;
+			printf("test position %d depth %d nodes %I64d expected %I64d result %s sec %.3f knps %.0f\n",
+				position, depth, nodes, expected, pass ? "pass" : "FAIL", sec, (double)nodes / (1000.0 * sec));
+			if (!pass && gametype)
+				app_print_divide(&apppos, color, depth, gametype);
+			else if (!pass)
+				print_divide(board46, color, rootnodes);
+		}
+	}
+	fclose(fp);
+	printf("suite %s positions %d tests %d passed %d failed %d sec %.3f\n",
+		filename, position, tests, tests - failed, failed, TDIFF(tstart));
+	return(failed);
+}
+
+
+/*
+ * Count the nodes at depth below board, with the counts of the subtrees of the root moves in
+ * rootnodes[]. The thread and hashtable statistics are reset first.
+ */
+INT64 divide(int board[46], int color, uint64_t key, int depth, INT64 rootnodes[MAXMOVES])
+{
+	int nmoves, i;
+	INT64 sumnodes;
+	move2 movelist[MAXMOVES];
+
+	for (i = 0; i < perftthreads; ++i) {
+		workers[i].nodes = 0;
+		workers[i].items = 0;
+		workers[i].stolen = 0;
+		workers[i].probes = 0;
+		workers[i].hits = 0;
+	}
+	if (perftthreads > 1 && depth > 1)
+		return(parallel_perft(board, color, key, depth, rootnodes));
+
+	sumnodes = 0;
+	nmoves = build_movelist(board, color, movelist);
+	for (i = 0; i < nmoves; ++i) {
+		if (depth == 1)
+			rootnodes[i] = 1;
+		else {
+			domove(board, movelist[i]);
+			rootnodes[i] = Perft(workers, board, CB_CHANGECOLOR(color), key ^ hash_move(movelist[i]), depth - 1);
+			undomove(board, movelist[i]);
+		}
+		sumnodes += rootnodes[i];
+	}
+	return(sumnodes);
+}
+
+
+void print_divide(int board[46], int color, INT64 rootnodes[MAXMOVES])
 {
 	int nmoves, i;
-	INT64 nodes, sumnodes;
 	char fenbuf[150];
 	move2 movelist[MAXMOVES];
 
+	nmoves = build_movelist(board, color, movelist);
+	for (i = 0; i < nmoves; ++i) {
+		domove(board, movelist[i]);
+		print_fen(board, CB_CHANGECOLOR(color), fenbuf);
+		printf("%s; nodes %I64d\n", fenbuf, rootnodes[i]);
+		undomove(board, movelist[i]);
+	}
+}
+
+
+/*
+ * Print the thread and hashtable statistics of the last perft.
+ */
+void print_stats(int depth)
+{
+	int k;
+	INT64 probes, hits;
+
+	if (perftthreads > 1 && depth > 1) {
+		for (k = 0; k < perftthreads; ++k)
+			printf("    thread %d: %I64d nodes, %d work items (%d stolen)\n",
+				k, workers[k].nodes, workers[k].items, workers[k].stolen);
+	}
+	if (hashtable) {
+		probes = hits = 0;
+		for (k = 0; k < perftthreads; ++k) {
+			probes += workers[k].probes;
+			hits += workers[k].hits;
+		}
+		printf("    hash: %I64d probes, %.1f%% hits, %.1f%% full\n",
+			probes, probes ? 100.0 * hits / probes : 0.0, 100.0 * hash_usage());
+	}
+}
+
+
+/*
+ * Expand the tree below board to the given depth and append each position reached as a work item.
+ */
+void split_work(int board[46], int color, uint64_t key, int depth, int ply, int rootmove)
+{
+	int nmoves, i;
+	move2 movelist[MAXMOVES];
+	PERFT_WORK *w;
+
+	if (depth == 0) {
+		if (numwork == worksize) {
+			worksize = worksize ? 2 * worksize : 1024;
+			work = (PERFT_WORK *)realloc(work, worksize * sizeof(PERFT_WORK));
+			if (work == NULL) {
+				printf("Cannot allocate %d work items\n", worksize);
+				exit(1);
+			}
+		}
+		w = work + numwork++;
+		memcpy(w->board, board, sizeof(w->board));
+		w->color = color;
+		w->key = key;
+		w->rootmove = rootmove;
+		w->nodes = 0;
+		return;
+	}
+
+	nmoves = build_movelist(board, color, movelist);
+	for (i = 0; i < nmoves; ++i) {
+		domove(board, movelist[i]);
+		split_work(board, CB_CHANGECOLOR(color), key ^ hash_move(movelist[i]), depth - 1, ply + 1, ply == 0 ? i : rootmove);
+		undomove(board, movelist[i]);
+	}
+}
+
+
+/*
+ * Return the next work item for thread t, or NULL when all the work has been handed out.
+ */
+PERFT_WORK *next_work(PERFT_THREAD *t)
+{
+	int i, item;
+	PERFT_THREAD *victim;
+
+	item = -1;
+	EnterCriticalSection(&t->lock);
+	if (t->head < t->tail)
+		item = t->head++;
+	LeaveCriticalSection(&t->lock);
+	if (item >= 0)
+		return(work + item);
+
+	for (i = 1; i < perftthreads; ++i) {
+		victim = workers + (t->id + i) % perftthreads;
+		EnterCriticalSection(&victim->lock);
+		if (victim->head < victim->tail)
+			item = --victim->tail;
+		LeaveCriticalSection(&victim->lock);
+		if (item >= 0) {
+			++t->stolen;
+			return(work + item);
+		}
+	}
+	return(NULL);
+}
+
+
+DWORD WINAPI perftthread(LPVOID param)
+{
+	PERFT_THREAD *t = (PERFT_THREAD *)param;
+	PERFT_WORK *w;
+
+	while ((w = next_work(t)) != NULL) {
+		w->nodes = Perft(t, w->board, w->color, w->key, workdepth);
+		t->nodes += w->nodes;
+		++t->items;
+	}
+	return(0);
+}
+
+
+/*
+ * Perft using perftthreads threads. The tree is split splitdepth plies below the root (less if
+ * depth is too small), and the subtrees are divided evenly over the threads as work items.
+ */
+INT64 parallel_perft(int board[46], int color, uint64_t key, int depth, INT64 rootnodes[MAXMOVES])
+{
+	int i, k, split;
+	INT64 sumnodes;
+	HANDLE handles[MAXTHREADS];
+	DWORD threadid;
+
+	split = min(splitdepth, depth - 1);
+	workdepth = depth - split;
+	numwork = 0;
+	split_work(board, color, key, split, 0, 0);
+
+	for (k = 0; k < perftthreads; ++k) {
+		workers[k].head = (int)((INT64)numwork * k / perftthreads);
+		workers[k].tail = (int)((INT64)numwork * (k + 1) / perftthreads);
+	}
+
+	/* The main thread works as thread 0. */
+	for (k = 1; k < perftthreads; ++k) {
+		workers[k].handle = CreateThread(NULL, 0, perftthread, workers + k, 0, &threadid);
+		if (workers[k].handle == NULL) {
+			printf("Cannot create thread %d\n", k);
+			exit(1);
+		}
+		handles[k - 1] = workers[k].handle;
+	}
+	perftthread(workers);
+	WaitForMultipleObjects(perftthreads - 1, handles, TRUE, INFINITE);
+	for (k = 1; k < perftthreads; ++k)
+		CloseHandle(workers[k].handle);
+
+	sumnodes = 0;
+	memset(rootnodes, 0, MAXMOVES * sizeof(rootnodes[0]));
+	for (i = 0; i < numwork; ++i) {
+		sumnodes += work[i].nodes;
+		rootnodes[work[i].rootmove] += work[i].nodes;
+	}
+	return(sumnodes);
+}
+
+
+/*
+ * Count the leaf nodes depth plies below board. At depth 1 the moves are counted without
+ * making them.
+ */
+INT64 Perft(PERFT_THREAD *t, int board[46], int color, uint64_t key, int depth)
+{
+	int nmoves, i;
+	INT64 sumnodes;
+	move2 movelist[MAXMOVES];
+
+	if (depth > 1 && hashtable) {
+		++t->probes;
+		if (hash_lookup(key, depth, &sumnodes)) {
+			++t->hits;
+			return(sumnodes);
+		}
+	}
+
 	nmoves = build_movelist(board, color, movelist);
 	if (depth == 1)
 		return(nmoves);
@@ -104,14 +724,11 @@ INT64 Perft(int board[46], int color, int depth, int ply, int printpos)
 	sumnodes = 0;
 	for (i = 0; i < nmoves; ++i) {
 		domove(board, movelist[i]);
-		nodes = Perft(board, CB_CHANGECOLOR(color), depth - 1, ply + 1, printpos);
-		if (ply == 0 && printpos) {
-			print_fen(board, CB_CHANGECOLOR(color), fenbuf);
-			printf("%s; nodes %I64d\n", fenbuf, nodes);
-		}
+		sumnodes += Perft(t, board, CB_CHANGECOLOR(color), key ^ hash_move(movelist[i]), depth - 1);
 		undomove(board, movelist[i]);
-		sumnodes += nodes;
 	}
+	if (hashtable)
+		hash_store(key, depth, sumnodes);
 	return(sumnodes);
 }
 
@@ -121,9 +738,15 @@ void usage()
 	char *usagetxt = 
 		"usage: perft [options]\n"
 		"\n"
-		"-d depth           set max depth (default 12)\n"
+		"-d depth           set max depth (default 12, in a suite no limit)\n"
+		"-H megabytes       use a hashtable of this size for subtree counts (default none)\n"
 		"-p                 print first successor positions and counts\n"
-		"-f fenstring       set the root position (use FEN string)\n\n";
+		"-f fenstring       set the root position (use FEN string)\n"
+		"-g gametype        count with the move generator of CheckerBoard for this game type, e.g. 25 for\n"
+		"                   russian, in one thread without a hashtable. A position must be given with -f or -S\n"
+		"-S suitefile       run the tests in suitefile, lines of \"fen ;D1 nodes ;D2 nodes ...\"\n"
+		"-t threads         number of perft threads (default 1)\n"
+		"-s splitdepth      depth at which the tree is split into work items for the threads (default 3)\n\n";
 	printf(usagetxt);
 }
 
@@ -10,67 +10,25 @@
 
 
 #ifdef ITALIAN_RULES
-static int sqmap[] = {
-	 0,
-	 5,  6,  7,  8,		/* squares 1 2 3 4 */
-	10, 11, 12, 13,		/* squares 5 6 7 8 */
-	14, 15, 16, 17,		/* squares 9 10 11 12 */
-	19, 20, 21, 22,		/* squares 13, 14, 15 16 */
-	23, 24, 25, 26,		/* squares 17, 18, 19 20 */
-	28, 29, 30, 31,		/* squares 21, 22, 23 24 */
-	32, 33, 34, 35,		/* squares 25, 26, 27 28 */
-	37, 38, 39, 40		/* squares 29, 30, 31 32 */
-};
-
-/*
- * Return the 1-32 square number corresponding to a board46 index.
- */
-int index46_to_square(int index46)
-{
-	int square;
-
-	square = index46 - (index46 / 9);
-	square -= 4;
-	return(square + 1);
-}
-
+#define PERFT_GAMETYPE GT_ITALIAN
 #else
-
-static int sqmap[] = {
-	 0,
-	 8,  7,  6,  5,		/* squares 1 2 3 4 */
-	13, 12, 11, 10,		/* squares 5 6 7 8 */
-	17, 16, 15, 14,		/* squares 9 10 11 12 */
-	22, 21, 20, 19,		/* squares 13, 14, 15 16 */
-	26, 25, 24, 23,		/* squares 17, 18, 19 20 */
-	31, 30, 29, 28,		/* squares 21, 22, 23 24 */
-	35, 34, 33, 32,		/* squares 25, 26, 27 28 */
-	40, 39, 38, 37		/* squares 29, 30, 31 32 */
-};
+#define PERFT_GAMETYPE GT_ENGLISH
+#endif
 
 /*
  * Return the 1-32 square number corresponding to a board46 index.
  */
 int index46_to_square(int index46)
 {
-	int square, offset;
-
-	square = index46 - (index46 / 9);
-	square -= 5;
-	offset = square % 4;
-	square -= offset;
-	offset = 3 - offset;
-	square += offset;
-	return(square + 1);
+	return(squaremap<PERFT_GAMETYPE>().number46[index46]);
 }
-#endif
 
 /*
  * Return the board46 index corresponding to a 1-32 square number.
  */
 int square_to_index46(int square)
 {
-	return(sqmap[square]);
+	return(squaremap<PERFT_GAMETYPE>().index46[square]);
 }
 
 
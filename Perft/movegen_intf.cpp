@@ -0,0 +1,213 @@
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "cb_interface.h"
+#include "bitboard.h"
+#include "CB_movegen.h"		/* the app's MAXMOVES, which is not the one of the engines */
+#include "movegen_intf.h"
+
+/*
+ * Perft with the move generator of CheckerBoard in CB_movegen.c, for the game types that have
+ * no engine in this project. It has a file of its own because the movelists of the app are
+ * longer than those of the engines. Positions are CheckerBoard bitboards, the FEN strings use
+ * the square numbers of the game type.
+ */
+
+int app_parse_fen(char *buf, int gametype, pos *p, int *ret_color)
+{
+	int square, square2, s;
+	int color, king;
+	char *lastp;
+	uint32_t bit;
+	const CBsquaremap *map = get_squaremap(gametype);
+
+	if (*buf == '"')
+		++buf;
+
+	/* Get the color. */
+	if (toupper(*buf) == 'B')
+		*ret_color = CB_BLACK;
+	else if (toupper(*buf) == 'W')
+		*ret_color = CB_WHITE;
+	else {
+		printf("Bad color in app_parse_fen()\n");
+		return(1);
+	}
+
+	memset(p, 0, sizeof(*p));
+
+	++buf;
+	lastp = buf;
+	if (*buf != ':') {
+		printf("Missing ':' in app_parse_fen()\n");
+		return(1);
+	}
+
+	while (*buf) {
+		if (*buf == ':') {
+			++buf;
+			if (toupper(*buf) == 'W')
+				color = CB_WHITE;
+			else if (toupper(*buf) == 'B')
+				color = CB_BLACK;
+			else
+				return(1);
+			++buf;
+		}
+		king = 0;
+		if (toupper(*buf) == 'K') {
+			king = 1;
+			++buf;
+		}
+		for (square = 0; isdigit(*buf); ++buf)
+			square = 10 * square + (*buf - '0');
+
+		/* Check for range of square numbers. */
+		square2 = square;
+		if (*buf == '-' && isdigit(buf[1])) {
+			++buf;
+			for (square2 = 0; isdigit(*buf); ++buf)
+				square2 = 10 * square2 + (*buf - '0');
+		}
+
+		if (square && square <= square2 && square2 <= 32) {
+			for (s = square; s <= square2; ++s) {
+				bit = 1u << map->bit[s];
+				if (color == CB_BLACK) {
+					if (king)
+						p->bk |= bit;
+					else
+						p->bm |= bit;
+				}
+				else {
+					if (king)
+						p->wk |= bit;
+					else
+						p->wm |= bit;
+				}
+			}
+		}
+		if (*buf == ',')
+			++buf;
+
+		/* If we didn't advance in buf, we're done. */
+		if (lastp == buf)
+			break;
+		lastp = buf;
+	}
+	return(0);
+}
+
+
+int app_print_fen_pieces(uint32_t men, uint32_t kings, int color, int gametype, char *buf)
+{
+	int len, sq;
+	const char *comma;
+	const CBsquaremap *map = get_squaremap(gametype);
+
+	comma = "";
+	len = sprintf(buf, color == CB_BLACK ? ":B" : ":W");
+	for (sq = 1; sq <= 32; ++sq) {
+		if (kings & (1u << map->bit[sq])) {
+			len += sprintf(buf + len, "%sK%d", comma, sq);
+			comma = ",";
+		}
+		else if (men & (1u << map->bit[sq])) {
+			len += sprintf(buf + len, "%s%d", comma, sq);
+			comma = ",";
+		}
+	}
+	return(len);
+}
+
+
+void app_print_fen(pos *p, int color, int gametype, char *buf)
+{
+	int len;
+
+	len = sprintf(buf, "%c", color == CB_BLACK ? 'B' : 'W');
+	len += app_print_fen_pieces(p->bm, p->bk, CB_BLACK, gametype, buf + len);
+	len += app_print_fen_pieces(p->wm, p->wk, CB_WHITE, gametype, buf + len);
+}
+
+
+void app_domove(pos *p, Cmove &move, int color)
+{
+	uint32_t from, to;
+
+	from = 1u << cmovefrom(move);
+	to = 1u << cmoveto(move);
+	if (color == CB_BLACK) {
+		p->bm &= ~from;
+		p->bk &= ~from;
+		p->wm &= ~move.captures;
+		p->wk &= ~move.captures;
+		if (cmovenewpiece(move) & CB_KING)
+			p->bk |= to;
+		else
+			p->bm |= to;
+	}
+	else {
+		p->wm &= ~from;
+		p->wk &= ~from;
+		p->bm &= ~move.captures;
+		p->bk &= ~move.captures;
+		if (cmovenewpiece(move) & CB_KING)
+			p->wk |= to;
+		else
+			p->wm |= to;
+	}
+}
+
+
+/*
+ * Count the leaf nodes depth plies below p. At depth 1 the moves are counted without
+ * making them.
+ */
+INT64 app_perft(pos *p, int color, int depth, int gametype)
+{
+	int nmoves, i, isjump;
+	INT64 sumnodes;
+	pos next;
+	Cmove movelist[MAXMOVES];
+
+	nmoves = bitboardmovelist(color, movelist, p, &isjump, gametype);
+	if (depth == 1)
+		return(nmoves);
+
+	sumnodes = 0;
+	for (i = 0; i < nmoves; ++i) {
+		next = *p;
+		app_domove(&next, movelist[i], color);
+		sumnodes += app_perft(&next, CB_CHANGECOLOR(color), depth - 1, gametype);
+	}
+	return(sumnodes);
+}
+
+
+/*
+ * Print the first successor positions of p with the node counts depth - 1 plies below them,
+ * and return the nodes at depth below p.
+ */
+INT64 app_print_divide(pos *p, int color, int depth, int gametype)
+{
+	int nmoves, i, isjump;
+	INT64 nodes, sumnodes;
+	char fenbuf[150];
+	pos next;
+	Cmove movelist[MAXMOVES];
+
+	sumnodes = 0;
+	nmoves = bitboardmovelist(color, movelist, p, &isjump, gametype);
+	for (i = 0; i < nmoves; ++i) {
+		next = *p;
+		app_domove(&next, movelist[i], color);
+		nodes = depth > 1 ? app_perft(&next, CB_CHANGECOLOR(color), depth - 1, gametype) : 1;
+		app_print_fen(&next, CB_CHANGECOLOR(color), gametype, fenbuf);
+		printf("%s; nodes %I64d\n", fenbuf, nodes);
+		sumnodes += nodes;
+	}
+	return(sumnodes);
+}
@@ -0,0 +1,5 @@
+int app_parse_fen(char *fenstr, int gametype, pos *p, int *color);
+void app_print_fen(pos *p, int color, int gametype, char *fenbuf);
+INT64 app_perft(pos *p, int color, int depth, int gametype);
+INT64 app_print_divide(pos *p, int color, int depth, int gametype);
+int builtinmovelist(int gametype);		/* in CB_movegen.c */
@@ -214,3 +214,83 @@ void boardtobitboard(Board8x8 b, pos *position)
 		}
 	}
 }
+
+static int isbetween(coor from, coor to, coor c)
+{
+	// returns 1 if c is on the diagonal from 'from' to 'to', strictly between them
+	if (from.x - to.x != from.y - to.y && from.x - to.x != to.y - from.y)
+		return(0);
+	if (c.x - from.x != c.y - from.y && c.x - from.x != from.y - c.y)
+		return(0);
+	if (c.x == from.x || c.x == to.x)
+		return(0);
+	return((c.x - from.x > 0) == (to.x - c.x > 0) && (c.y - from.y > 0) == (to.y - c.y > 0));
+}
+
+void cbmovetocmove(CBmove *cbmove, Cmove *move)
+{
+	// converts a CBmove, from an engine or the GUI, to a compact move. not every engine
+	// fills in the intermediate path squares, so where path[] does not make sense the
+	// piece is assumed to land right behind the captured piece.
+	int i;
+	coor c, previous;
+
+	move->path = 0;
+	move->captures = 0;
+	move->kings = 0;
+	cmovesetsquare(*move, 0, coortosquare(cbmove->from));
+	if (cbmove->jumps == 0)
+		cmovesetsquare(*move, 1, coortosquare(cbmove->to));
+	previous = cbmove->from;
+	for (i = 0; i < cbmove->jumps && i < CMOVE_MAXLANDINGS; i++) {
+		if (i == cbmove->jumps - 1)
+			c = cbmove->to;
+		else {
+			c = cbmove->path[i + 1];
+			if (c.x < 0 || c.x > 7 || c.y < 0 || c.y > 7 || !isbetween(previous, c, cbmove->del[i])) {
+				c.x = cbmove->del[i].x + ((cbmove->del[i].x > previous.x) ? 1 : -1);
+				c.y = cbmove->del[i].y + ((cbmove->del[i].y > previous.y) ? 1 : -1);
+			}
+		}
+		previous = c;
+		cmovesetsquare(*move, i + 1, coortosquare(c));
+		move->captures |= 1 << coortosquare(cbmove->del[i]);
+		if (cbmove->delpiece[i] & CB_KING)
+			move->kings |= 1 << coortosquare(cbmove->del[i]);
+	}
+	cmovesetpieces(*move, cbmove->oldpiece, cbmove->newpiece);
+}
+
+void cmovetocbmove(Cmove *move, CBmove *cbmove)
+{
+	// expands a compact move to a CBmove. the captured piece of each jump is the one
+	// on the diagonal between two landing squares; this also holds for long jumps.
+	int i, dx, dy, square, color;
+	coor c, next;
+
+	color = cmoveoldpiece(*move) & (CB_BLACK | CB_WHITE);
+	cbmove->jumps = cmovejumps(*move);
+	cbmove->oldpiece = cmoveoldpiece(*move);
+	cbmove->newpiece = cmovenewpiece(*move);
+	cbmove->from = squaretocoor(cmovefrom(*move));
+	cbmove->to = squaretocoor(cmoveto(*move));
+	cbmove->path[0] = cbmove->from;
+	if (cbmove->jumps == 0)
+		cbmove->path[1] = cbmove->to;
+	for (i = 0; i < cbmove->jumps; i++) {
+		c = cbmove->path[i];
+		next = squaretocoor(cmovesquare(*move, i + 1));
+		cbmove->path[i + 1] = next;
+		dx = (next.x > c.x) ? 1 : -1;
+		dy = (next.y > c.y) ? 1 : -1;
+		for (c.x += dx, c.y += dy; c.x != next.x; c.x += dx, c.y += dy) {
+			square = coortosquare(c);
+			if (move->captures & (1 << square)) {
+				cbmove->del[i] = c;
+				cbmove->delpiece[i] = CB_CHANGECOLOR(color) | ((move->kings & (1 << square)) ? CB_KING : CB_MAN);
+				break;
+			}
+		}
+	}
+	cbmove->del[cbmove->jumps].x = -1;
+}
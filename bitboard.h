@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <intrin.h>
 #include "cb_interface.h"
 
 
@@ -13,3 +14,93 @@ struct pos {
 void boardtobitboard(Board8x8 board, pos *position);
 void boardtocrbitboard(Board8x8 board, pos *position);
 void bitboardtoboard8(pos *p, Board8x8 board);
+
+/*
+ * Compact move, 16 bytes instead of the 300 of a CBmove. The built-in move generator produces it,
+ * legality matching works on it and games store it; a CBmove is only built from it with cmovetocbmove()
+ * where an engine or the GUI needs one.
+ * Squares are bit numbers as in pos, 4 * y + x / 2 on the 8x8 board, which is the same for all game types.
+ * path holds the from square in bits 0-4 and then every landing square in order, 5 bits each, the last
+ * one being the to square. Bits 60-61 are the color of the mover, bit 62 is set if it was a king and
+ * bit 63 if it is a king after the move.
+ */
+struct Cmove {
+	uint64_t path;
+	uint32_t captures;		/* squares of the captured pieces. */
+	uint32_t kings;			/* the captured pieces that were kings. */
+};
+
+#define CMOVE_MAXLANDINGS 11
+#define CMOVE_SQUAREBITS ((((uint64_t)1) << (5 * (CMOVE_MAXLANDINGS + 1))) - 1)
+
+inline int cmovejumps(const Cmove &m)
+{
+	return(__popcnt(m.captures));
+}
+
+/* Square i of the path: 0 is the from square, 1..jumps the landing squares (1 is the to square of a non-capture). */
+inline int cmovesquare(const Cmove &m, int i)
+{
+	return((int)(m.path >> (5 * i)) & 31);
+}
+
+inline int cmovefrom(const Cmove &m)
+{
+	return(cmovesquare(m, 0));
+}
+
+inline int cmoveto(const Cmove &m)
+{
+	int jumps = cmovejumps(m);
+
+	return(cmovesquare(m, jumps ? jumps : 1));
+}
+
+inline int cmoveoldpiece(const Cmove &m)
+{
+	return(((int)(m.path >> 60) & 3) | ((m.path >> 62) & 1 ? CB_KING : CB_MAN));
+}
+
+inline int cmovenewpiece(const Cmove &m)
+{
+	return(((int)(m.path >> 60) & 3) | ((m.path >> 63) & 1 ? CB_KING : CB_MAN));
+}
+
+inline void cmovesetsquare(Cmove &m, int i, int square)
+{
+	m.path = (m.path & ~(((uint64_t)31) << (5 * i))) | (((uint64_t)square) << (5 * i));
+}
+
+inline void cmovesetpieces(Cmove &m, int oldpiece, int newpiece)
+{
+	m.path &= CMOVE_SQUAREBITS;
+	m.path |= ((uint64_t)(oldpiece & (CB_BLACK | CB_WHITE))) << 60;
+	if (oldpiece & CB_KING)
+		m.path |= ((uint64_t)1) << 62;
+	if (newpiece & CB_KING)
+		m.path |= ((uint64_t)1) << 63;
+}
+
+/* Convert between bitboard square numbers and 8x8 board coordinates. */
+inline coor squaretocoor(int square)
+{
+	coor c;
+
+	c.x = 2 * (square & 3) + ((square >> 2) & 1);
+	c.y = square >> 2;
+	return(c);
+}
+
+inline int coortosquare(coor c)
+{
+	return(4 * c.y + c.x / 2);
+}
+
+/* Square number (1..32) of square in the numbering of gametype. */
+inline int squaretonumber(int square, int gametype)
+{
+	return(get_squaremap(gametype)->bitnumber[square]);
+}
+
+void cbmovetocmove(CBmove *cbmove, Cmove *move);
+void cmovetocbmove(Cmove *move, CBmove *cbmove);
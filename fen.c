@@ -40,6 +40,7 @@ int FENtoboard8(Board8x8 board, const char *buf, int *poscolor, int gametype)
 	int color, piece_type;
 	int i, j;
 	const char *lastp;
+	const CBsquaremap *map = get_squaremap(gametype);
 
 	/* Allow possible extraneous stuff at the beginning, since it is used by the clipboard paste handler. */
 	lastp = strchr(buf, ':');
@@ -103,9 +104,10 @@ int FENtoboard8(Board8x8 board, const char *buf, int *poscolor, int gametype)
 		}
 
 
-		if (square && square <= square2) {
+		if (square && square <= square2 && square2 <= 32) {
 			for (s = square; s <= square2; ++s) {
-				numbertocoors(s, &i, &j, gametype);
+				i = map->coors[s].x;
+				j = map->coors[s].y;
 				board[i][j] = piece_type | color;
 			}
 		}
@@ -125,6 +127,7 @@ int FENtoboard8(Board8x8 board, const char *buf, int *poscolor, int gametype)
 void board8toFEN(const Board8x8 board, std::string &fenstr, int color, int gametype)
 {
 	int i, j, square;
+	const CBsquaremap *map = get_squaremap(gametype);
 
 	fenstr = color == CB_BLACK ? "B" : "W";
 
@@ -132,7 +135,7 @@ void board8toFEN(const Board8x8 board, std::string &fenstr, int color, int gamet
 	fenstr += ":W";
 	for (j = 0; j <= 7; j++) {
 		for (i = 7; i >= 0; i--) {
-			square = coorstonumber(i, j, gametype);
+			square = map->number[i][j];
 			if (board[i][j] == (CB_WHITE | CB_MAN))
 				fenstr += std::to_string(square) + ",";
 			if (board[i][j] == (CB_WHITE | CB_KING))
@@ -148,7 +151,7 @@ void board8toFEN(const Board8x8 board, std::string &fenstr, int color, int gamet
 	fenstr += ":B";
 	for (j = 0; j <= 7; j++) {
 		for (i = 7; i >= 0; i--) {
-			square = coorstonumber(i, j, gametype);
+			square = map->number[i][j];
 			if (board[i][j] == (CB_BLACK | CB_MAN))
 				fenstr += std::to_string(square) + ",";
 			if (board[i][j] == (CB_BLACK | CB_KING))
@@ -25,6 +25,16 @@
 #define CB_REGISTRY_NAME	"Software\\Martin Fierz\\CheckerBoard\\"
 #endif
 
+/*
+ * Return the crc of options. It is calculated on the whole struct with the size and version of
+ * CBoptions in the crc field, so that options saved with another layout do not match.
+ */
+static unsigned int options_crc(CBoptions *options)
+{
+	options->crc = sizeof(CBoptions) | (CBOPTIONS_VERSION << 16);
+	return(crc_calc((char *)options, sizeof(CBoptions)));
+}
+
 // VERSION will be appended to this name
 void savesettings(CBoptions *options)
 {
@@ -40,8 +50,7 @@ void savesettings(CBoptions *options)
 	RegCreateKeyEx(HKEY_CURRENT_USER, subkey, 0, "CB_Key", 0, KEY_WRITE, NULL, &hKey, &result);
 
 	// save options struct
-	options->crc = sizeof(CBoptions);
-	options->crc = crc_calc((char *)options, sizeof(CBoptions));
+	options->crc = options_crc(options);
 	RegSetValueEx(hKey, "options structure", 0, REG_BINARY, (LPBYTE) options, sizeof(CBoptions));
 
 	// close registry
@@ -123,12 +132,9 @@ void loadsettings(CBoptions *options, char CBdirectory[256])
 			defaultvalues = 1;	// could not read options - use defaults again.
 		else {
 
-			/* Verify the crc.
-			 * CRC is calculated on the whole struct using its size in the crc field.
- 			 */
+			/* Verify the crc. */
 			reg_crc = options->crc;
-			options->crc = sizeof(CBoptions);
-			options->crc = crc_calc((char *)options, sizeof(CBoptions));
+			options->crc = options_crc(options);
 			if (options->crc != reg_crc)
 				defaultvalues = 1;
 		}
@@ -151,6 +157,7 @@ void loadsettings(CBoptions *options, char CBdirectory[256])
 		options->highlight = 0;
 		options->invert = 0;
 		options->exact_time = false;
+		options->ponder = false;
 		options->use_incremental_time = false;
 		options->early_game_adjudication = true;
 		options->em_start_positions = START_POS_3MOVE;
@@ -9,6 +9,7 @@
 #include "cb_interface.h"
 #include "CBstructs.h"
 #include "CBconsts.h"
+#include "lsb.h"
 #include "saveashtml.h"
 #include "utility.h"
 #include "fen.h"
@@ -41,19 +42,21 @@ int saveashtml(char *filename, PDNgame *game)
 		changes[i] = 0;
 
 	for (movei = 0; movei < (int)game->moves.size(); ++movei) {
+		Cmove &move = game->moves[movei].move;
+		uint32_t captures;
 
 		// number of changes
-		changes[movenumber] = game->moves[movei].move.jumps + 2;
+		changes[movenumber] = cmovejumps(move) + 2;
 
 		// squares the changes occur on
-		square[movenumber][0] = coortohtml(game->moves[movei].move.from, game->gametype);
-		square[movenumber][1] = coortohtml(game->moves[movei].move.to, game->gametype);
-		for (i = 2; i < changes[movenumber]; i++)
-			square[movenumber][i] = coortohtml(game->moves[movei].move.del[i - 2], game->gametype);
+		square[movenumber][0] = coortohtml(squaretocoor(cmovefrom(move)), game->gametype);
+		square[movenumber][1] = coortohtml(squaretocoor(cmoveto(move)), game->gametype);
+		for (i = 2, captures = move.captures; captures; i++, captures &= captures - 1)
+			square[movenumber][i] = coortohtml(squaretocoor(LSB(captures)), game->gametype);
 
 		// pieces to put on these squares
 		changeto[movenumber][0] = 0;
-		changeto[movenumber][1] = game->moves[movei].move.newpiece;
+		changeto[movenumber][1] = cmovenewpiece(move);
 		for (i = 2; i < changes[movenumber]; i++)
 			changeto[movenumber][i] = 0;
 
@@ -43,6 +43,13 @@
  */
 #define CB_INCR_TIME_SHIFT 2
 
+/* Bit 4 of 'info' asks the engine to ponder. board and color are the position after the engine's
+ * own move, with the opponent to move. The engine guesses the opponent's reply and searches the
+ * resulting position until *playnow is set. It does not change the board and returns CB_UNKNOWN.
+ * An engine that supports pondering replies "1" to enginecommand "get ponder".
+ */
+#define CB_PONDER 16
+
 /* gametype definitions for response to enginecommand "get gametype". */
 #define GT_ENGLISH 21
 #define GT_ITALIAN 22
@@ -79,6 +86,13 @@ typedef unsigned int (WINAPI *CB_GETGAMETYPE)(void);	/* return GT_ENGLISH, GT_IT
 typedef INT (WINAPI *CB_ISLEGAL)(Board8x8 board, int color, int from, int to, CBmove *move);
 typedef INT (WINAPI *CB_ENGINECOMMAND)(char command[256], char reply[ENGINECOMMAND_REPLY_SIZE]);
 
+/*
+ * Optional export "getmovelist": fill movelist with the legal moves of color on board and return
+ * their number. Return -1 if there are more than maxmoves of them or the engine cannot generate them;
+ * CheckerBoard then falls back to the "get movelist" engine command.
+ */
+typedef INT (WINAPI *CB_GETMOVELIST)(Board8x8 board, int color, CBmove movelist[], int maxmoves);
+
 
 /*
  * If incremental time control is enabled, extract the increment and remaining times that are
@@ -99,88 +113,122 @@ inline bool get_incremental_times(int info, int moreinfo, double *increment, dou
 	return(true);
 }
 
-/* 
- * Given a square number (1..32), return the x,y coordinates for a Board8x8.
+/*
+ * Give the x,y coordinates of a dark square of a Board8x8, return its square number (1..32)
+ * for gametype. All other lookups between square numbers and coordinates are generated from this.
  */
-inline void numbertocoors(int number, int *x, int *y, int gametype)
+constexpr int squarenumber(int x, int y, int gametype)
 {
 	switch (gametype) {
 	case GT_ITALIAN:
-		number--;						// number e 0...31
-		*y = number / 4;				// *y e 0...7
-		*x = 2 * ((number % 4));		// *x e {0,2,4,6}
-		if (((*y) % 2))					// adjust x on odd rows
-			(*x)++;
-		break;
+		return(1 + 4 * y + x / 2);
 
 	case GT_SPANISH:
-		number--;
-		*y = number / 4;
-		*y = 7 - *y;
-		*x = 2 * (3 - (number % 4));	// *x e {0,2,4,6}
-		if (((*y) % 2))					// adjust x on odd rows
-			(*x)++;
-		break;
-
-	case GT_CZECH:						// TODO: check that this is correct!
-		number--;						// number e 0...31
-		number = 33 - number;
-		*y = number / 4;				// *y e 0...7
-		*x = 2 * ((number % 4));		// *x e {0,2,4,6}
-		if (((*y) % 2))					// adjust x on odd rows
-			(*x)++;
-		break;
+		return(1 + 4 * (7 - y) + (7 - x) / 2);
+
+	case GT_CZECH:
+		// 1 is a1 in the left corner of white, who starts on 1-12, and the squares are
+		// numbered along the rows towards black.
+		return(32 - 4 * y - x / 2);
 
 	default:
-		number--;
-		*y = number / 4;
-		*x = 2 * (3 - number % 4);
-		if ((*y) % 2)
-			(*x)++;
+		return(4 * (y + 1) - x / 2);
 	}
 }
 
-inline void numbertocoors(int number, coor *c, int gametype)
+/*
+ * Lookup tables between the square numbers of a game type and the other names of the same
+ * square: its Board8x8 coordinates, its bit 4 * y + x / 2 in CheckerBoard's bitboards, and its
+ * index in the board[46] arrays of the engines. Entries of light squares, of index 0 of the
+ * square number arrays and of the unused board[46] indices are 0.
+ */
+struct CBsquaremap {
+	coor coors[33];			/* coordinates of square number 1..32. */
+	int number[8][8];		/* square number of board[x][y]. */
+	int bit[33];			/* bitboard bit of a square number. */
+	int bitnumber[32];		/* square number of a bitboard bit. */
+	int index46[33];		/* board[46] index of a square number. */
+	int number46[46];		/* square number of a board[46] index. */
+};
+
+constexpr CBsquaremap make_squaremap(int gametype)
 {
-	numbertocoors(number, &c->x, &c->y, gametype);
+	CBsquaremap map = {};
+
+	for (int y = 0; y < 8; ++y) {
+		for (int x = y & 1; x < 8; x += 2) {
+			int number = squarenumber(x, y, gametype);
+			int bit = 4 * y + x / 2;
+			int index46 = 5 + bit + (y + 1) / 2;
+
+			map.coors[number].x = x;
+			map.coors[number].y = y;
+			map.number[x][y] = number;
+			map.bit[number] = bit;
+			map.bitnumber[bit] = number;
+			map.index46[number] = index46;
+			map.number46[index46] = number;
+		}
+	}
+	return(map);
 }
 
 /*
- * Give the x,y coordinates for a Board8x8, return the square number (1..32).
+ * The tables of a game type, built at compile time. Use squaremap<GT_ITALIAN>() where the game
+ * type is fixed, or get_squaremap() once outside a loop where it is not.
  */
-inline int coorstonumber(int x, int y, int gametype)
+template <int GAMETYPE> inline const CBsquaremap &squaremap()
 {
-	int number;
+	static constexpr CBsquaremap map = make_squaremap(GAMETYPE);
+
+	return(map);
+}
 
+inline const CBsquaremap *get_squaremap(int gametype)
+{
 	switch (gametype) {
 	case GT_ITALIAN:
-		// italian rules
-		number = 1;
-		number += 4 * y;
-		number += x / 2;
-		break;
+		return(&squaremap<GT_ITALIAN>());
 
 	case GT_SPANISH:
-		// spanish rules
-		number = 1;
-		number += 4 * (7 - y);
-		number += (7 - x) / 2;
-		break;
+		return(&squaremap<GT_SPANISH>());
 
 	case GT_CZECH:
-		// TODO: make sure this is correct for czech rules
-		number = 1;
-		number += 4 * y;
-		number += x / 2;
-		number = 33 - number;
-		break;
+		return(&squaremap<GT_CZECH>());
 
 	default:
-		number = 0;
-		number += 4 * (y + 1);
-		number -= x / 2;
+		return(&squaremap<GT_ENGLISH>());
 	}
+}
+
+/* 
+ * Given a square number (1..32), return the x,y coordinates for a Board8x8.
+ * x and y are not changed if number is not a square.
+ */
+inline void numbertocoors(int number, int *x, int *y, int gametype)
+{
+	const CBsquaremap *map;
+
+	if (number < 1 || number > 32)
+		return;
+	map = get_squaremap(gametype);
+	*x = map->coors[number].x;
+	*y = map->coors[number].y;
+}
 
-	return number;
+inline void numbertocoors(int number, coor *c, int gametype)
+{
+	numbertocoors(number, &c->x, &c->y, gametype);
+}
+
+/*
+ * Give the x,y coordinates for a Board8x8, return the square number (1..32).
+ * Coordinates off the board are numbered by the formula of squarenumber(), as before the tables.
+ */
+inline int coorstonumber(int x, int y, int gametype)
+{
+	if (x < 0 || x > 7 || y < 0 || y > 7)
+		return(squarenumber(x, y, gametype));
+	return(get_squaremap(gametype)->number[x][y]);
 }
 
@@ -66,6 +66,7 @@
 #include <ShlObj.h>
 #include <Shlwapi.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <windows.h>
@@ -84,12 +85,39 @@
 #define FREE 16
 
 #define MAXDEPTH 99
+#define MAXPLY 128				/* maximum search ply including capture extensions. */
+
+/* hashtable entry bound types */
+#define HASH_EXACT 1
+#define HASH_LOWER 2			/* value is a lower bound, the search failed high. */
+#define HASH_UPPER 3			/* value is an upper bound, the search failed low. */
+
+#define DEFAULT_HASHSIZE_MB 32
+#define NO_MOVE 255
+
+/* fields of the data word of a hashtable entry */
+#define HASHVALUE(data) ((short)((data) & 0xffff))
+#define HASHDEPTH(data) ((int)(((data) >> 16) & 0xff))
+#define HASHBOUND(data) ((int)(((data) >> 24) & 0xff))
+#define HASHBEST(data) ((int)(((data) >> 32) & 0xff))
+#define HASHSEARCHID(data) ((unsigned char)((data) >> 40))
+
+#define MAXTHREADS 64
+#define ASPIRATIONWINDOW 20		/* a fifth of a man. */
+#define MAXMULTIPV 10			/* most best moves that set multipv can ask for. */
+#define PONDERGUESSTIME 0.1		/* seconds to find the opponent's reply if the last search did not expect this position. */
+#define MAXGAMEPLY 1024			/* positions of the game kept for the repetition detection. */
+#define KEYCOUNTSLOTS 1024		/* size of the keycount[] filter of the key stack, a power of 2. */
+#define NUMBENCHPOSITIONS 8
+#define BENCHDEPTH 15			/* depth of the bench command if it has none. */
 
 /*----------> compile options  */
 #undef MUTE
 #undef VERBOSE
 #define STATISTICS
 #define LOG_TIME_MGMT
+#define LOGNAME "Dama"			/* the time management log is Dama.log in the folder Dama. */
+#undef CHECKEVAL				/* compare the incremental evaluation terms with a full recomputation at every leaf */
 
 /*----------> function prototypes  */
 
@@ -117,76 +145,172 @@ int WINAPI islegal(Board8x8 board, int color, int from, int to, CBmove *move);
 void movetonotation(move2 move, char str[80]);
 
 /*----------> part II: search */
-int checkers(int b[46], int color, double maxtime, char *str);
-int alphabeta(int b[46], int depth, int alpha, int beta, int color);
-int firstalphabeta(int b[46], int depth, int alpha, int beta, int color, move2 *best);
+struct SEARCHTHREAD;
+void setthreadposition(SEARCHTHREAD *t, int b[46], int color);
+void addgameposition(int b[46], int color);
+void tomove2(move2 &move, int color, move2 *m);
 void domove(int b[46], move2 &move);
 void undomove(int b[46], move2 &move);
-int evaluation(int b[46], int color);
+void domove(SEARCHTHREAD *t, move2 &move);
+void undomove(SEARCHTHREAD *t, move2 &move);
+void initevaluation(void);
+void evalterms(int b[46], int count[17], int *psq, int *tempo);
+int evaluation(SEARCHTHREAD *t, int color);
+uint64_t hashposition(int b[46], int color);
+int samemove(move2 &a, move2 &b);
 
 /*----------> part III: move generation */
 int generatemovelist(int b[46], move2 movelist[MAXMOVES], int color);
 int generatecapturelist(int b[46], move2 movelist[MAXMOVES], int color);
-void blackmancapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-void blackkingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-void whitemancapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-void whitekingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-int testcapture(int b[46], int color);
+int testcapture(SEARCHTHREAD *t, int color);
+int generatemovelist(SEARCHTHREAD *t, move2 movelist[MAXMOVES], int color);
+int generatecapturelist(SEARCHTHREAD *t, move2 movelist[MAXMOVES], int color);
+int &historyentry(SEARCHTHREAD *t, move2 &move, int color);
 
 void setbestmove(move2 move);
 coor numbertocoor(int squarenumber);
 
-/*----------> globals  */
+typedef move2 SEARCHMOVE;			/* the move type of the search in searchcore.h. */
+
+/*----------> structs  */
+struct HASHENTRY {
+	uint64_t check;			/* zobrist key xor data. */
+	uint64_t data;			/* value, depth, bound, best move index and search id, see HASHVALUE() etc. */
+};
+
+/* the state of one search thread. all threads search the same root position and
+   share nothing but the hashtable. thread 0 is the main thread, it checks the
+   time and its result is played. */
+struct SEARCHTHREAD {
+	int b[46];
+	int color;
+	int id;
+	uint64_t hashkey;				/* key of the current search position, updated by domove() and undomove(). */
+	int64_t alphabetas;
+	int64_t qnodes;					/* nodes of the quiescence search, not counted in alphabetas. */
+	int maxqdepth;					/* longest capture sequence searched by the quiescence search. */
+	int64_t hashprobes, hashhits;	/* lookups, and lookups that found the position. */
 #ifdef STATISTICS
-int generatemovelists, evaluations, generatecapturelists, testcaptures;
+	int64_t generatemovelists, evaluations, generatecapturelists, testcaptures;
+	int64_t failhighs, failhighsfirst;	/* beta cutoffs, and beta cutoffs by the first move searched. */
+	int64_t pvssearches, pvsresearches;	/* null window searches, and how many of them had to be searched again. */
+	int aspresearches;				/* root searches repeated because the value was outside the aspiration window. */
+	int64_t dbhits;					/* always 0, there is no endgame database. */
+#endif
+
+	/* the evaluation terms that are sums over the pieces, kept up to date by domove()
+	   and undomove(). see evalterms(). */
+	int count[17];					/* number of pieces, indexed by piece code. */
+	int psq;						/* center and edge terms. */
+	int tempo;
+#ifdef CHECKEVAL
+	int evalerrors;					/* leaves where the terms differed from a full recomputation. */
 #endif
-int alphabetas;
+
+	/* move ordering: the principal variation of the last iteration is searched first,
+	   then the hashtable move, then two killer moves per ply, then the other moves
+	   sorted by the history table. */
+	move2 pv[MAXPLY][MAXPLY];		/* triangular pv table, pv[ply][ply..] is the pv from ply. */
+	int pvlength[MAXPLY];
+	move2 lastpv[MAXPLY];			/* pv of the last completed iteration. */
+	int lastpvlength;
+	int followpv;					/* nonzero while the search is on the path of lastpv. */
+	move2 killers[MAXPLY][2];
+	int history[2][46][46];			/* indexed by color - 1, from square, to square. */
+
+	/* multipv: the root moves sorted by their values in the last completed iteration,
+	   the first multipv values are exact. see multipvsearch(). */
+	move2 rootmoves[MAXMOVES];
+	int rootvalues[MAXMOVES];
+	int numrootmoves;
+
+	/* repetition detection: the keys of the game since its last irreversible move
+	   and of the search path. see repetition(). */
+	uint64_t keys[MAXGAMEPLY + MAXPLY];
+	int reversible[MAXGAMEPLY + MAXPLY];	/* number of reversible moves that led to keys[i]. */
+	int numkeys;
+	unsigned short keycount[KEYCOUNTSLOTS];
+};
+
+/* the totals of all search threads when an iteration of checkers() was completed,
+   get stats reports them. */
+struct ITERATIONSTATS {
+	int depth;
+	int64_t nodes;
+	int64_t qnodes;
+	int64_t hashprobes;
+	int64_t hashhits;
+	double time;					/* seconds since the start of the search. */
+};
+
+/*----------> globals  */
 int value[17] = { 0, 0, 0, 0, 0, 1, 256, 0, 0, 16, 4096, 0, 0, 0, 0, 0, 0 };
 int *play;
 CBmove GCBmove;
-clock_t starttime;
+LARGE_INTEGER starttime;			/* the search time is wall clock time from QueryPerformanceCounter(). */
+double counterfrequency;
 double absolute_maxtime;
 
+/* zobrist keys, indexed by board46 square and piece code. */
+uint64_t zobrist[46][17];
+uint64_t zobrist_color;
+
+/* piece-square tables of the evaluation terms kept by domove(), indexed by piece
+   code and board46 square. set up by initevaluation(). */
+int psqvalue[17][46];
+int tempovalue[17][46];
+
+/* the hashtable is shared by all search threads without locking. an entry is only
+   used if check ^ data is the key of the position, so that an entry torn by two
+   threads writing it at the same time is not found. */
+HASHENTRY *hashtable;
+uint32_t hashmask;
+int hashsize_MB = DEFAULT_HASHSIZE_MB;
+unsigned char searchid;
+
+SEARCHTHREAD *threads[MAXTHREADS];
+int numthreads = 1;
+int multipv = 1;					/* number of best moves with exact values, see multipvsearch(). */
+volatile int stopsearch;			/* set by the main thread to stop the helper threads. */
+ITERATIONSTATS iterationstats[MAXDEPTH + 1];	/* the iterations of the last search. */
+int numiterations;
+
+/* pondering: checkers() remembers the reply it expects to its move, ponder() remembers
+   the position it searched. if the next search is of that position, it is a ponder hit
+   and keeps the hashtable entries, killers and history of the ponder search. */
+uint64_t expectedkey;				/* key of the position after the move of the last search, 0 if none. */
+move2 expectedreply;
+uint64_t ponderkey;					/* key of the position of the last ponder search, 0 if none. */
+int ponderhit;
+
+/* the game history: the keys of the positions that CheckerBoard sent and that the
+   engine played since CB_RESET_MOVES, for the repetition detection. */
+uint64_t gamekeys[MAXGAMEPLY];
+int gamereversible[MAXGAMEPLY];		/* number of reversible moves that led to gamekeys[i]. */
+int gamelength;
+int gameboard[46];					/* the last position added by addgameposition(). */
+
+/* the test positions of the bench command, see bench(). */
+const char *benchpositions[NUMBENCHPOSITIONS] = {
+	"W:W21,22,23,24,25,26,27,28,29,30,31,32:B1,2,3,4,5,6,7,8,9,10,11,12",
+	"B:W18,19,21,23,24,26,29,30,31,32:B1,2,3,5,6,7,9,10,12,14",
+	"B:W14,18,22,25,26,27,29,30,31,32:B1,2,3,5,6,7,8,10,12,15",
+	"W:W17,21,22,23,25,26,27,29,30,31,32:B1,2,3,4,5,6,7,9,10,11,14",
+	"B:W15,19,22,23,26,27,30,31:B2,5,6,9,10,12,13,16",
+	"W:WK6,20,24,27,28:B3,K10,13,K14,15",
+	"W:W20,K27,28,32:B5,K9,12,K23",
+	"W:WK3,K5:BK30,K26",
+};
+
 #ifdef LOG_TIME_MGMT
 char logfilename[MAX_PATH];
+#endif
 
-void init_logfile()
-{
-	FILE *fp;
-	char path[MAX_PATH];
-
-	/* Create directories for Simplech under My Documents. */
-	if (SUCCEEDED(SHGetFolderPath(NULL, CSIDL_PERSONAL, NULL, 0, path))) {
-
-		/* Create the directories under My Documents. */
-		PathAppend(path, "Martin Fierz");
-		CreateDirectory(path, NULL);
-
-		PathAppend(path, "Dama");
-		CreateDirectory(path, NULL);
-	}
-	sprintf(logfilename, "%s\\Dama.log", path);
-	fp = fopen(logfilename, "w");
-	fclose(fp);
-}
-
-void log(const char *fmt, ...)
-{
-	FILE *fp;
-	va_list args;
-	va_start(args, fmt);
-
-	if (fmt == NULL)
-		return;
-
-	fp = fopen(logfilename, "a");
-	if (fp == NULL)
-		return;
+/*----------> the search and the move generation shared with simplech.c */
+#include "searchcore.h"
 
-	vfprintf(fp, fmt, args);
-	fclose(fp);
-}
-#endif
+typedef ITALIANRULES RULES;
+template <> void playedmove<ITALIANRULES>(move2 &move);
 
 /*-------------- PART 1: dll stuff -------------------------------------------*/
 BOOL WINAPI DllMain(HANDLE hDLL, DWORD dwReason, LPVOID lpReserved)
@@ -194,16 +318,26 @@ BOOL WINAPI DllMain(HANDLE hDLL, DWORD dwReason, LPVOID lpReserved)
 	/* in a dll you used to have LibMain instead of WinMain in windows programs, or main
    in normal C programs
    win32 replaces LibMain with DllEntryPoint.*/
+	int i;
+
 	switch (dwReason) {
 	case DLL_PROCESS_ATTACH:
 		/* dll loaded. put initializations here! */
 #ifdef LOG_TIME_MGMT
 		init_logfile();
 #endif
+		inithashkeys();
+		initevaluation();
 		break;
 
 	case DLL_PROCESS_DETACH:
 		/* program is unloading dll. put clean up here! */
+		free(hashtable);
+		hashtable = NULL;
+		for (i = 0; i < MAXTHREADS; i++) {
+			free(threads[i]);
+			threads[i] = NULL;
+		}
 		break;
 
 	case DLL_THREAD_ATTACH:
@@ -225,6 +359,7 @@ int WINAPI enginecommand(char str[256], char reply[256])
 	// Dama does not answer to some of the commands,
 	// eg it has no engine options.
 	char command[256], param1[256], param2[256];
+	int depth;
 
 	sscanf(str, "%s %s %s", command, param1, param2);
 
@@ -249,7 +384,28 @@ int WINAPI enginecommand(char str[256], char reply[256])
 
 	if (strcmp(command, "set") == 0) {
 		if (strcmp(param1, "hashsize") == 0) {
-			return 0;
+			if (!sethashsize(atoi(param2)))
+				return 0;
+
+			sprintf(reply, "%d", hashsize_MB);
+			return 1;
+		}
+
+		if (strcmp(param1, "searchthreads") == 0 || strcmp(param1, "threads") == 0) {
+			if (!setsearchthreads(atoi(param2)))
+				return 0;
+
+			sprintf(reply, "%d", numthreads);
+			return 1;
+		}
+
+		if (strcmp(param1, "multipv") == 0) {
+			if (atoi(param2) < 1 || atoi(param2) > MAXMULTIPV)
+				return 0;
+
+			multipv = atoi(param2);
+			sprintf(reply, "%d", multipv);
+			return 1;
 		}
 
 		if (strcmp(param1, "book") == 0) {
@@ -257,15 +413,57 @@ int WINAPI enginecommand(char str[256], char reply[256])
 		}
 	}
 
+	/* bench [depth] searches the test positions to a fixed depth, see bench(). */
+	if (strcmp(command, "bench") == 0) {
+		depth = BENCHDEPTH;
+		sscanf(str, "%*s %d", &depth);
+		if (depth < 1 || depth > MAXDEPTH) {
+			sprintf(reply, "?");
+			return 0;
+		}
+
+		if (hashtable == NULL)
+			sethashsize(hashsize_MB);
+		if (hashtable == NULL || (threads[0] == NULL && !setsearchthreads(numthreads))) {
+			sprintf(reply, "not enough memory for the search");
+			return 0;
+		}
+		return(bench<RULES>(depth, reply));
+	}
+
 	if (strcmp(command, "get") == 0) {
 		if (strcmp(param1, "hashsize") == 0) {
-			return 0;
+			sprintf(reply, "%d", hashsize_MB);
+			return 1;
+		}
+
+		if (strcmp(param1, "searchthreads") == 0 || strcmp(param1, "threads") == 0) {
+			sprintf(reply, "%d", numthreads);
+			return 1;
+		}
+
+		if (strcmp(param1, "multipv") == 0) {
+			sprintf(reply, "%d", multipv);
+			return 1;
+		}
+
+		if (strcmp(param1, "cpus") == 0) {
+			SYSTEM_INFO sysinfo;
+
+			GetSystemInfo(&sysinfo);
+			sprintf(reply, "%d", sysinfo.dwNumberOfProcessors);
+			return 1;
 		}
 
 		if (strcmp(param1, "book") == 0) {
 			return 0;
 		}
 
+		if (strcmp(param1, "stats") == 0) {
+			getstats(reply);
+			return 1;
+		}
+
 		if (strcmp(param1, "protocolversion") == 0) {
 			sprintf(reply, "2");
 			return 1;
@@ -275,6 +473,11 @@ int WINAPI enginecommand(char str[256], char reply[256])
 			sprintf(reply, "22");
 			return 1;
 		}
+
+		if (strcmp(param1, "ponder") == 0) {
+			sprintf(reply, "1");
+			return 1;
+		}
 	}
 
 	return 0;
@@ -393,15 +596,15 @@ int WINAPI getmove
    			would like your engine to play immediately, this value is nonzero,
             else zero. you should respond to a nonzero value of *playnow by
             interrupting your search IMMEDIATELY.
+   info		has the bits CB_RESET_MOVES, CB_EXACT_TIME, the incremental time mode
+   			and CB_PONDER. with CB_PONDER, color is the opponent and the engine
+            searches on its time until *playnow is set, see ponder().
 	
 	when programming for another version of checkers than english/american, you must 
 	tell checkerboard what your move is with CBmove.
 	*/
 	int i;
-	int value;
-	bool incremental;
-	double desired, new_iter_maxtime;
-	double remaining, increment;
+	int result;
 	int board[46];
 
 	/* initialize board */
@@ -459,41 +662,8 @@ int WINAPI getmove
 		board[i] = OCCUPIED;
 
 	play = playnow;
+	result = playmove<RULES>(board, color, maxtime, str, info, moreinfo);
 
-	starttime = clock();
-	if (incremental = get_incremental_times(info, moreinfo, &increment, &remaining)) {
-		if (remaining < increment) {
-			desired = remaining / 1.5;
-			absolute_maxtime = remaining;
-			new_iter_maxtime = 0.7 * absolute_maxtime / 1.5;
-		}
-		else {
-			desired = increment + remaining / 9;
-			absolute_maxtime = min(1.5 * desired, remaining);
-			new_iter_maxtime = 0.7 * absolute_maxtime / 1.5;
-		}
-
-		/* Allow a few msec for overhead. */
-		if (absolute_maxtime > .01)
-			absolute_maxtime -= .003;
-	}
-	else {
-		/* Using fixed time per move. These params result in an average search time of maxtime. */
-		new_iter_maxtime = 0.59 * maxtime;
-		absolute_maxtime = 3 * maxtime;
-	}
-
-	value = checkers(board, color, new_iter_maxtime, str);
-
-#ifdef LOG_TIME_MGMT
-	if (incremental) {
-		double elapsed = (clock() - starttime) / (double)CLK_TCK;
-		log("incr %.1f, remaining %.3f, abs maxt %.3f, desired %.3f, new iter maxt %.3f, actual %.3f, margin %.3f %s\n",
-			increment, remaining, absolute_maxtime, desired, new_iter_maxtime, 
-			elapsed, remaining - elapsed,
-			remaining - elapsed < 0 ? "***" : "");
-	}
-#endif
 	for (i = 5; i <= 40; i++)
 		if (board[i] == FREE)
 			board[i] = 0;
@@ -532,24 +702,10 @@ int WINAPI getmove
 	b[5][7] = board[39];
 	b[7][7] = board[40];
 
-	/* set the move */
-	*move = GCBmove;
-
-	if (color == BLACK) {
-		if (value > 4000)
-			return CB_WIN;
-		if (value < -4000)
-			return CB_LOSS;
-	}
-
-	if (color == WHITE) {
-		if (value > 4000)
-			return CB_LOSS;
-		if (value < -4000)
-			return CB_WIN;
-	}
-
-	return CB_UNKNOWN;
+	/* set the move, a ponder search plays none. */
+	if (!(info & CB_PONDER))
+		*move = GCBmove;
+	return result;
 }
 
 coor numbertocoor(int n)
@@ -809,87 +965,11 @@ void movetonotation(move2 move, char str[80])
 }
 
 /*-------------- PART II: SEARCH ---------------------------------------------*/
-int checkers(int b[46], int color, double maxtime, char *str)
-/*----------> purpose: entry point to checkers. find a move on board b for color
-  ---------->          in the time specified by maxtime, write the best move in
-  ---------->          board, returns information on the search in str
-  ----------> returns 1 if a move is found & executed, 0, if there is no legal
-  ----------> move in this position.
-  ----------> version: 1.1
-  ----------> date: 9th october 98 */
+template <> void playedmove<ITALIANRULES>(move2 &move)
+/*----------> purpose: set the CBmove that getmove() returns to the move that
+  ---------->          checkers() played. */
 {
-	int i, numberofmoves;
-	int eval;
-	move2 best, lastbest, movelist[MAXMOVES];
-	char str2[255];
-	alphabetas = 0;
-#ifdef STATISTICS
-	generatemovelists = 0;
-	generatecapturelists = 0;
-	evaluations = 0;
-#endif
-
-	/*--------> check if there is only one move */
-	numberofmoves = generatecapturelist(b, movelist, color);
-	if (numberofmoves == 0)
-		numberofmoves = generatemovelist(b, movelist, color);
-
-	/* set the best move to default movelist[0] - if it's a forced move we will return immediately*/
-	setbestmove(movelist[0]);
-
-	if (numberofmoves == 1) {
-		domove(b, movelist[0]);
-		sprintf(str, "forced move");
-		return(1);
-	}
-
-	if (numberofmoves == 0) {
-		sprintf(str, "no legal moves in this position");
-		return(0);
-	}
-
-	eval = firstalphabeta(b, 1, -10000, 10000, color, &best);
-	for (i = 2; (i <= MAXDEPTH) && ((clock() - starttime) / (double)CLK_TCK < maxtime); i++) {
-		lastbest = best;
-		eval = firstalphabeta(b, i, -10000, 10000, color, &best);
-		movetonotation(best, str2);
-#ifndef MUTE
-		sprintf(str, "best:%s time %2.2fs, depth %2li, value %4li", str2, (clock() - starttime) / (double)CLK_TCK, i, eval);
-#ifdef STATISTICS
-		sprintf(str2, "  nodes %li", alphabetas);
-		strcat(str, str2);
-#endif
-#endif
-		if (*play)
-			break;
-		if (eval == 5000)
-			break;
-		if (eval == -5000)
-			break;
-	}
-
-	i--;
-	if (*play)
-		movetonotation(lastbest, str2);
-	else
-		movetonotation(best, str2);
-
-	sprintf(str,
-			"best:%s time %2.2f, depth %2li, value %4li, nodes %li",
-			str2,
-			(clock() - starttime) / (double)CLK_TCK,
-			i,
-			eval,
-			alphabetas);
-
-	if (*play)
-		best = lastbest;
-
-	domove(b, best);
-
-	/* set the CBmove */
-	setbestmove(best);
-	return eval;
+	setbestmove(move);
 }
 
 void setbestmove(move2 move)
@@ -947,153 +1027,62 @@ void setbestmove(move2 move)
 	//	GCBmove.path[i]=numbertocoor(to);
 }
 
-int firstalphabeta(int b[46], int depth, int alpha, int beta, int color, move2 *best)
-/*----------> purpose: search the game tree and find the best move.
-  ----------> version: 1.0
-  ----------> date: 25th october 97 */
+void setthreadposition(SEARCHTHREAD *t, int b[46], int color)
+/*----------> purpose: set up the board, the hashkey and the evaluation terms of
+  ---------->          search thread t for board b. */
 {
-	int i;
-	int value;
-	int numberofmoves;
-	int capture;
-	move2 movelist[MAXMOVES];
-
-	alphabetas++;
-	if (*play)
-		return 0;
-
-	/*----------> test if captures are possible */
-	capture = testcapture(b, color);
-
-	/*----------> recursion termination if no captures and depth=0*/
-	if (depth == 0) {
-		if (capture == 0)
-			return(evaluation(b, color));
-		else
-			depth = 1;
-	}
-
-	/*----------> generate all possible moves in the position */
-	if (capture == 0) {
-		numberofmoves = generatemovelist(b, movelist, color);
-
-		/*----------> if there are no possible moves, we lose: */
-		if (numberofmoves == 0) {
-			if (color == BLACK)
-				return(-5000);
-			else
-				return(5000);
-		}
-	}
-	else
-		numberofmoves = generatecapturelist(b, movelist, color);
-
-	/*----------> for all moves: execute the move, search tree, undo move. */
-	for (i = 0; i < numberofmoves; i++) {
-		domove(b, movelist[i]);
-
-		value = alphabeta(b, depth - 1, alpha, beta, CB_CHANGECOLOR(color));
-
-		undomove(b, movelist[i]);
-		if (color == BLACK) {
-			if (value >= beta)
-				return(value);
-			if (value > alpha) {
-				alpha = value;
-				*best = movelist[i];
-			}
-		}
-
-		if (color == WHITE) {
-			if (value <= alpha)
-				return(value);
-			if (value < beta) {
-				beta = value;
-				*best = movelist[i];
-			}
-		}
-	}
-
-	if (color == BLACK)
-		return(alpha);
-	return(beta);
+	memcpy(t->b, b, sizeof(t->b));
+	t->hashkey = hashposition(b, color);
+	evalterms(b, t->count, &t->psq, &t->tempo);
 }
 
-int alphabeta(int b[46], int depth, int alpha, int beta, int color)
-/*----------> purpose: search the game tree and find the best move.
-  ----------> version: 1.0
-  ----------> date: 24th october 97 */
+void addgameposition(int b[46], int color)
+/*----------> purpose: add a position that CheckerBoard sent or that the engine played
+  ---------->          to the game history. the moves since the last position were
+  ---------->          reversible if they moved no men and took no pieces. */
 {
 	int i;
-	int value;
-	int capture;
-	int numberofmoves;
-	move2 movelist[MAXMOVES];
-
-	alphabetas++;
-	if ((alphabetas & 0x3ff) == 0) {
-		if ((clock() - starttime) / (double)CLK_TCK >= absolute_maxtime) {
-#ifdef LOG_TIME_MGMT
-			log("max detected at %.3f\n", (clock() - starttime) / (double)CLK_TCK);
-#endif
-			*play = 1;
-		}
-	}
-	if (*play)
-		return 0;
-
-	/*----------> test if captures are possible */
-	capture = testcapture(b, color);
-
-	/*----------> recursion termination if no captures and depth=0*/
-	if (depth == 0) {
-		if (capture == 0)
-			return(evaluation(b, color));
-		else
-			depth = 1;
-	}
-
-	/*----------> generate all possible moves in the position */
-	if (capture == 0) {
-		numberofmoves = generatemovelist(b, movelist, color);
-
-		/*----------> if there are no possible moves, we lose: */
-		if (numberofmoves == 0) {
-			if (color == BLACK)
-				return(-5000);
-			else
-				return(5000);
-		}
-	}
-	else
-		numberofmoves = generatecapturelist(b, movelist, color);
-
-	/*----------> for all moves: execute the move, search tree, undo move. */
-	for (i = 0; i < numberofmoves; i++) {
-		domove(b, movelist[i]);
-
-		value = alphabeta(b, depth - 1, alpha, beta, CB_CHANGECOLOR(color));
+	int reversible, pieces;
+
+	reversible = 1;
+	pieces = 0;
+	for (i = 5; i <= 40; i++) {
+		if (((b[i] | gameboard[i]) & MAN) && b[i] != gameboard[i])
+			reversible = 0;
+		if (b[i] & (MAN | KING))
+			pieces++;
+		if (gameboard[i] & (MAN | KING))
+			pieces--;
+		gameboard[i] = b[i];
+	}
+	addgamekey(hashposition(b, color), reversible && pieces == 0);
+}
 
-		undomove(b, movelist[i]);
+void tomove2(move2 &move, int color, move2 *m)
+/*----------> purpose: the moves of the search are already board46 moves. */
+{
+	*m = move;
+}
 
-		if (color == BLACK) {
-			if (value >= beta)
-				return(value);
-			if (value > alpha)
-				alpha = value;
-		}
+int samemove(move2 &a, move2 &b)
+/*----------> purpose: returns 1 if a and b are the same move. */
+{
+	if (a.n != b.n)
+		return(0);
+	return(memcmp(a.m, b.m, a.n * sizeof(a.m[0])) == 0);
+}
 
-		if (color == WHITE) {
-			if (value <= alpha)
-				return(value);
-			if (value < beta)
-				beta = value;
-		}
-	}
+uint64_t hashposition(int b[46], int color)
+/*----------> purpose: compute the zobrist key of a position from scratch. */
+{
+	int i;
+	uint64_t key = 0;
 
-	if (color == BLACK)
-		return(alpha);
-	return(beta);
+	for (i = 5; i <= 40; i++)
+		key ^= zobrist[i][b[i]];
+	if (color == WHITE)
+		key ^= zobrist_color;
+	return(key);
 }
 
 void domove(int b[46], move2 &move)
@@ -1123,76 +1112,203 @@ void undomove(int b[46], move2 &move)
 	}
 }
 
-int evaluation(int b[46], int color)
+void domove(SEARCHTHREAD *t, move2 &move)
+/*----------> purpose: execute move on the board of a search thread, update its
+  ---------->          hashkey and incremental evaluation terms and put the new
+  ---------->          position on its key stack. */
+{
+	int square, before, after;
+	int i;
+
+	for (i = 0; i < move.n; i++) {
+		square = (move.m[i] % 256);
+		before = ((move.m[i] >> 8) % 256);
+		after = ((move.m[i] >> 16) % 256);
+		t->b[square] = after;
+		t->hashkey ^= zobrist[square][before] ^ zobrist[square][after];
+		t->count[before]--;
+		t->count[after]++;
+		t->psq += psqvalue[after][square] - psqvalue[before][square];
+		t->tempo += tempovalue[after][square] - tempovalue[before][square];
+	}
+	t->hashkey ^= zobrist_color;
+
+	/* a king move that takes nothing is reversible. */
+	pushkey(t, move.n == 2 && ((move.m[0] >> 8) & KING));
+}
+
+void undomove(SEARCHTHREAD *t, move2 &move)
+{
+	int square, before, after;
+	int i;
+
+	popkey(t);
+	for (i = move.n - 1; i >= 0; --i) {
+		square = (move.m[i] % 256);
+		before = ((move.m[i] >> 8) % 256);
+		after = ((move.m[i] >> 16) % 256);
+		t->b[square] = before;
+		t->hashkey ^= zobrist[square][before] ^ zobrist[square][after];
+		t->count[after]--;
+		t->count[before]++;
+		t->psq += psqvalue[before][square] - psqvalue[after][square];
+		t->tempo += tempovalue[before][square] - tempovalue[after][square];
+	}
+	t->hashkey ^= zobrist_color;
+}
+
+/* evaluation weights and square lists. the material, center, edge and tempo terms
+   of the evaluation are sums over the pieces. the search keeps them up to date in
+   domove() and undomove(), so that evaluation() only computes the other terms. */
+static const int kcv = 5;					//multiplier for kings in center
+static const int mcv = 1;					//multiplier for men in center
+static const int mev = 1;					//multiplier for men on edge
+static const int kev = 5;					//multiplier for kings on edge
+static int edge[14] = { 5, 6, 7, 8, 13, 14, 22, 23, 31, 32, 37, 38, 39, 40 };
+static int center[8] = { 15, 16, 20, 21, 24, 25, 29, 30 };
+static int row[41] =
+{
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	1,
+	1,
+	1,
+	1,
+	2,
+	2,
+	2,
+	2,
+	0,
+	3,
+	3,
+	3,
+	3,
+	4,
+	4,
+	4,
+	4,
+	0,
+	5,
+	5,
+	5,
+	5,
+	6,
+	6,
+	6,
+	6,
+	0,
+	7,
+	7,
+	7,
+	7
+};
+
+void initevaluation(void)
+/*----------> purpose: set up the piece-square tables of the evaluation terms that
+  ---------->          are kept up to date by domove(). */
+{
+	int i;
+
+	memset(psqvalue, 0, sizeof(psqvalue));
+	memset(tempovalue, 0, sizeof(tempovalue));
+	for (i = 0; i < 8; i++) {
+		psqvalue[BLACK | MAN][center[i]] += mcv;
+		psqvalue[BLACK | KING][center[i]] += kcv;
+		psqvalue[WHITE | MAN][center[i]] -= mcv;
+		psqvalue[WHITE | KING][center[i]] -= kcv;
+	}
+	for (i = 0; i < 14; i++) {
+		psqvalue[BLACK | MAN][edge[i]] -= mev;
+		psqvalue[BLACK | KING][edge[i]] -= kev;
+		psqvalue[WHITE | MAN][edge[i]] += mev;
+		psqvalue[WHITE | KING][edge[i]] += kev;
+	}
+	for (i = 5; i <= 40; i++) {
+		tempovalue[BLACK | MAN][i] = row[i];
+		tempovalue[WHITE | MAN][i] = row[i] - 7;
+	}
+}
+
+void evalterms(int b[46], int count[17], int *psq, int *tempo)
+/*----------> purpose: compute the evaluation terms that domove() keeps up to date
+  ---------->          from scratch: the number of pieces of each kind, the center
+  ---------->          and edge terms, and the tempo count. */
+{
+	int i;
+	int nbmc = 0, nbkc = 0, nwmc = 0, nwkc = 0;
+	int nbme = 0, nbke = 0, nwme = 0, nwke = 0;
+
+	memset(count, 0, 17 * sizeof(int));
+	for (i = 5; i <= 40; i++)
+		count[b[i]]++;
+
+	/* center control */
+	for (i = 0; i < 8; i++) {
+		if (b[center[i]] != FREE) {
+			if (b[center[i]] == (BLACK | MAN))
+				nbmc++;
+			if (b[center[i]] == (BLACK | KING))
+				nbkc++;
+			if (b[center[i]] == (WHITE | MAN))
+				nwmc++;
+			if (b[center[i]] == (WHITE | KING))
+				nwkc++;
+		}
+	}
+
+	/*edge*/
+	for (i = 0; i < 14; i++) {
+		if (b[edge[i]] != FREE) {
+			if (b[edge[i]] == (BLACK | MAN))
+				nbme++;
+			if (b[edge[i]] == (BLACK | KING))
+				nbke++;
+			if (b[edge[i]] == (WHITE | MAN))
+				nwme++;
+			if (b[edge[i]] == (WHITE | KING))
+				nwke++;
+		}
+	}
+
+	*psq = (nbmc - nwmc) * mcv + (nbkc - nwkc) * kcv;
+	*psq -= (nbme - nwme) * mev + (nbke - nwke) * kev;
+
+	/* tempo */
+	*tempo = 0;
+	for (i = 5; i < 41; i++) {
+		if (b[i] == (BLACK | MAN))
+			*tempo += row[i];
+		if (b[i] == (WHITE | MAN))
+			*tempo -= 7 - row[i];
+	}
+}
+
+int evaluation(SEARCHTHREAD *t, int color)
 /*----------> purpose:
   ----------> version: 1.1
   ----------> date: 18th april 98 */
 {
+	int *b = t->b;
 	int i;
 	int eval;
 	int v1, v2;
 	int nbm, nbk, nwm, nwk;
-	int nbmc = 0, nbkc = 0, nwmc = 0, nwkc = 0;
-	int nbme = 0, nbke = 0, nwme = 0, nwke = 0;
 	int code = 0;
-	static int value[17] = { 0, 0, 0, 0, 0, 1, 256, 0, 0, 16, 4096, 0, 0, 0, 0, 0, 0 };
-	static int edge[14] = { 5, 6, 7, 8, 13, 14, 22, 23, 31, 32, 37, 38, 39, 40 };
-	static int center[8] = { 15, 16, 20, 21, 24, 25, 29, 30 };
-	static int row[41] =
-	{
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		1,
-		1,
-		1,
-		1,
-		2,
-		2,
-		2,
-		2,
-		0,
-		3,
-		3,
-		3,
-		3,
-		4,
-		4,
-		4,
-		4,
-		0,
-		5,
-		5,
-		5,
-		5,
-		6,
-		6,
-		6,
-		6,
-		0,
-		7,
-		7,
-		7,
-		7
-	};
 	static int safeedge[4] = { 8, 13, 32, 37 };
 
-	int tempo = 0;
+	int tempo;
 	int nm, nk;
 
 	const int turn = 2;						//color to move gets +turn
 	const int brv = 3;						//multiplier for back rank
-	const int kcv = 5;						//multiplier for kings in center
-	const int mcv = 1;						//multiplier for men in center
-	const int mev = 1;						//multiplier for men on edge
-	const int kev = 5;						//multiplier for kings on edge
 	const int cramp = 5;					//multiplier for cramp
 	const int opening = -2;					// multipliers for tempo
 	const int midgame = -1;
@@ -1203,16 +1319,18 @@ int evaluation(int b[46], int color)
 
 	int stonesinsystem = 0;
 
-#ifdef STATISTICS
-	evaluations++;
+#ifdef CHECKEVAL
+	int count[17], psq;
+
+	evalterms(b, count, &psq, &tempo);
+	if (memcmp(count, t->count, sizeof(count)) != 0 || psq != t->psq || tempo != t->tempo)
+		t->evalerrors++;
 #endif
-	for (i = 5; i <= 40; i++)
-		code += value[b[i]];
 
-	nwm = code % 16;
-	nwk = (code >> 4) % 16;
-	nbm = (code >> 8) % 16;
-	nbk = (code >> 12) % 16;
+	nbm = t->count[BLACK | MAN];
+	nbk = t->count[BLACK | KING];
+	nwm = t->count[WHITE | MAN];
+	nwk = t->count[WHITE | KING];
 
 	v1 = 100 * nbm + 160 * nbk;
 	v2 = 100 * nwm + 160 * nwk;
@@ -1424,47 +1542,11 @@ int evaluation(int b[46], int color)
                5   6   7   8
          (black)   */
 
-	/* center control */
-	for (i = 0; i < 8; i++) {
-		if (b[center[i]] != FREE) {
-			if (b[center[i]] == (BLACK | MAN))
-				nbmc++;
-			if (b[center[i]] == (BLACK | KING))
-				nbkc++;
-			if (b[center[i]] == (WHITE | MAN))
-				nwmc++;
-			if (b[center[i]] == (WHITE | KING))
-				nwkc++;
-		}
-	}
-
-	eval += (nbmc - nwmc) * mcv;
-	eval += (nbkc - nwkc) * kcv;
-
-	/*edge*/
-	for (i = 0; i < 14; i++) {
-		if (b[edge[i]] != FREE) {
-			if (b[edge[i]] == (BLACK | MAN))
-				nbme++;
-			if (b[edge[i]] == (BLACK | KING))
-				nbke++;
-			if (b[edge[i]] == (WHITE | MAN))
-				nwme++;
-			if (b[edge[i]] == (WHITE | KING))
-				nwke++;
-		}
-	}
-
-	eval -= (nbme - nwme) * mev;
-	eval -= (nbke - nwke) * kev;
+	/* center control and edge */
+	eval += t->psq;
 
 	/* tempo */
-	for (i = 5; i < 41; i++) {
-		if (b[i] == (BLACK | MAN))
-			tempo += row[i];
-		if (b[i] == (WHITE | MAN))
-			tempo -= 7 - row[i];
-	}
+	tempo = t->tempo;
 
 	if (nm >= 16)
 		eval += opening * tempo;
@@ -1490,1211 +1572,38 @@ int evaluation(int b[46], int color)
 
 /*-------------- PART III: MOVE GENERATION -----------------------------------*/
 int generatemovelist(int b[46], move2 movelist[MAXMOVES], int color)
-/*----------> purpose:generates all moves. no captures. returns number of moves
-  ----------> version: 1.0
-  ----------> date: 25th october 97 */
+/*----------> purpose: generates all moves. no captures. returns number of moves */
 {
-	int n = 0, m;
-	int i;
-
-#ifdef STATISTICS
-	generatemovelists++;
-#endif
-	if (color == BLACK) {
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & BLACK) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i + 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i >= 32)
-							m = (BLACK | KING);
-						else
-							m = (BLACK | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i + 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i >= 32)
-							m = (BLACK | KING);
-						else
-							m = (BLACK | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
-
-				if ((b[i] & KING) != 0) {
-					if ((b[i + 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i + 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
-			}
-		}
-	}
-	else {
-
-		/* color = WHITE */
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & WHITE) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i - 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i <= 13)
-							m = (WHITE | KING);
-						else
-							m = (WHITE | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i <= 13)
-							m = (WHITE | KING);
-						else
-							m = (WHITE | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
-
-				if ((b[i] & KING) != 0) {
-
-					/* or else */
-					if ((b[i + 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i + 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
-			}
-		}
-	}
-
-	return(n);
+	return(generatemovelist<RULES>(b, movelist, color));
 }
 
 int generatecapturelist(int b[46], move2 movelist[MAXMOVES], int color)
-/*----------> purpose: generate all possible captures
-  ----------> version: 1.0
-  ----------> date: 11th march 01 */
+/*----------> purpose: generate all possible captures. returns number of captures */
 {
-	int n = 0;
-	int m;
-	int i, j;
-	int tmp, max;
-	int n2;
-	int ismove[MAXMOVES];
-
-#ifdef STATISTICS
-	generatecapturelists++;
-#endif
-	if (color == BLACK) {
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & BLACK) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i + 4] == (WHITE | MAN))) {
-						if ((b[i + 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i >= 28)
-								m = (BLACK | KING);
-							else
-								m = (BLACK | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 4];
-							m = m << 8;
-							m += i + 4;
-							movelist[n].m[2] = m;
-							blackmancapture(b, &n, movelist, i + 8);
-						}
-					}
-
-					if ((b[i + 5] == (WHITE | MAN))) {
-						if ((b[i + 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i >= 28)
-								m = (BLACK | KING);
-							else
-								m = (BLACK | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 5];
-							m = m << 8;
-							m += i + 5;
-							movelist[n].m[2] = m;
-							blackmancapture(b, &n, movelist, i + 10);
-						}
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & WHITE) != 0) {
-						if ((b[i + 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 4];
-							m = m << 8;
-							m += i + 4;
-							movelist[n].m[2] = m;
-							tmp = b[i + 4];
-							b[i + 4] = FREE;	/* Remove captured piece. */
-							b[i] = FREE;		/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i + 8);
-							b[i + 4] = tmp;		/* Restore captured piece. */
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-
-					if ((b[i + 5] & WHITE) != 0) {
-						if ((b[i + 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 5];
-							m = m << 8;
-							m += i + 5;
-							movelist[n].m[2] = m;
-							tmp = b[i + 5];
-							b[i + 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i + 10);
-							b[i + 5] = tmp;
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-
-					if ((b[i - 4] & WHITE) != 0) {
-						if ((b[i - 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 4];
-							m = m << 8;
-							m += i - 4;
-							movelist[n].m[2] = m;
-							tmp = b[i - 4];
-							b[i - 4] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i - 8);
-							b[i - 4] = tmp;
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-
-					if ((b[i - 5] & WHITE) != 0) {
-						if ((b[i - 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 5];
-							m = m << 8;
-							m += i - 5;
-							movelist[n].m[2] = m;
-							tmp = b[i - 5];
-							b[i - 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i - 10);
-							b[i - 5] = tmp;
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-				}
-			}
-		}
-	}
-	else {
-
-		/* color is WHITE */
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & WHITE) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i - 4] == (BLACK | MAN))) {
-						if ((b[i - 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i <= 17)
-								m = (WHITE | KING);
-							else
-								m = (WHITE | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 4];
-							m = m << 8;
-							m += i - 4;
-							movelist[n].m[2] = m;
-							whitemancapture(b, &n, movelist, i - 8);
-						}
-					}
-
-					if ((b[i - 5] == (BLACK | MAN))) {
-						if ((b[i - 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i <= 17)
-								m = (WHITE | KING);
-							else
-								m = (WHITE | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 5];
-							m = m << 8;
-							m += i - 5;
-							movelist[n].m[2] = m;
-							whitemancapture(b, &n, movelist, i - 10);
-						}
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & BLACK) != 0) {
-						if ((b[i + 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 4];
-							m = m << 8;
-							m += i + 4;
-							movelist[n].m[2] = m;
-							tmp = b[i + 4];
-							b[i + 4] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i + 8);
-							b[i + 4] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-
-					if ((b[i + 5] & BLACK) != 0) {
-						if ((b[i + 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 5];
-							m = m << 8;
-							m += i + 5;
-							movelist[n].m[2] = m;
-							tmp = b[i + 5];
-							b[i + 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i + 10);
-							b[i + 5] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-
-					if ((b[i - 4] & BLACK) != 0) {
-						if ((b[i - 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 4];
-							m = m << 8;
-							m += i - 4;
-							movelist[n].m[2] = m;
-							tmp = b[i - 4];
-							b[i - 4] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i - 8);
-							b[i - 4] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-
-					if ((b[i - 5] & BLACK) != 0) {
-						if ((b[i - 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 5];
-							m = m << 8;
-							m += i - 5;
-							movelist[n].m[2] = m;
-							tmp = b[i - 5];
-							b[i - 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i - 10);
-							b[i - 5] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	/* this is dama italiana: clean up capture list. 
-	rules:	-> the maximum number of pieces must be captured
-				-> if that is possible with a man or a king, it must be done with the king
-				-> if there are multiple possibilites, it must take as many kings as possible
-				-> if there are multiple possibilites, it must take a king as early as possible*/
-
-	/* capture max */
-	for (i = 0; i < n; i++)
-		ismove[i] = 1;
-
-	max = 0;
-
-	for (i = 0; i < n; i++) {
-		if (movelist[i].n > max)
-			max = movelist[i].n;
-	}
-
-	for (i = 0; i < n; i++) {
-		if (movelist[i].n < max) {
-			ismove[i] = 0;
-		}
-	}
-
-	/* capture with king if multiple possibilities*/
-	max = 0;
-
-	for (i = 0; i < n; i++) {
-		if (!ismove[i])
-			continue;
-
-		if (((movelist[i].m[0] >> 8) % 256) & KING)
-			max = 1;
-	}
-
-	if (max == 1) {
-		for (i = 0; i < n; i++) {
-			if (!(((movelist[i].m[0] >> 8) % 256) & KING))
-				ismove[i] = 0;
-		}
-	}
-
-	/* capture maximum number of kings */
-	max = 0;
-	for (i = 0; i < n; i++) {
-		if (!ismove[i])
-			continue;
-		tmp = 0;
-		for (j = 2; j < movelist[i].n; j++) {
-			if (((movelist[i].m[j] >> 8) % 256) & KING)
-				tmp++;
-		}
-
-		if (tmp > max)
-			max = tmp;
-	}
-
-	if (max > 0) {
-		for (i = 0; i < n; i++) {
-			if (!ismove[i])
-				continue;
-			tmp = 0;
-			for (j = 2; j < movelist[i].n; j++) {
-				if (((movelist[i].m[j] >> 8) % 256) & KING)
-					tmp++;
-			}
-
-			if (tmp < max)
-				ismove[i] = 0;
-		}
-	}
-
-	/* capture king as early as possible */
-
-	/* for all moves: tmp is the earliest jump */
-
-	/* max is the smallest of the earliest jumps*/
-
-	/* eyg bug fix. Each king capture must be the earliest possible, not just the first
-	 * king capture. In this pos, W:WK30:BK26,K27,K18,20,10,K12 30x5 is the only legal move.
-	 * I changed temp to be the binary weighted sum of king captures, where
-	 * the weight of the nth capture is (1 << n).
-	 */
-	max = 65535;
-	for (i = 0; i < n; i++) {
-		if (!ismove[i])
-			continue;
-		tmp = 0;
-		for (j = movelist[i].n - 1; j >= 2; j--) {
-			if (((movelist[i].m[j] >> 8) % 256) & KING)
-				tmp += (1 << j);
-		}
-
-		if (tmp < max)
-			max = tmp;
-	}
-
-	for (i = 0; i < n; i++) {
-		if (!ismove[i])
-			continue;
-		tmp = 0;
-		for (j = movelist[i].n - 1; j >= 2; j--) {
-			if (((movelist[i].m[j] >> 8) % 256) & KING)
-				tmp += (1 << j);
-		}
-
-		if (tmp > max)
-			ismove[i] = 0;
-	}
-
-	/* clean up movelist */
-	n2 = 0;
-	for (i = 0; i < n; i++) {
-		if (ismove[i]) {
-			movelist[n2] = movelist[i];
-			n2++;
-		}
-	}
-
-	return(n2);
+	return(generatecapturelist<RULES>(b, movelist, color));
 }
 
-void blackmancapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+int testcapture(SEARCHTHREAD *t, int color)
+/*----------> purpose: the search's view of testcapture(): the board of thread t */
 {
-	int m;
-	int found = 0;
-	move2 move, orgmove;
-
-	orgmove = movelist[*n];
-	move = orgmove;
-
-	if ((b[i + 4] == (WHITE | MAN))) {
-		if ((b[i + 8] & FREE) != 0) {
-			move.n++;
-			if (i >= 28)
-				m = (BLACK | KING);
-			else
-				m = (BLACK | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += (i + 8);
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 4];
-			m = m << 8;
-			m += (i + 4);
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			blackmancapture(b, n, movelist, i + 8);
-		}
-	}
-
-	move = orgmove;
-	if ((b[i + 5] == (WHITE | MAN))) {
-		if ((b[i + 10] & FREE) != 0) {
-			move.n++;
-			if (i >= 28)
-				m = (BLACK | KING);
-			else
-				m = (BLACK | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += (i + 10);
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 5];
-			m = m << 8;
-			m += (i + 5);
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			blackmancapture(b, n, movelist, i + 10);
-		}
-	}
-
-	if (!found)
-		(*n)++;
+	return(testcapture<RULES>(t->b, color));
 }
 
-void blackkingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+int generatemovelist(SEARCHTHREAD *t, move2 movelist[MAXMOVES], int color)
+/*----------> purpose: the search's view of generatemovelist(): the board of thread t */
 {
-	int m;
-	int tmp;
-	int found = 0;
-	move2 move, orgmove;
-
-	orgmove = movelist[*n];
-	move = orgmove;
-
-	if ((b[i - 4] & WHITE) != 0) {
-		if ((b[i - 8] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 4];
-			m = m << 8;
-			m += i - 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 4];
-			b[i - 4] = FREE;
-			blackkingcapture(b, n, movelist, i - 8);
-			b[i - 4] = tmp;
-		}
-	}
-
-	move = orgmove;
-	if ((b[i - 5] & WHITE) != 0) {
-		if ((b[i - 10] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 5];
-			m = m << 8;
-			m += i - 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 5];
-			b[i - 5] = FREE;
-			blackkingcapture(b, n, movelist, i - 10);
-			b[i - 5] = tmp;
-		}
-	}
-
-	move = orgmove;
-	if ((b[i + 4] & WHITE) != 0) {
-		if ((b[i + 8] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 4];
-			m = m << 8;
-			m += i + 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 4];
-			b[i + 4] = FREE;
-			blackkingcapture(b, n, movelist, i + 8);
-			b[i + 4] = tmp;
-		}
-	}
-
-	move = orgmove;
-	if ((b[i + 5] & WHITE) != 0) {
-		if ((b[i + 10] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 5];
-			m = m << 8;
-			m += i + 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 5];
-			b[i + 5] = FREE;
-			blackkingcapture(b, n, movelist, i + 10);
-			b[i + 5] = tmp;
-		}
-	}
-
-	if (!found)
-		(*n)++;
+	return(generatemovelist<RULES>(t->b, movelist, color));
 }
 
-void whitemancapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+int generatecapturelist(SEARCHTHREAD *t, move2 movelist[MAXMOVES], int color)
+/*----------> purpose: the search's view of generatecapturelist(): the board of thread t */
 {
-	int m;
-	int found = 0;
-	move2 move, orgmove;
-
-	orgmove = movelist[*n];
-	move = orgmove;
-
-	if ((b[i - 4] == (BLACK | MAN))) {
-		if ((b[i - 8] & FREE) != 0) {
-			move.n++;
-			if (i <= 17)
-				m = (WHITE | KING);
-			else
-				m = (WHITE | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 4];
-			m = m << 8;
-			m += i - 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			whitemancapture(b, n, movelist, i - 8);
-		}
-	}
-
-	move = orgmove;
-	if ((b[i - 5] == (BLACK | MAN))) {
-		if ((b[i - 10] & FREE) != 0) {
-			move.n++;
-			if (i <= 17)
-				m = (WHITE | KING);
-			else
-				m = (WHITE | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 5];
-			m = m << 8;
-			m += i - 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			whitemancapture(b, n, movelist, i - 10);
-		}
-	}
-
-	if (!found)
-		(*n)++;
+	return(generatecapturelist<RULES>(t->b, movelist, color));
 }
 
-void whitekingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+int &historyentry(SEARCHTHREAD *t, move2 &move, int color)
+/*----------> purpose: the history score of move for color, indexed by its from and to squares */
 {
-	int m;
-	int tmp;
-	int found = 0;
-	move2 move, orgmove;
-
-	orgmove = movelist[*n];
-	move = orgmove;
-
-	if ((b[i - 4] & BLACK) != 0) {
-		if ((b[i - 8] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 4];
-			m = m << 8;
-			m += i - 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 4];
-			b[i - 4] = FREE;
-			whitekingcapture(b, n, movelist, i - 8);
-			b[i - 4] = tmp;
-		}
-	}
-
-	move = orgmove;
-	if ((b[i - 5] & BLACK) != 0) {
-		if ((b[i - 10] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 5];
-			m = m << 8;
-			m += i - 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 5];
-			b[i - 5] = FREE;
-			whitekingcapture(b, n, movelist, i - 10);
-			b[i - 5] = tmp;
-		}
-	}
-
-	move = orgmove;
-	if ((b[i + 4] & BLACK) != 0) {
-		if ((b[i + 8] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 4];
-			m = m << 8;
-			m += i + 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 4];
-			b[i + 4] = FREE;
-			whitekingcapture(b, n, movelist, i + 8);
-			b[i + 4] = tmp;
-		}
-	}
-
-	move = orgmove;
-	if ((b[i + 5] & BLACK) != 0) {
-		if ((b[i + 10] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 5];
-			m = m << 8;
-			m += i + 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 5];
-			b[i + 5] = FREE;
-			whitekingcapture(b, n, movelist, i + 10);
-			b[i + 5] = tmp;
-		}
-	}
-
-	if (!found)
-		(*n)++;
+	return(t->history[color - 1][move.m[0] % 256][move.m[1] % 256]);
 }
 
-int testcapture(int b[46], int color)
-/*----------> purpose: test if color has a capture on b
-  ----------> version: 1.0
-  ----------> date: 25th october 97 */
-{
-	int i;
-
-#ifdef STATISTICS
-	testcaptures++;
-#endif
-	if (color == BLACK) {
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & BLACK) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i + 4] == (WHITE | MAN))) {
-						if ((b[i + 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i + 5] == (WHITE | MAN))) {
-						if ((b[i + 10] & FREE) != 0)
-							return(1);
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & WHITE) != 0) {
-						if ((b[i + 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i + 5] & WHITE) != 0) {
-						if ((b[i + 10] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 4] & WHITE) != 0) {
-						if ((b[i - 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 5] & WHITE) != 0) {
-						if ((b[i - 10] & FREE) != 0)
-							return(1);
-					}
-				}
-			}
-		}
-	}
-	else {
-
-		/* color is WHITE */
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & WHITE) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i - 4] == (BLACK | MAN))) {
-						if ((b[i - 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 5] == (BLACK | MAN))) {
-						if ((b[i - 10] & FREE) != 0)
-							return(1);
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & BLACK) != 0) {
-						if ((b[i + 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i + 5] & BLACK) != 0) {
-						if ((b[i + 10] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 4] & BLACK) != 0) {
-						if ((b[i - 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 5] & BLACK) != 0) {
-						if ((b[i - 10] & FREE) != 0)
-							return(1);
-					}
-				}
-			}
-		}
-	}
-
-	return(0);
-}
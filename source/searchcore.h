@@ -0,0 +1,2581 @@
+#pragma once
+/*______________________________________________________________________________
+
+  ----------> name: searchcore.h
+  ----------> purpose: the search, its driver for getmove() and the move generation
+  ---------->          that simple checkers and dama italiana share
+  ----------> description: searchcore.h is included by simplech.c and dama.c after
+              their structs, globals and function prototypes. the functions are
+              templates on a rules policy, ENGLISHRULES or ITALIANRULES, so that
+              the compiler resolves the differences of the rules and each engine
+              gets a search and a move generator specialized for its rules.
+
+              the engine provides the SEARCHTHREAD struct and its move type
+              SEARCHMOVE, and these functions of a search thread:
+
+              testcapture(t, color), generatemovelist(t, movelist, color) and
+              generatecapturelist(t, movelist, color) for its position,
+              domove(t, move) and undomove(t, move), evaluation(t, color),
+              historyentry(t, move, color), the history score of a move, and
+              samemove(a, b).
+
+              an engine with an endgame database specializes databasevalue() for
+              its rules, an engine with an opening book bookmove(), and an engine
+              that tells CheckerBoard its move in a CBmove playedmove().
+
+              for the driver of getmove(), the engine provides these functions of
+              the board b[46] of CheckerBoard: hashposition(b, color),
+              addgameposition(b, color), which adds b to the game history,
+              domove(b, move) and movetonotation(move, str) for a move2,
+              tomove2(move, color, m), which converts a SEARCHMOVE to a move2,
+              and setthreadposition(t, b, color), which sets up the position,
+              hashkey and evaluation terms of a search thread for b. it has the
+              globals of the search clock, the hashtable, the search threads, the
+              zobrist keys zobrist[][] and zobrist_color, and the ponder state.
+              with LOG_TIME_MGMT the time management is logged to LOGNAME.log in
+              the folder LOGNAME, and the engine has logfilename[].
+
+              for the repetition detection, the SEARCHTHREAD has the key stack
+              keys[], reversible[], numkeys and keycount[] of the size
+              MAXGAMEPLY + MAXPLY and KEYCOUNTSLOTS, and the engine has the
+              game history gamekeys[], gamereversible[] and gamelength. the
+              engine adds the positions of the game with addgamekey(), and its
+              domove(t, move) and undomove(t, move) call pushkey() and popkey().
+
+              for the bench command, the engine has the FEN strings of its test
+              positions in benchpositions[] and their number in NUMBENCHPOSITIONS.
+
+              the move generation on the board b[46] of CheckerBoard's engines,
+              which the engines use for the moves they play and Perft uses to
+              count moves, is at the end. */
+
+/*----------> rules policies */
+struct ENGLISHRULES {
+	static const int MANCAPTURESKING = 1;	/* men capture men and kings. */
+	static const int CAPTUREPRIORITY = 0;	/* any capture may be chosen. */
+	static const int RIGHTTOLEFT = 1;		/* the squares of a row are numbered from black's right. */
+};
+
+struct ITALIANRULES {
+	static const int MANCAPTURESKING = 0;	/* men only capture men. */
+	static const int CAPTUREPRIORITY = 1;	/* the captures are restricted by capturepriority(). */
+	static const int RIGHTTOLEFT = 0;		/* the squares of a row are numbered from black's left. */
+};
+
+/*----------> function prototypes */
+
+/*----------> getmove and iterative deepening */
+template <class RULES> int playmove(int b[46], int color, double maxtime, char *str, int info, int moreinfo);
+void starttimer(void);
+double searchtime(void);
+template <class RULES> int checkers(int b[46], int color, double maxtime, char *str);
+template <class RULES> DWORD WINAPI helperthread(LPVOID param);
+template <class RULES> void ponder(int b[46], int color, char *str);
+template <class RULES> int bookmove(int b[46], int color, char *str);
+template <class RULES> void playedmove(move2 &move);
+void initsearchthread(SEARCHTHREAD *t, int b[46], int color);
+void searchstats(char *str);
+int setsearchthreads(int n);
+void multipvstring(SEARCHTHREAD *t, int color, char *str);
+void inithashkeys(void);
+int sethashsize(int megabytes);
+#ifdef LOG_TIME_MGMT
+void init_logfile(void);
+void log(const char *fmt, ...);
+#endif
+
+/*----------> search */
+template <class RULES> int aspirationsearch(SEARCHTHREAD *t, int depth, int eval, int color, SEARCHMOVE *best);
+template <class RULES> int firstalphabeta(SEARCHTHREAD *t, int depth, int alpha, int beta, int color, SEARCHMOVE *best);
+template <class RULES> int multipvsearch(SEARCHTHREAD *t, int depth, int color, SEARCHMOVE *best);
+template <class RULES> int alphabeta(SEARCHTHREAD *t, int depth, int alpha, int beta, int color, int ply);
+template <class RULES> int quiescence(SEARCHTHREAD *t, int alpha, int beta, int color, int ply, int qply);
+template <class RULES> int databasevalue(SEARCHTHREAD *t, int color, int progress, int *value);
+void moveorder(SEARCHTHREAD *t, SEARCHMOVE movelist[MAXMOVES], int order[MAXMOVES], int numberofmoves, int hashmove, int ply, int color, int capture);
+void goodmove(SEARCHTHREAD *t, SEARCHMOVE &move, int depth, int ply, int color, int capture);
+void updatepv(SEARCHTHREAD *t, SEARCHMOVE &move, int ply);
+int hashlookup(SEARCHTHREAD *t, int depth, int alpha, int beta, int *value, int *best);
+void hashstore(SEARCHTHREAD *t, int depth, int bound, int value, int best);
+void recorditeration(int depth);
+void getstats(char *reply);
+template <class RULES> int bench(int depth, char *reply);
+template <class RULES> int fentoboard(const char *fen, int b[46], int *color);
+
+/*----------> repetitions */
+void addgamekey(uint64_t key, int reversible);
+void initrepetitions(SEARCHTHREAD *t);
+void pushkey(SEARCHTHREAD *t, int reversible);
+void popkey(SEARCHTHREAD *t);
+int repetition(SEARCHTHREAD *t);
+
+/*----------> move generation on the board b[46] */
+template <class RULES> int generatemovelist(int b[46], move2 movelist[MAXMOVES], int color);
+template <class RULES> int generatecapturelist(int b[46], move2 movelist[MAXMOVES], int color);
+template <class RULES> void capturesequences(int b[46], int *n, move2 movelist[MAXMOVES], int square, int piece);
+template <class RULES> void blackmancapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
+template <class RULES> void blackkingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
+template <class RULES> void whitemancapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
+template <class RULES> void whitekingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
+template <class RULES> int testcapture(int b[46], int color);
+template <class RULES> int mancancapture(int piece, int opponent);
+int capturepriority(move2 movelist[MAXMOVES], int n);
+
+/*-------------- GETMOVE AND ITERATIVE DEEPENING -----------------------------*/
+template <class RULES> int playmove(int b[46], int color, double maxtime, char *str, int info, int moreinfo)
+/*----------> purpose: the search of getmove(). find a move for color on board b in
+  ---------->          the time that CheckerBoard sent in maxtime, info and moreinfo,
+  ---------->          and play it on b. with CB_PONDER, search on the opponent's
+  ---------->          time and leave b as it is, see ponder().
+  ----------> returns CB_WIN, CB_LOSS or CB_UNKNOWN for getmove(). */
+{
+	int value;
+	bool incremental;
+	double desired, deadline;
+	double remaining, increment;
+
+	/* the hashtable is allocated on the first search, unless CheckerBoard has set a size already. */
+	if (hashtable == NULL)
+		sethashsize(hashsize_MB);
+	if (threads[0] == NULL && !setsearchthreads(numthreads)) {
+		sprintf(str, "not enough memory for the search");
+		return CB_UNKNOWN;
+	}
+
+	/* a new game, or CheckerBoard changed the game: forget the positions of the game. */
+	if (info & CB_RESET_MOVES)
+		gamelength = 0;
+
+	if (info & CB_PONDER) {
+		ponder<RULES>(b, color, str);
+		return CB_UNKNOWN;
+	}
+
+	/* on a ponder hit the search goes on with the hashtable entries of the ponder search. */
+	addgameposition(b, color);
+	ponderhit = (ponderkey != 0 && hashposition(b, color) == ponderkey);
+	ponderkey = 0;
+	if (!ponderhit)
+		searchid++;
+
+	/* the search only starts an iteration that it expects to finish by deadline,
+	   and aborts at absolute_maxtime. */
+	starttimer();
+	incremental = get_incremental_times(info, moreinfo, &increment, &remaining);
+	if (incremental) {
+		if (remaining < increment) {
+			desired = remaining / 1.5;
+			absolute_maxtime = remaining;
+		}
+		else {
+			desired = increment + remaining / 9;
+			absolute_maxtime = min(1.5 * desired, remaining);
+		}
+		deadline = min(1.2 * desired, absolute_maxtime);
+
+		/* Allow a few msec for overhead. */
+		if (absolute_maxtime > .01)
+			absolute_maxtime -= .003;
+	}
+	else {
+		/* Using fixed time per move. No iteration is started that is predicted to end
+		 * after 1.2 * maxtime, and the search is stopped hard at that time. Measured average
+		 * is about 0.65 * maxtime at 1 s and 0.7 * maxtime at 2 s per move.
+		 */
+		deadline = 1.2 * maxtime;
+		absolute_maxtime = 1.2 * maxtime;
+	}
+
+	value = checkers<RULES>(b, color, deadline, str);
+	if (ponderhit)
+		strcat(str, ", ponder hit");
+	addgameposition(b, CB_CHANGECOLOR(color));
+
+#ifdef LOG_TIME_MGMT
+	if (incremental) {
+		double elapsed = searchtime();
+		log("incr %.1f, remaining %.3f, abs maxt %.3f, desired %.3f, deadline %.3f, actual %.3f, margin %.3f %s\n",
+			increment, remaining, absolute_maxtime, desired, deadline, 
+			elapsed, remaining - elapsed,
+			remaining - elapsed < 0 ? "***" : "");
+	}
+#endif
+
+	if (color == BLACK) {
+		if (value > 4000)
+			return CB_WIN;
+		if (value < -4000)
+			return CB_LOSS;
+	}
+
+	if (color == WHITE) {
+		if (value > 4000)
+			return CB_LOSS;
+		if (value < -4000)
+			return CB_WIN;
+	}
+
+	return CB_UNKNOWN;
+}
+
+inline void starttimer(void)
+/*----------> purpose: start the search clock. */
+{
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceFrequency(&frequency);
+	counterfrequency = (double)frequency.QuadPart;
+	QueryPerformanceCounter(&starttime);
+}
+
+inline double searchtime(void)
+/*----------> purpose: seconds of wall clock time since starttimer(). */
+{
+	LARGE_INTEGER now;
+
+	QueryPerformanceCounter(&now);
+	return((now.QuadPart - starttime.QuadPart) / counterfrequency);
+}
+
+template <class RULES> int checkers(int b[46], int color, double maxtime, char *str)
+/*----------> purpose: entry point to checkers. find a move on board b for color
+  ---------->          in the time specified by maxtime, write the best move in
+  ---------->          board, returns information on the search in str.
+  ---------->          an iteration is only started if it is expected to finish
+  ---------->          within maxtime. its time is predicted from the time of the
+  ---------->          last iteration and the branching factor of the iterations
+  ---------->          before.
+  ---------->          the second move of the pv is remembered as the expected
+  ---------->          reply for ponder().
+  ----------> returns the value of the search, > 4000 if black wins and < -4000
+  ----------> if white wins. a forced move returns 1, a move of the book and a
+  ----------> position without legal moves return 0.
+  ----------> version: 1.1
+  ----------> date: 9th october 98 */
+{
+	int i, k, numberofmoves;
+	int eval;
+	int numhelpers;
+	double iterationstart, iterationtime, lastiterationtime, ebf;
+	move2 m, movelist[MAXMOVES];
+	SEARCHMOVE best, lastbest, *pv;
+	int pvlength;
+	char str2[255];
+	HANDLE helpers[MAXTHREADS];
+	DWORD threadid;
+	SEARCHTHREAD *t;
+
+	expectedkey = 0;
+
+	/*--------> check if there is only one move */
+	numberofmoves = generatecapturelist<RULES>(b, movelist, color);
+	if (numberofmoves == 0)
+		numberofmoves = generatemovelist<RULES>(b, movelist, color);
+
+	if (numberofmoves == 1) {
+		domove(b, movelist[0]);
+		playedmove<RULES>(movelist[0]);
+		sprintf(str, "forced move");
+		return(1);
+	}
+
+	if (numberofmoves == 0) {
+		sprintf(str, "no legal moves in this position");
+		return(0);
+	}
+
+	/*--------> play a move of the opening book without a search */
+	if (bookmove<RULES>(b, color, str))
+		return(0);
+
+	for (k = 0; k < numthreads; k++)
+		initsearchthread(threads[k], b, color);
+
+	/*--------> start the helper threads, they search the same position and share the hashtable */
+	stopsearch = 0;
+	numhelpers = 0;
+	for (k = 1; k < numthreads; k++) {
+		helpers[numhelpers] = CreateThread(NULL, 0, helperthread<RULES>, threads[k], 0, &threadid);
+		if (helpers[numhelpers] != NULL)
+			numhelpers++;
+	}
+
+	t = threads[0];
+	numiterations = 0;
+	if (multipv > 1)
+		eval = multipvsearch<RULES>(t, 1, color, &best);
+	else
+		eval = firstalphabeta<RULES>(t, 1, -10000, 10000, color, &best);
+	recorditeration(1);
+	lastiterationtime = searchtime();
+	ebf = 3.0;
+	for (i = 2; (i <= MAXDEPTH) && (searchtime() + ebf * lastiterationtime < maxtime); i++) {
+		iterationstart = searchtime();
+		lastbest = best;
+		memcpy(t->lastpv, t->pv[0], t->pvlength[0] * sizeof(SEARCHMOVE));
+		t->lastpvlength = t->pvlength[0];
+		if (multipv > 1)
+			eval = multipvsearch<RULES>(t, i, color, &best);
+		else
+			eval = aspirationsearch<RULES>(t, i, eval, color, &best);
+		if (!*play)
+			recorditeration(i);
+
+		/* the branching factor is smoothed over the iterations. the first
+		   iterations take too little time to be measured. */
+		iterationtime = searchtime() - iterationstart;
+		if (lastiterationtime > 0.001)
+			ebf = (ebf + min(max(iterationtime / lastiterationtime, 1.5), 10.0)) / 2;
+		lastiterationtime = iterationtime;
+
+		tomove2(best, color, &m);
+		movetonotation(m, str2);
+#ifndef MUTE
+		sprintf(str, "best:%s time %2.2fs, depth %2li, value %4li", str2, searchtime(), i, eval);
+#ifdef STATISTICS
+		searchstats(str2);
+		strcat(str, str2);
+#endif
+		if (multipv > 1) {
+			multipvstring(t, color, str2);
+			strcat(str, str2);
+		}
+#endif
+		if (*play)
+			break;
+		if (eval == 5000)
+			break;
+		if (eval == -5000)
+			break;
+	}
+
+	/*--------> stop the helper threads */
+	stopsearch = 1;
+	if (numhelpers > 0) {
+		WaitForMultipleObjects(numhelpers, helpers, TRUE, INFINITE);
+		for (k = 0; k < numhelpers; k++)
+			CloseHandle(helpers[k]);
+	}
+
+	i--;
+	if (*play) {
+		best = lastbest;
+		pv = t->lastpv;
+		pvlength = t->lastpvlength;
+	}
+	else {
+		pv = t->pv[0];
+		pvlength = t->pvlength[0];
+	}
+	tomove2(best, color, &m);
+	movetonotation(m, str2);
+
+	sprintf(str, "best:%s time %2.2f, depth %2li, value %4li", str2, searchtime(), i, eval);
+	searchstats(str2);
+	strcat(str, str2);
+	if (multipv > 1) {
+		multipvstring(t, color, str2);
+		strcat(str, str2);
+	}
+
+	domove(b, m);
+	playedmove<RULES>(m);
+
+	/*--------> remember the reply of the opponent that the pv expects */
+	if (pvlength >= 2 && samemove(pv[0], best)) {
+		expectedkey = hashposition(b, CB_CHANGECOLOR(color));
+		expectedreply = pv[1];
+	}
+	return eval;
+}
+
+template <class RULES> DWORD WINAPI helperthread(LPVOID param)
+/*----------> purpose: iterative deepening of a helper thread. the helpers fill the
+  ---------->          shared hashtable until the main thread stops them, their
+  ---------->          best moves are not used. odd helpers start one ply deeper
+  ---------->          so that the threads do not all search the same depth. */
+{
+	SEARCHTHREAD *t = (SEARCHTHREAD *)param;
+	int depth, eval;
+	SEARCHMOVE best;
+
+	eval = 0;
+	for (depth = 1 + (t->id & 1); depth <= MAXDEPTH; depth++) {
+		memcpy(t->lastpv, t->pv[0], t->pvlength[0] * sizeof(SEARCHMOVE));
+		t->lastpvlength = t->pvlength[0];
+		if (depth == 1)
+			eval = firstalphabeta<RULES>(t, depth, -10000, 10000, t->color, &best);
+		else
+			eval = aspirationsearch<RULES>(t, depth, eval, t->color, &best);
+		if (*play || stopsearch)
+			break;
+		if (eval == 5000 || eval == -5000)
+			break;
+	}
+
+	return(0);
+}
+
+template <class RULES> void ponder(int b[46], int color, char *str)
+/*----------> purpose: search on the opponent's time. b is the position after our
+  ---------->          move with color to move. the reply expected by the last
+  ---------->          search, or else the best move of a short search, is played
+  ---------->          on a copy of b and the position after it is searched until
+  ---------->          *play is set. b is not changed. */
+{
+	int b2[46];
+	move2 m;
+
+	ponderkey = 0;
+	ponderhit = 0;
+	memcpy(b2, b, sizeof(b2));
+	if (expectedkey != 0 && hashposition(b, color) == expectedkey) {
+		tomove2(expectedreply, color, &m);
+		domove(b2, m);
+	}
+	else {
+		searchid++;
+		starttimer();
+		absolute_maxtime = PONDERGUESSTIME;
+		checkers<RULES>(b2, color, PONDERGUESSTIME, str);
+		if (*play || memcmp(b2, b, sizeof(b2)) == 0)
+			return;
+	}
+
+	/* there is no time limit, CheckerBoard stops the search with *play. */
+	color = CB_CHANGECOLOR(color);
+	ponderkey = hashposition(b2, color);
+	searchid++;
+	starttimer();
+	absolute_maxtime = 1e9;
+	checkers<RULES>(b2, color, 1e9, str);
+}
+
+template <class RULES> int bookmove(int b[46], int color, char *str)
+/*----------> purpose: play a move of the opening book on b. an engine with an opening
+  ---------->          book specializes bookmove() for its rules.
+  ----------> returns 1 if a book move was played, 0 if not. */
+{
+	return(0);
+}
+
+template <class RULES> void playedmove(move2 &move)
+/*----------> purpose: checkers() played move on the board of CheckerBoard. an engine
+  ---------->          that has to tell CheckerBoard its move in the CBmove of
+  ---------->          getmove() specializes playedmove() for its rules. */
+{
+}
+
+inline void initsearchthread(SEARCHTHREAD *t, int b[46], int color)
+/*----------> purpose: prepare a search thread for a new search of board b. on a
+  ---------->          ponder hit the killers and history of the ponder search are
+  ---------->          kept. */
+{
+	int i;
+
+	t->color = color;
+	setthreadposition(t, b, color);
+	initrepetitions(t);
+	t->alphabetas = 0;
+	t->qnodes = 0;
+	t->maxqdepth = 0;
+	t->hashprobes = 0;
+	t->hashhits = 0;
+#ifdef STATISTICS
+	t->generatemovelists = 0;
+	t->generatecapturelists = 0;
+	t->evaluations = 0;
+	t->testcaptures = 0;
+	t->failhighs = 0;
+	t->failhighsfirst = 0;
+	t->pvssearches = 0;
+	t->pvsresearches = 0;
+	t->aspresearches = 0;
+	t->dbhits = 0;
+#endif
+#ifdef CHECKEVAL
+	t->evalerrors = 0;
+#endif
+
+	/* keep some of the history of the last search, forget its pv and killers. */
+	if (!ponderhit) {
+		for (i = 0; i < (int)(sizeof(t->history) / sizeof(t->history[0][0][0])); i++)
+			(&t->history[0][0][0])[i] /= 8;
+		memset(t->killers, 0, sizeof(t->killers));
+	}
+	t->pvlength[0] = 0;
+	t->lastpvlength = 0;
+	t->numrootmoves = 0;
+}
+
+inline void searchstats(char *str)
+/*----------> purpose: write the node counts of all search threads to str. */
+{
+	int k;
+	int64_t nodes = 0, qnodes = 0;
+	int qdepth = 0;
+#ifdef STATISTICS
+	int64_t gms = 0, gcs = 0, evals = 0;
+	int64_t fh = 0, fhf = 0;
+	int64_t pvs = 0, pvsre = 0;
+	int aspre = 0;
+	int64_t dbhits = 0;
+#endif
+#ifdef CHECKEVAL
+	int evalerrors = 0;
+#endif
+
+	for (k = 0; k < numthreads; k++) {
+		nodes += threads[k]->alphabetas;
+		qnodes += threads[k]->qnodes;
+		qdepth = max(qdepth, threads[k]->maxqdepth);
+#ifdef STATISTICS
+		gms += threads[k]->generatemovelists;
+		gcs += threads[k]->generatecapturelists;
+		evals += threads[k]->evaluations;
+		fh += threads[k]->failhighs;
+		fhf += threads[k]->failhighsfirst;
+		pvs += threads[k]->pvssearches;
+		pvsre += threads[k]->pvsresearches;
+		aspre += threads[k]->aspresearches;
+		dbhits += threads[k]->dbhits;
+#endif
+#ifdef CHECKEVAL
+		evalerrors += threads[k]->evalerrors;
+#endif
+	}
+
+#ifdef STATISTICS
+	sprintf(str,
+			"  nodes %lld, qnodes %lld, qdepth %i, gms %lld, gcs %lld, evals %lld, fhf %i%%, pvs re %i%%, asp re %i",
+			nodes,
+			qnodes,
+			qdepth,
+			gms,
+			gcs,
+			evals,
+			(int)(100 * fhf / max(fh, (int64_t)1)),
+			(int)(100 * pvsre / max(pvs, (int64_t)1)),
+			aspre);
+	if (dbhits)
+		sprintf(str + strlen(str), ", db %lld", dbhits);
+#else
+	sprintf(str, "  nodes %lld, qnodes %lld, qdepth %i", nodes, qnodes, qdepth);
+#endif
+	if (numthreads > 1) {
+		sprintf(str + strlen(str), ", threads %li", numthreads);
+	}
+#ifdef CHECKEVAL
+	sprintf(str + strlen(str), ", eval errors %li", evalerrors);
+#endif
+}
+
+inline int setsearchthreads(int n)
+/*----------> purpose: set the number of search threads, the main thread plus n - 1
+  ---------->          helper threads.
+  ----------> returns 1 on success, 0 if n is out of range or the memory for the
+  ----------> thread data could not be allocated. */
+{
+	int k;
+
+	if (n < 1 || n > MAXTHREADS)
+		return(0);
+
+	for (k = 0; k < n; k++) {
+		if (threads[k] == NULL) {
+			threads[k] = (SEARCHTHREAD *)calloc(1, sizeof(SEARCHTHREAD));
+			if (threads[k] == NULL)
+				return(0);
+			threads[k]->id = k;
+		}
+	}
+
+	for (k = n; k < MAXTHREADS; k++) {
+		free(threads[k]);
+		threads[k] = NULL;
+	}
+
+	numthreads = n;
+	return(1);
+}
+
+inline void multipvstring(SEARCHTHREAD *t, int color, char *str)
+/*----------> purpose: write the multipv best moves of the last completed iteration and
+  ---------->          their values to str. */
+{
+	int i;
+	move2 m;
+	char str2[80];
+
+	sprintf(str, ", multipv");
+	for (i = 0; i < min(multipv, t->numrootmoves); i++) {
+		tomove2(t->rootmoves[i], color, &m);
+		movetonotation(m, str2);
+		sprintf(str + strlen(str), "%s %s %i", (i == 0) ? "" : ",", str2, t->rootvalues[i]);
+	}
+}
+
+inline void inithashkeys(void)
+/*----------> purpose: fill the zobrist tables with pseudo-random numbers. a fixed
+  ---------->          seed is used so that searches are reproducible. */
+{
+	int i;
+	uint64_t x = 0x9e3779b97f4a7c15ULL;
+	uint64_t *keys = &zobrist[0][0];
+
+	for (i = 0; i < (int)(sizeof(zobrist) / sizeof(zobrist[0][0])); i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		keys[i] = x;
+	}
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	zobrist_color = x;
+}
+
+inline int sethashsize(int megabytes)
+/*----------> purpose: allocate a hashtable of at most megabytes MB. the number of
+  ---------->          entries is rounded down to a power of 2.
+  ----------> returns 1 on success, 0 if the memory could not be allocated. in that
+  ----------> case the old size is allocated again. */
+{
+	uint32_t entries;
+	HASHENTRY *newtable;
+
+	if (megabytes < 1)
+		return(0);
+
+	entries = 1;
+	while ((uint64_t)entries * 2 * sizeof(HASHENTRY) <= (uint64_t)megabytes * 1024 * 1024 && entries < 0x80000000)
+		entries *= 2;
+
+	free(hashtable);
+	newtable = (HASHENTRY *)calloc(entries, sizeof(HASHENTRY));
+	if (newtable == NULL) {
+		hashtable = NULL;
+		if (megabytes != hashsize_MB)
+			sethashsize(hashsize_MB);
+		return(0);
+	}
+
+	hashtable = newtable;
+	hashmask = entries - 1;
+	hashsize_MB = megabytes;
+	return(1);
+}
+
+#ifdef LOG_TIME_MGMT
+inline void init_logfile(void)
+/*----------> purpose: create the time management log LOGNAME.log in the folder
+  ---------->          Martin Fierz\LOGNAME under My Documents. */
+{
+	FILE *fp;
+	char path[MAX_PATH];
+
+	/* Create directories for the engine under My Documents. */
+	if (SUCCEEDED(SHGetFolderPath(NULL, CSIDL_PERSONAL, NULL, 0, path))) {
+
+		/* Create the directories under My Documents. */
+		PathAppend(path, "Martin Fierz");
+		CreateDirectory(path, NULL);
+
+		PathAppend(path, LOGNAME);
+		CreateDirectory(path, NULL);
+	}
+	sprintf(logfilename, "%s\\%s.log", path, LOGNAME);
+	fp = fopen(logfilename, "w");
+	fclose(fp);
+}
+
+inline void log(const char *fmt, ...)
+{
+	FILE *fp;
+	va_list args;
+	va_start(args, fmt);
+
+	if (fmt == NULL)
+		return;
+
+	fp = fopen(logfilename, "a");
+	if (fp == NULL)
+		return;
+
+	vfprintf(fp, fmt, args);
+	fclose(fp);
+}
+#endif
+
+/*-------------- SEARCH ------------------------------------------------------*/
+template <class RULES> int aspirationsearch(SEARCHTHREAD *t, int depth, int eval, int color, SEARCHMOVE *best)
+/*----------> purpose: search the root with a small window around eval, the value
+  ---------->          of the last iteration. if the value falls outside the
+  ---------->          window, the search is repeated with that side of the
+  ---------->          window opened. */
+{
+	int alpha, beta;
+	int value;
+
+	alpha = max(eval - ASPIRATIONWINDOW, -10000);
+	beta = min(eval + ASPIRATIONWINDOW, 10000);
+	for (;;) {
+		value = firstalphabeta<RULES>(t, depth, alpha, beta, color, best);
+		if (*play || stopsearch)
+			return(value);
+
+		if (value <= alpha && alpha > -10000)
+			alpha = -10000;
+		else if (value >= beta && beta < 10000)
+			beta = 10000;
+		else
+			return(value);
+#ifdef STATISTICS
+		t->aspresearches++;
+#endif
+	}
+}
+
+template <class RULES> int firstalphabeta(SEARCHTHREAD *t, int depth, int alpha, int beta, int color, SEARCHMOVE *best)
+/*----------> purpose: search the game tree and find the best move.
+  ----------> version: 1.0
+  ----------> date: 25th october 97 */
+{
+	int i, j;
+	int value;
+	int numberofmoves;
+	int capture;
+	int hashmove, bestindex;
+	int order[MAXMOVES];
+	SEARCHMOVE movelist[MAXMOVES];
+
+	t->alphabetas++;
+	if (*play || stopsearch)
+		return 0;
+
+	/*----------> test if captures are possible */
+	capture = testcapture(t, color);
+#ifdef STATISTICS
+	t->testcaptures++;
+#endif
+
+	/*----------> recursion termination if no captures and depth=0*/
+	if (depth == 0) {
+		if (capture == 0) {
+#ifdef STATISTICS
+			t->evaluations++;
+#endif
+			return(evaluation(t, color));
+		}
+		else
+			depth = 1;
+	}
+
+	/*----------> generate all possible moves in the position */
+	if (capture == 0) {
+		numberofmoves = generatemovelist(t, movelist, color);
+#ifdef STATISTICS
+		t->generatemovelists++;
+#endif
+
+		/*----------> if there are no possible moves, we lose: */
+		if (numberofmoves == 0) {
+			if (color == BLACK)
+				return(-5000);
+			else
+				return(5000);
+		}
+	}
+	else {
+		numberofmoves = generatecapturelist(t, movelist, color);
+#ifdef STATISTICS
+		t->generatecapturelists++;
+#endif
+	}
+
+	/*----------> at the root the hashtable is only used for the move from the last iteration */
+	hashmove = NO_MOVE;
+	hashlookup(t, depth, alpha, beta, &value, &hashmove);
+	t->followpv = 1;
+	t->pvlength[0] = 0;
+	moveorder(t, movelist, order, numberofmoves, hashmove, 0, color, capture);
+	bestindex = NO_MOVE;
+
+	/*----------> for all moves: execute the move, search tree, undo move. */
+	for (i = 0; i < numberofmoves; i++) {
+		j = order[i];
+		domove(t, movelist[j]);
+
+		/*----------> principal variation search: only the first move is searched
+		  ----------> with the full window. the others are searched with a null
+		  ----------> window, and only searched again if they are better. */
+		if (i == 0)
+			value = alphabeta<RULES>(t, depth - 1, alpha, beta, CB_CHANGECOLOR(color), 1);
+		else {
+			if (color == BLACK)
+				value = alphabeta<RULES>(t, depth - 1, alpha, alpha + 1, CB_CHANGECOLOR(color), 1);
+			else
+				value = alphabeta<RULES>(t, depth - 1, beta - 1, beta, CB_CHANGECOLOR(color), 1);
+#ifdef STATISTICS
+			t->pvssearches++;
+#endif
+			if (value > alpha && value < beta) {
+#ifdef STATISTICS
+				t->pvsresearches++;
+#endif
+				value = alphabeta<RULES>(t, depth - 1, alpha, beta, CB_CHANGECOLOR(color), 1);
+			}
+		}
+
+		undomove(t, movelist[j]);
+		t->followpv = 0;
+		if (color == BLACK) {
+			if (value >= beta) {
+				hashstore(t, depth, HASH_LOWER, value, j);
+				return(value);
+			}
+			if (value > alpha) {
+				alpha = value;
+				bestindex = j;
+				*best = movelist[j];
+				updatepv(t, movelist[j], 0);
+			}
+		}
+
+		if (color == WHITE) {
+			if (value <= alpha) {
+				hashstore(t, depth, HASH_UPPER, value, j);
+				return(value);
+			}
+			if (value < beta) {
+				beta = value;
+				bestindex = j;
+				*best = movelist[j];
+				updatepv(t, movelist[j], 0);
+			}
+		}
+	}
+
+	if (color == BLACK) {
+		hashstore(t, depth, bestindex == NO_MOVE ? HASH_UPPER : HASH_EXACT, alpha, bestindex);
+		return(alpha);
+	}
+	hashstore(t, depth, bestindex == NO_MOVE ? HASH_LOWER : HASH_EXACT, beta, bestindex);
+	return(beta);
+}
+
+template <class RULES> int multipvsearch(SEARCHTHREAD *t, int depth, int color, SEARCHMOVE *best)
+/*----------> purpose: search the root so that the values of the multipv best moves
+  ---------->          are exact. each root move is searched with a null window at
+  ---------->          the value of the multipv-th best move so far, and only with
+  ---------->          the open window if it is better, so that the moves share the
+  ---------->          tree and the hashtable. the root moves are searched in the
+  ---------->          order of the last iteration, the results are only kept in
+  ---------->          t->rootmoves when the iteration is completed.
+  ----------> returns the value of the best move. */
+{
+	int i, j, n;
+	int value, bound;
+	int score[MAXMOVES];			/* the values from the point of view of color. */
+	int values[MAXMOVES];
+	SEARCHMOVE moves[MAXMOVES];
+	SEARCHMOVE m;
+	int sign = (color == BLACK) ? 1 : -1;
+
+	t->alphabetas++;
+	if (t->numrootmoves == 0) {
+		if (testcapture(t, color))
+			t->numrootmoves = generatecapturelist(t, t->rootmoves, color);
+		else
+			t->numrootmoves = generatemovelist(t, t->rootmoves, color);
+		if (t->numrootmoves == 0)
+			return(-5000 * sign);
+		memset(t->rootvalues, 0, sizeof(t->rootvalues));
+	}
+
+	t->followpv = (t->lastpvlength > 0 && samemove(t->rootmoves[0], t->lastpv[0]));
+	t->pvlength[0] = 0;
+	for (i = 0; i < t->numrootmoves; i++) {
+		m = t->rootmoves[i];
+		bound = (i >= multipv) ? score[multipv - 1] : -10000;
+		domove(t, m);
+		if (bound == -10000)
+			value = alphabeta<RULES>(t, depth - 1, -10000, 10000, CB_CHANGECOLOR(color), 1);
+		else {
+			if (color == BLACK)
+				value = alphabeta<RULES>(t, depth - 1, bound, bound + 1, CB_CHANGECOLOR(color), 1);
+			else
+				value = alphabeta<RULES>(t, depth - 1, -bound - 1, -bound, CB_CHANGECOLOR(color), 1);
+			if (sign * value > bound) {
+				if (color == BLACK)
+					value = alphabeta<RULES>(t, depth - 1, bound, 10000, CB_CHANGECOLOR(color), 1);
+				else
+					value = alphabeta<RULES>(t, depth - 1, -10000, -bound, CB_CHANGECOLOR(color), 1);
+			}
+		}
+		undomove(t, m);
+		t->followpv = 0;
+		if (*play || stopsearch)
+			return(0);
+
+		/* insert the move after the moves that are at least as good. */
+		for (j = i; j > 0 && score[j - 1] < sign * value; j--) {
+			score[j] = score[j - 1];
+			values[j] = values[j - 1];
+			moves[j] = moves[j - 1];
+		}
+		score[j] = sign * value;
+		values[j] = value;
+		moves[j] = m;
+		if (j == 0)
+			updatepv(t, m, 0);
+	}
+
+	n = t->numrootmoves;
+	memcpy(t->rootmoves, moves, n * sizeof(SEARCHMOVE));
+	memcpy(t->rootvalues, values, n * sizeof(int));
+	*best = moves[0];
+	return(values[0]);
+}
+
+template <class RULES> int alphabeta(SEARCHTHREAD *t, int depth, int alpha, int beta, int color, int ply)
+/*----------> purpose: search the game tree and find the best move.
+  ----------> version: 1.0
+  ----------> date: 24th october 97 */
+{
+	int i, j;
+	int value;
+	int capture;
+	int numberofmoves;
+	int hashmove, bestindex;
+	int order[MAXMOVES];
+	SEARCHMOVE movelist[MAXMOVES];
+
+	/*----------> at the horizon, only the pending captures are searched */
+	if (depth == 0)
+		return(quiescence<RULES>(t, alpha, beta, color, ply, 0));
+
+	t->alphabetas++;
+
+	/* only the main thread looks at the clock, the helpers stop with it. */
+	if (t->id == 0 && (t->alphabetas & 0x3ff) == 0) {
+		if (searchtime() >= absolute_maxtime) {
+#ifdef LOG_TIME_MGMT
+			log("max detected at %.3f\n", searchtime());
+#endif
+			*play = 1;
+		}
+	}
+	if (*play || stopsearch)
+		return 0;
+
+	t->pvlength[ply] = ply;
+	if (ply >= MAXPLY - 1) {
+#ifdef STATISTICS
+		t->evaluations++;
+#endif
+		return(evaluation(t, color));
+	}
+
+	/*----------> a position that was on the board before is a draw: the side that
+	  ----------> could make progress would not have repeated it, and the king moves
+	  ----------> that go around in circles are not searched again. */
+	if (repetition(t))
+		return(0);
+
+	/*----------> test if captures are possible */
+	capture = testcapture(t, color);
+#ifdef STATISTICS
+	t->testcaptures++;
+#endif
+
+	/*----------> look up the position in the endgame database of the rules. its
+	  ----------> values are exact, so the search stops here. */
+	if (capture == 0 && databasevalue<RULES>(t, color, 1, &value))
+		return(value);
+
+	/*----------> look up the position in the hashtable */
+	hashmove = NO_MOVE;
+	if (hashlookup(t, depth, alpha, beta, &value, &hashmove))
+		return(value);
+
+	/*----------> generate all possible moves in the position */
+	if (capture == 0) {
+		numberofmoves = generatemovelist(t, movelist, color);
+#ifdef STATISTICS
+		t->generatemovelists++;
+#endif
+
+		/*----------> if there are no possible moves, we lose: */
+		if (numberofmoves == 0) {
+			if (color == BLACK)
+				return(-5000);
+			else
+				return(5000);
+		}
+	}
+	else {
+		numberofmoves = generatecapturelist(t, movelist, color);
+#ifdef STATISTICS
+		t->generatecapturelists++;
+#endif
+	}
+
+	moveorder(t, movelist, order, numberofmoves, hashmove, ply, color, capture);
+	bestindex = NO_MOVE;
+
+	/*----------> for all moves: execute the move, search tree, undo move. */
+	for (i = 0; i < numberofmoves; i++) {
+		j = order[i];
+		domove(t, movelist[j]);
+
+		/*----------> principal variation search: only the first move is searched
+		  ----------> with the full window. the others are searched with a null
+		  ----------> window, and only searched again if they are better. */
+		if (i == 0)
+			value = alphabeta<RULES>(t, depth - 1, alpha, beta, CB_CHANGECOLOR(color), ply + 1);
+		else {
+			if (color == BLACK)
+				value = alphabeta<RULES>(t, depth - 1, alpha, alpha + 1, CB_CHANGECOLOR(color), ply + 1);
+			else
+				value = alphabeta<RULES>(t, depth - 1, beta - 1, beta, CB_CHANGECOLOR(color), ply + 1);
+#ifdef STATISTICS
+			t->pvssearches++;
+#endif
+			if (value > alpha && value < beta) {
+#ifdef STATISTICS
+				t->pvsresearches++;
+#endif
+				value = alphabeta<RULES>(t, depth - 1, alpha, beta, CB_CHANGECOLOR(color), ply + 1);
+			}
+		}
+
+		undomove(t, movelist[j]);
+		t->followpv = 0;
+
+		if (color == BLACK) {
+			if (value >= beta) {
+				goodmove(t, movelist[j], depth, ply, color, capture);
+#ifdef STATISTICS
+				t->failhighs++;
+				if (i == 0)
+					t->failhighsfirst++;
+#endif
+				hashstore(t, depth, HASH_LOWER, value, j);
+				return(value);
+			}
+			if (value > alpha) {
+				alpha = value;
+				bestindex = j;
+				updatepv(t, movelist[j], ply);
+			}
+		}
+
+		if (color == WHITE) {
+			if (value <= alpha) {
+				goodmove(t, movelist[j], depth, ply, color, capture);
+#ifdef STATISTICS
+				t->failhighs++;
+				if (i == 0)
+					t->failhighsfirst++;
+#endif
+				hashstore(t, depth, HASH_UPPER, value, j);
+				return(value);
+			}
+			if (value < beta) {
+				beta = value;
+				bestindex = j;
+				updatepv(t, movelist[j], ply);
+			}
+		}
+	}
+
+	if (bestindex != NO_MOVE)
+		goodmove(t, movelist[bestindex], depth, ply, color, capture);
+
+	if (color == BLACK) {
+		hashstore(t, depth, bestindex == NO_MOVE ? HASH_UPPER : HASH_EXACT, alpha, bestindex);
+		return(alpha);
+	}
+	hashstore(t, depth, bestindex == NO_MOVE ? HASH_LOWER : HASH_EXACT, beta, bestindex);
+	return(beta);
+}
+
+template <class RULES> int quiescence(SEARCHTHREAD *t, int alpha, int beta, int color, int ply, int qply)
+/*----------> purpose: search the capture sequence at the end of the search. as long
+  ---------->          as the side to move has to capture, all captures are
+  ---------->          searched, and the position is evaluated when it is quiet.
+  ---------->          there is no hashtable, move ordering or time check here.
+  ---------->          qply is the number of captures made after the horizon. */
+{
+	int i;
+	int value;
+	int numberofmoves;
+	SEARCHMOVE movelist[MAXMOVES];
+
+	t->qnodes++;
+	if (qply > t->maxqdepth)
+		t->maxqdepth = qply;
+
+	t->pvlength[ply] = ply;
+#ifdef STATISTICS
+	t->testcaptures++;
+#endif
+	if (ply >= MAXPLY - 1 || !testcapture(t, color)) {
+		if (databasevalue<RULES>(t, color, 0, &value))
+			return(value);
+#ifdef STATISTICS
+		t->evaluations++;
+#endif
+		return(evaluation(t, color));
+	}
+
+	numberofmoves = generatecapturelist(t, movelist, color);
+#ifdef STATISTICS
+	t->generatecapturelists++;
+#endif
+
+	for (i = 0; i < numberofmoves; i++) {
+		domove(t, movelist[i]);
+		value = quiescence<RULES>(t, alpha, beta, CB_CHANGECOLOR(color), ply + 1, qply + 1);
+		undomove(t, movelist[i]);
+
+		if (color == BLACK) {
+			if (value >= beta)
+				return(value);
+			if (value > alpha)
+				alpha = value;
+		}
+		else {
+			if (value <= alpha)
+				return(value);
+			if (value < beta)
+				beta = value;
+		}
+	}
+
+	if (color == BLACK)
+		return(alpha);
+	return(beta);
+}
+
+template <class RULES> int databasevalue(SEARCHTHREAD *t, int color, int progress, int *value)
+/*----------> purpose: look up the position of thread t in the endgame database. with
+  ---------->          progress, the positions that are needed to make progress in a
+  ---------->          won root position are not looked up but searched. an engine
+  ---------->          with a database for RULES specializes this function, for all
+  ---------->          other rules there is no database.
+  ----------> returns 1 and sets *value if the position was found, else 0. */
+{
+	return(0);
+}
+
+inline void moveorder(SEARCHTHREAD *t, SEARCHMOVE movelist[MAXMOVES], int order[MAXMOVES], int numberofmoves, int hashmove, int ply, int color, int capture)
+/*----------> purpose: set the order in which the moves of a movelist are searched:
+  ---------->          pv move, hashtable move, killer moves, then the other
+  ---------->          moves by their history score. captures keep the order of
+  ---------->          the move generator after the pv and hashtable moves. */
+{
+	int i, j, k;
+	int score[MAXMOVES];
+	int pvfound = 0;
+
+	for (i = 0; i < numberofmoves; i++) {
+		if (capture)
+			score[i] = 0;
+		else {
+			score[i] = historyentry(t, movelist[i], color);
+			if (samemove(movelist[i], t->killers[ply][0]))
+				score[i] = 0x10000000;
+			else if (samemove(movelist[i], t->killers[ply][1]))
+				score[i] = 0x0fffffff;
+		}
+
+		if (i == hashmove)
+			score[i] = 0x20000000;
+		if (t->followpv && ply < t->lastpvlength && samemove(movelist[i], t->lastpv[ply])) {
+			score[i] = 0x40000000;
+			pvfound = 1;
+		}
+	}
+
+	/* the first move searched is only on the pv path if it is the pv move. */
+	if (!pvfound)
+		t->followpv = 0;
+
+	/* insertion sort, moves with equal scores stay in generator order. */
+	for (i = 0; i < numberofmoves; i++) {
+		k = i;
+		for (j = i; j > 0 && score[order[j - 1]] < score[k]; j--)
+			order[j] = order[j - 1];
+		order[j] = k;
+	}
+}
+
+inline void goodmove(SEARCHTHREAD *t, SEARCHMOVE &move, int depth, int ply, int color, int capture)
+/*----------> purpose: a quiet move caused a cutoff or was the best move: make it a
+  ---------->          killer at this ply and raise its history score. */
+{
+	int i;
+
+	if (capture)
+		return;
+
+	if (!samemove(move, t->killers[ply][0])) {
+		t->killers[ply][1] = t->killers[ply][0];
+		t->killers[ply][0] = move;
+	}
+
+	historyentry(t, move, color) += depth * depth;
+	if (historyentry(t, move, color) > 0x00100000) {
+		for (i = 0; i < (int)(sizeof(t->history) / sizeof(int)); i++)
+			(&t->history[0][0][0])[i] /= 2;
+	}
+}
+
+inline void updatepv(SEARCHTHREAD *t, SEARCHMOVE &move, int ply)
+/*----------> purpose: move is the new best move at ply, the pv from ply is move
+  ---------->          followed by the pv of the child position. */
+{
+	int i;
+
+	t->pv[ply][ply] = move;
+	for (i = ply + 1; i < t->pvlength[ply + 1]; i++)
+		t->pv[ply][i] = t->pv[ply + 1][i];
+	t->pvlength[ply] = max(t->pvlength[ply + 1], ply + 1);
+}
+
+inline int hashlookup(SEARCHTHREAD *t, int depth, int alpha, int beta, int *value, int *best)
+/*----------> purpose: look up the current position of thread t in the hashtable.
+  ----------> *best is set to the stored best move, if there is one.
+  ----------> returns 1 if the stored value can be used instead of a search and
+  ----------> sets *value, else 0. */
+{
+	volatile HASHENTRY *entry;
+	uint64_t data, check;
+	int v;
+
+	if (hashtable == NULL)
+		return(0);
+
+	t->hashprobes++;
+	entry = hashtable + (t->hashkey & hashmask);
+	data = entry->data;
+	check = entry->check;
+	if ((check ^ data) != t->hashkey || HASHBOUND(data) == 0)
+		return(0);
+
+	t->hashhits++;
+	*best = HASHBEST(data);
+	if (HASHDEPTH(data) < depth)
+		return(0);
+
+	v = HASHVALUE(data);
+	switch (HASHBOUND(data)) {
+	case HASH_EXACT:
+		*value = v;
+		return(1);
+
+	case HASH_LOWER:
+		if (v >= beta) {
+			*value = v;
+			return(1);
+		}
+		break;
+
+	case HASH_UPPER:
+		if (v <= alpha) {
+			*value = v;
+			return(1);
+		}
+		break;
+	}
+
+	return(0);
+}
+
+inline void hashstore(SEARCHTHREAD *t, int depth, int bound, int value, int best)
+/*----------> purpose: save the search result of the current position of thread t.
+  ---------->          entries from older searches and shallower entries are
+  ---------->          overwritten. results of aborted searches are not stored. */
+{
+	volatile HASHENTRY *entry;
+	uint64_t data, olddata;
+	int samekey;
+
+	if (hashtable == NULL || *play || stopsearch)
+		return;
+
+	entry = hashtable + (t->hashkey & hashmask);
+	olddata = entry->data;
+	samekey = ((entry->check ^ olddata) == t->hashkey);
+	if (!samekey && HASHSEARCHID(olddata) == searchid && HASHDEPTH(olddata) > depth)
+		return;
+
+	/* keep the old best move if this search did not find one. */
+	if (best == NO_MOVE && samekey)
+		best = HASHBEST(olddata);
+
+	data = (uint64_t)(unsigned short)value |
+		((uint64_t)depth << 16) |
+		((uint64_t)bound << 24) |
+		((uint64_t)best << 32) |
+		((uint64_t)searchid << 40);
+	entry->data = data;
+	entry->check = t->hashkey ^ data;
+}
+
+/*-------------- REPETITIONS -------------------------------------------------*/
+/* the positions of the game and of the search path are on the key stack of each
+   search thread, with the number of reversible moves, non-capturing king moves,
+   that led to each. a position can only repeat one that is reached by reversible
+   moves only. keycount[] counts the keys on the stack by their top bits, so that
+   the stack is only searched if the position may be on it. */
+#define KEYCOUNTSLOT(key) ((int)((key) >> 54) & (KEYCOUNTSLOTS - 1))
+
+inline void addgamekey(uint64_t key, int reversible)
+/*----------> purpose: add the key of a position of the game to the game history.
+  ---------->          reversible is nonzero if the moves since the last position
+  ---------->          of the game were reversible. if the history is full, its
+  ---------->          older half is forgotten. */
+{
+	if (gamelength > 0 && gamekeys[gamelength - 1] == key)
+		return;
+	if (gamelength == MAXGAMEPLY) {
+		memmove(gamekeys, gamekeys + MAXGAMEPLY / 2, MAXGAMEPLY / 2 * sizeof(uint64_t));
+		memmove(gamereversible, gamereversible + MAXGAMEPLY / 2, MAXGAMEPLY / 2 * sizeof(int));
+		gamelength = MAXGAMEPLY / 2;
+	}
+	if (reversible && gamelength > 0)
+		gamereversible[gamelength] = gamereversible[gamelength - 1] + 1;
+	else
+		gamereversible[gamelength] = 0;
+	gamekeys[gamelength++] = key;
+}
+
+inline void initrepetitions(SEARCHTHREAD *t)
+/*----------> purpose: set up the key stack of thread t for a search of its position,
+  ---------->          with the positions of the game since the last irreversible
+  ---------->          move. the root is the top of the stack. */
+{
+	int i, first;
+
+	memset(t->keycount, 0, sizeof(t->keycount));
+	t->numkeys = 0;
+	if (gamelength > 0 && gamekeys[gamelength - 1] == t->hashkey) {
+		first = max(gamelength - 1 - gamereversible[gamelength - 1], 0);
+		for (i = first; i < gamelength; i++) {
+			t->keys[t->numkeys] = gamekeys[i];
+			t->reversible[t->numkeys] = min(gamereversible[i], t->numkeys);
+			t->keycount[KEYCOUNTSLOT(gamekeys[i])]++;
+			t->numkeys++;
+		}
+	}
+	else {
+		t->keys[0] = t->hashkey;
+		t->reversible[0] = 0;
+		t->keycount[KEYCOUNTSLOT(t->hashkey)]++;
+		t->numkeys = 1;
+	}
+}
+
+inline void pushkey(SEARCHTHREAD *t, int reversible)
+/*----------> purpose: put the key of the position after a move on the key stack.
+  ---------->          called by domove(). */
+{
+	int n = t->numkeys;
+
+	t->keys[n] = t->hashkey;
+	t->reversible[n] = reversible ? t->reversible[n - 1] + 1 : 0;
+	t->keycount[KEYCOUNTSLOT(t->hashkey)]++;
+	t->numkeys++;
+}
+
+inline void popkey(SEARCHTHREAD *t)
+/*----------> purpose: take the key of the position after a move from the key stack.
+  ---------->          called by undomove(). */
+{
+	t->numkeys--;
+	t->keycount[KEYCOUNTSLOT(t->keys[t->numkeys])]--;
+}
+
+inline int repetition(SEARCHTHREAD *t)
+/*----------> purpose: returns nonzero if the position of thread t, the top of its key
+  ---------->          stack, is a repetition of a position with the same side to
+  ---------->          move since the last irreversible move. */
+{
+	int i, first;
+	uint64_t key;
+
+	key = t->keys[t->numkeys - 1];
+	if (t->keycount[KEYCOUNTSLOT(key)] < 2)
+		return(0);
+
+	/* the first position that can repeat is 4 plies back. */
+	first = t->numkeys - 1 - t->reversible[t->numkeys - 1];
+	for (i = t->numkeys - 5; i >= first; i -= 2)
+		if (t->keys[i] == key)
+			return(1);
+	return(0);
+}
+
+inline void recorditeration(int depth)
+/*----------> purpose: add the totals of all search threads at the end of an iteration
+  ---------->          to iterationstats. */
+{
+	int k;
+	ITERATIONSTATS *s;
+
+	if (numiterations > MAXDEPTH)
+		return;
+	s = &iterationstats[numiterations++];
+	memset(s, 0, sizeof(ITERATIONSTATS));
+	s->depth = depth;
+	s->time = searchtime();
+	for (k = 0; k < numthreads; k++) {
+		s->nodes += threads[k]->alphabetas;
+		s->qnodes += threads[k]->qnodes;
+		s->hashprobes += threads[k]->hashprobes;
+		s->hashhits += threads[k]->hashhits;
+	}
+}
+
+inline void getstats(char *reply)
+/*----------> purpose: write the iterations of the last search to reply for get stats,
+  ---------->          a header line and one line per iteration with the depth, the
+  ---------->          nodes, the nodes per second, the effective branching factor,
+  ---------->          the percentage of hashtable lookups that found the position,
+  ---------->          the quiescence nodes and the time in seconds. the counts are
+  ---------->          totals since the start of the search, nps counts alphabeta
+  ---------->          and quiescence nodes. the deepest iterations are reported if
+  ---------->          not all fit into the reply. */
+{
+	int i, first;
+	int length;
+	ITERATIONSTATS *s;
+
+	length = sprintf(reply, "depth nodes nps ebf hashhit qnodes time\n");
+	first = max(numiterations - (ENGINECOMMAND_REPLY_SIZE - length) / 96, 0);
+	for (i = first; i < numiterations; i++) {
+		s = &iterationstats[i];
+		length += sprintf(reply + length, "%d %lld %.0f %.2f %.1f %lld %.3f\n",
+						  s->depth,
+						  s->nodes,
+						  (double)(s->nodes + s->qnodes) / max(s->time, 0.001),
+						  (i > 0) ? (double)s->nodes / max(iterationstats[i - 1].nodes, (int64_t)1) : 0.0,
+						  100.0 * s->hashhits / max(s->hashprobes, (int64_t)1),
+						  s->qnodes,
+						  s->time);
+	}
+}
+
+template <class RULES> int bench(int depth, char *reply)
+/*----------> purpose: search the positions of benchpositions[] to depth with the main
+  ---------->          thread only, starting with an empty hashtable and history, and
+  ---------->          write the total nodes and the nodes per second to reply. the
+  ---------->          nodes do not depend on the clock, with the same hashtable size
+  ---------->          and endgame database they are a signature of the engine.
+  ---------->          the game history and the ponder state are restored at the end,
+  ---------->          so that bench can be run during a game. the game only loses
+  ---------->          the hashtable entries of its last search.
+  ----------> returns 1 on success, 0 if a position could not be set up. */
+{
+	int i, d;
+	int b[46], color;
+	int eval, stop, *oldplay;
+	int oldgamelength, oldponderhit;
+	uint64_t oldponderkey, oldexpectedkey;
+	double nodes, time;
+	SEARCHMOVE best, oldexpectedreply;
+	SEARCHTHREAD *t;
+
+	/* nothing stops the search but the depth. */
+	stop = 0;
+	oldplay = play;
+	play = &stop;
+	stopsearch = 0;
+	absolute_maxtime = 1e9;
+
+	/* the bench positions are searched without the game history and ponder state. */
+	oldgamelength = gamelength;
+	oldponderhit = ponderhit;
+	oldponderkey = ponderkey;
+	oldexpectedkey = expectedkey;
+	oldexpectedreply = expectedreply;
+	ponderhit = 0;
+	ponderkey = 0;
+	expectedkey = 0;
+	gamelength = 0;
+	searchid++;
+	memset(hashtable, 0, (hashmask + 1) * sizeof(HASHENTRY));
+
+	t = threads[0];
+	nodes = 0;
+	starttimer();
+	for (i = 0; i < NUMBENCHPOSITIONS; i++) {
+		if (!fentoboard<RULES>(benchpositions[i], b, &color)) {
+			sprintf(reply, "bench position %d is not valid", i + 1);
+			break;
+		}
+		memset(t->history, 0, sizeof(t->history));
+		initsearchthread(t, b, color);
+		eval = firstalphabeta<RULES>(t, 1, -10000, 10000, color, &best);
+		for (d = 2; d <= depth; d++) {
+			memcpy(t->lastpv, t->pv[0], t->pvlength[0] * sizeof(SEARCHMOVE));
+			t->lastpvlength = t->pvlength[0];
+			eval = aspirationsearch<RULES>(t, d, eval, color, &best);
+		}
+		nodes += t->alphabetas + t->qnodes;
+	}
+	time = searchtime();
+
+	play = oldplay;
+	gamelength = oldgamelength;
+	ponderhit = oldponderhit;
+	ponderkey = oldponderkey;
+	expectedkey = oldexpectedkey;
+	expectedreply = oldexpectedreply;
+	if (i < NUMBENCHPOSITIONS)
+		return(0);
+
+	sprintf(reply, "bench depth %d: %d positions, nodes %.0f, time %.2fs, nps %.0f",
+			depth, NUMBENCHPOSITIONS, nodes, time, nodes / max(time, 0.001));
+	return(1);
+}
+
+template <class RULES> int fentoboard(const char *fen, int b[46], int *color)
+/*----------> purpose: set up b and the side to move color from a FEN string like
+  ---------->          "B:W21,22,K31:B1,2,K3". the square numbers are those of the
+  ---------->          rules.
+  ----------> returns 1 on success, 0 if fen is not valid. */
+{
+	int i, square, row, column;
+	int piece, side;
+	const char *p;
+
+	for (i = 0; i < 46; i++)
+		b[i] = OCCUPIED;
+	for (i = 5; i <= 40; i++)
+		if (i % 9 != 0)
+			b[i] = FREE;
+
+	if (fen[0] == 'B')
+		*color = BLACK;
+	else if (fen[0] == 'W')
+		*color = WHITE;
+	else
+		return(0);
+
+	side = 0;
+	for (p = fen + 1; *p; p++) {
+		if (*p == ':') {
+			p++;
+			if (*p == 'B')
+				side = BLACK;
+			else if (*p == 'W')
+				side = WHITE;
+			else
+				return(0);
+			continue;
+		}
+		if (*p == ',')
+			continue;
+		piece = MAN;
+		if (*p == 'K') {
+			piece = KING;
+			p++;
+		}
+		if (side == 0 || *p < '0' || *p > '9')
+			return(0);
+		square = atoi(p);
+		while (p[1] >= '0' && p[1] <= '9')
+			p++;
+		if (square < 1 || square > 32)
+			return(0);
+
+		/* b[46] has 4 squares per row and a gap after every second row. */
+		row = (square - 1) / 4;
+		column = (square - 1) % 4;
+		if (RULES::RIGHTTOLEFT)
+			column = 3 - column;
+		b[5 + 4 * row + column + (row + 1) / 2] = side | piece;
+	}
+	return(1);
+}
+
+/*-------------- MOVE GENERATION ON THE BOARD b[46] --------------------------*/
+template <class RULES> int generatemovelist(int b[46], move2 movelist[MAXMOVES], int color)
+/*----------> purpose:generates all moves. no captures. returns number of moves
+  ----------> version: 1.0
+  ----------> date: 25th october 97 */
+{
+	int n = 0, m;
+	int i;
+
+	if (color == BLACK) {
+		for (i = 5; i <= 40; i++) {
+			if ((b[i] & BLACK) != 0) {
+				if ((b[i] & MAN) != 0) {
+					if ((b[i + 4] & FREE) != 0) {
+						movelist[n].n = 2;
+						if (i >= 32)
+							m = (BLACK | KING);
+						else
+							m = (BLACK | MAN);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i + 4;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (BLACK | MAN);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i + 5] & FREE) != 0) {
+						movelist[n].n = 2;
+						if (i >= 32)
+							m = (BLACK | KING);
+						else
+							m = (BLACK | MAN);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i + 5;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (BLACK | MAN);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+				}
+
+				if ((b[i] & KING) != 0) {
+					if ((b[i + 4] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (BLACK | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i + 4;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (BLACK | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i + 5] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (BLACK | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i + 5;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (BLACK | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i - 4] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (BLACK | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i - 4;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (BLACK | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i - 5] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (BLACK | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i - 5;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (BLACK | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+				}
+			}
+		}
+	}
+	else {
+
+		/* color = WHITE */
+		for (i = 5; i <= 40; i++) {
+			if ((b[i] & WHITE) != 0) {
+				if ((b[i] & MAN) != 0) {
+					if ((b[i - 4] & FREE) != 0) {
+						movelist[n].n = 2;
+						if (i <= 13)
+							m = (WHITE | KING);
+						else
+							m = (WHITE | MAN);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i - 4;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (WHITE | MAN);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i - 5] & FREE) != 0) {
+						movelist[n].n = 2;
+						if (i <= 13)
+							m = (WHITE | KING);
+						else
+							m = (WHITE | MAN);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i - 5;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (WHITE | MAN);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+				}
+
+				if ((b[i] & KING) != 0) {
+
+					/* or else */
+					if ((b[i + 4] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (WHITE | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i + 4;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (WHITE | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i + 5] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (WHITE | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i + 5;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (WHITE | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i - 4] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (WHITE | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i - 4;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (WHITE | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+
+					if ((b[i - 5] & FREE) != 0) {
+						movelist[n].n = 2;
+						m = (WHITE | KING);
+						m = m << 8;
+						m += FREE;
+						m = m << 8;
+						m += i - 5;
+						movelist[n].m[1] = m;
+						m = FREE;
+						m = m << 8;
+						m += (WHITE | KING);
+						m = m << 8;
+						m += i;
+						movelist[n].m[0] = m;
+						n++;
+					}
+				}
+			}
+		}
+	}
+
+	return(n);
+}
+
+template <class RULES> int generatecapturelist(int b[46], move2 movelist[MAXMOVES], int color)
+/*----------> purpose: generate all possible captures
+  ----------> version: 1.0
+  ----------> date: 11th march 01 */
+{
+	int n = 0;
+	int m;
+	int i;
+	int tmp;
+
+	if (color == BLACK) {
+		for (i = 5; i <= 40; i++) {
+			if ((b[i] & BLACK) != 0) {
+				if ((b[i] & MAN) != 0) {
+					if (mancancapture<RULES>(b[i + 4], WHITE)) {
+						if ((b[i + 8] & FREE) != 0) {
+							movelist[n].n = 3;
+							if (i >= 28)
+								m = (BLACK | KING);
+							else
+								m = (BLACK | MAN);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i + 8;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (BLACK | MAN);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i + 4];
+							m = m << 8;
+							m += i + 4;
+							movelist[n].m[2] = m;
+							blackmancapture<RULES>(b, &n, movelist, i + 8);
+						}
+					}
+
+					if (mancancapture<RULES>(b[i + 5], WHITE)) {
+						if ((b[i + 10] & FREE) != 0) {
+							movelist[n].n = 3;
+							if (i >= 28)
+								m = (BLACK | KING);
+							else
+								m = (BLACK | MAN);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i + 10;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (BLACK | MAN);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i + 5];
+							m = m << 8;
+							m += i + 5;
+							movelist[n].m[2] = m;
+							blackmancapture<RULES>(b, &n, movelist, i + 10);
+						}
+					}
+				}
+				else {
+
+					/* b[i] is a KING */
+					if ((b[i + 4] & WHITE) != 0) {
+						if ((b[i + 8] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (BLACK | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i + 8;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (BLACK | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i + 4];
+							m = m << 8;
+							m += i + 4;
+							movelist[n].m[2] = m;
+							tmp = b[i + 4];
+							b[i + 4] = FREE;	/* Remove captured piece. */
+							b[i] = FREE;		/* Remove capturing king. */
+							blackkingcapture<RULES>(b, &n, movelist, i + 8);
+							b[i + 4] = tmp;		/* Restore captured piece. */
+							b[i] = BLACK | KING;	/* Restore capturing king. */
+						}
+					}
+
+					if ((b[i + 5] & WHITE) != 0) {
+						if ((b[i + 10] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (BLACK | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i + 10;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (BLACK | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i + 5];
+							m = m << 8;
+							m += i + 5;
+							movelist[n].m[2] = m;
+							tmp = b[i + 5];
+							b[i + 5] = FREE;
+							b[i] = FREE;			/* Remove capturing king. */
+							blackkingcapture<RULES>(b, &n, movelist, i + 10);
+							b[i + 5] = tmp;
+							b[i] = BLACK | KING;	/* Restore capturing king. */
+						}
+					}
+
+					if ((b[i - 4] & WHITE) != 0) {
+						if ((b[i - 8] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (BLACK | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i - 8;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (BLACK | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i - 4];
+							m = m << 8;
+							m += i - 4;
+							movelist[n].m[2] = m;
+							tmp = b[i - 4];
+							b[i - 4] = FREE;
+							b[i] = FREE;			/* Remove capturing king. */
+							blackkingcapture<RULES>(b, &n, movelist, i - 8);
+							b[i - 4] = tmp;
+							b[i] = BLACK | KING;	/* Restore capturing king. */
+						}
+					}
+
+					if ((b[i - 5] & WHITE) != 0) {
+						if ((b[i - 10] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (BLACK | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i - 10;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (BLACK | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i - 5];
+							m = m << 8;
+							m += i - 5;
+							movelist[n].m[2] = m;
+							tmp = b[i - 5];
+							b[i - 5] = FREE;
+							b[i] = FREE;			/* Remove capturing king. */
+							blackkingcapture<RULES>(b, &n, movelist, i - 10);
+							b[i - 5] = tmp;
+							b[i] = BLACK | KING;	/* Restore capturing king. */
+						}
+					}
+				}
+			}
+		}
+	}
+	else {
+
+		/* color is WHITE */
+		for (i = 5; i <= 40; i++) {
+			if ((b[i] & WHITE) != 0) {
+				if ((b[i] & MAN) != 0) {
+					if (mancancapture<RULES>(b[i - 4], BLACK)) {
+						if ((b[i - 8] & FREE) != 0) {
+							movelist[n].n = 3;
+							if (i <= 17)
+								m = (WHITE | KING);
+							else
+								m = (WHITE | MAN);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i - 8;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (WHITE | MAN);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i - 4];
+							m = m << 8;
+							m += i - 4;
+							movelist[n].m[2] = m;
+							whitemancapture<RULES>(b, &n, movelist, i - 8);
+						}
+					}
+
+					if (mancancapture<RULES>(b[i - 5], BLACK)) {
+						if ((b[i - 10] & FREE) != 0) {
+							movelist[n].n = 3;
+							if (i <= 17)
+								m = (WHITE | KING);
+							else
+								m = (WHITE | MAN);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i - 10;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (WHITE | MAN);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i - 5];
+							m = m << 8;
+							m += i - 5;
+							movelist[n].m[2] = m;
+							whitemancapture<RULES>(b, &n, movelist, i - 10);
+						}
+					}
+				}
+				else {
+
+					/* b[i] is a KING */
+					if ((b[i + 4] & BLACK) != 0) {
+						if ((b[i + 8] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (WHITE | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i + 8;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (WHITE | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i + 4];
+							m = m << 8;
+							m += i + 4;
+							movelist[n].m[2] = m;
+							tmp = b[i + 4];
+							b[i + 4] = FREE;
+							b[i] = FREE;			/* Remove capturing king. */
+							whitekingcapture<RULES>(b, &n, movelist, i + 8);
+							b[i + 4] = tmp;
+							b[i] = WHITE | KING;
+						}
+					}
+
+					if ((b[i + 5] & BLACK) != 0) {
+						if ((b[i + 10] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (WHITE | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i + 10;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (WHITE | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i + 5];
+							m = m << 8;
+							m += i + 5;
+							movelist[n].m[2] = m;
+							tmp = b[i + 5];
+							b[i + 5] = FREE;
+							b[i] = FREE;			/* Remove capturing king. */
+							whitekingcapture<RULES>(b, &n, movelist, i + 10);
+							b[i + 5] = tmp;
+							b[i] = WHITE | KING;
+						}
+					}
+
+					if ((b[i - 4] & BLACK) != 0) {
+						if ((b[i - 8] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (WHITE | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i - 8;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (WHITE | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i - 4];
+							m = m << 8;
+							m += i - 4;
+							movelist[n].m[2] = m;
+							tmp = b[i - 4];
+							b[i - 4] = FREE;
+							b[i] = FREE;			/* Remove capturing king. */
+							whitekingcapture<RULES>(b, &n, movelist, i - 8);
+							b[i - 4] = tmp;
+							b[i] = WHITE | KING;
+						}
+					}
+
+					if ((b[i - 5] & BLACK) != 0) {
+						if ((b[i - 10] & FREE) != 0) {
+							movelist[n].n = 3;
+							m = (WHITE | KING);
+							m = m << 8;
+							m += FREE;
+							m = m << 8;
+							m += i - 10;
+							movelist[n].m[1] = m;
+							m = FREE;
+							m = m << 8;
+							m += (WHITE | KING);
+							m = m << 8;
+							m += i;
+							movelist[n].m[0] = m;
+							m = FREE;
+							m = m << 8;
+							m += b[i - 5];
+							m = m << 8;
+							m += i - 5;
+							movelist[n].m[2] = m;
+							tmp = b[i - 5];
+							b[i - 5] = FREE;
+							b[i] = FREE;			/* Remove capturing king. */
+							whitekingcapture<RULES>(b, &n, movelist, i - 10);
+							b[i - 5] = tmp;
+							b[i] = WHITE | KING;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (RULES::CAPTUREPRIORITY)
+		n = capturepriority(movelist, n);
+
+	return(n);
+}
+
+template <class RULES> void capturesequences(int b[46], int *n, move2 movelist[MAXMOVES], int square, int piece)
+/*----------> purpose: extend the capture in movelist[*n], whose piece stands on square,
+  ---------->          by every sequence of further jumps; each complete sequence is
+  ---------->          stored in movelist and *n is advanced past it.
+  ---------->          the capture tree is walked depth first with an explicit stack,
+  ---------->          in the direction order of the old recursive generator, and the
+  ---------->          partial move is only copied once a sequence is complete.
+  ---------->          kings take their captured pieces off b while they jump on, so
+  ---------->          that no piece is jumped twice; men can only move forward. */
+{
+	static const int kingdirections[4] = {-4, -5, 4, 5};
+	static const int blackdirections[2] = {4, 5};
+	static const int whitedirections[2] = {-4, -5};
+	struct {
+		int square;			/* where the piece stands at this depth. */
+		int next;			/* index of the next direction to try. */
+		int found;			/* nonzero if a jump from here was found. */
+		int captured;		/* square captured by the jump being followed. */
+		int tmp;			/* piece that stood on captured. */
+	} stack[12];
+	const int *directions;
+	int numdirections, color, opponent, king;
+	int sp, over, to, newpiece;
+	move2 move;
+
+	color = piece & (BLACK | WHITE);
+	opponent = color ^ (BLACK | WHITE);
+	king = piece & KING;
+	if (king) {
+		directions = kingdirections;
+		numdirections = 4;
+	}
+	else {
+		directions = (color == BLACK) ? blackdirections : whitedirections;
+		numdirections = 2;
+	}
+
+	move = movelist[*n];
+	sp = 0;
+	stack[0].square = square;
+	stack[0].next = 0;
+	stack[0].found = 0;
+	while (sp >= 0) {
+		if (stack[sp].next == numdirections) {
+
+			/* all jumps from this square are done: a leaf ends a sequence. */
+			if (!stack[sp].found)
+				movelist[(*n)++] = move;
+			if (--sp >= 0) {
+				move.n--;
+				if (king)
+					b[stack[sp].captured] = stack[sp].tmp;
+			}
+			continue;
+		}
+
+		over = stack[sp].square + directions[stack[sp].next++];
+		to = over + (over - stack[sp].square);
+		if (king ? (b[over] & opponent) == 0 : !mancancapture<RULES>(b[over], opponent))
+			continue;
+		if ((b[to] & FREE) == 0)
+			continue;
+
+		if (king)
+			newpiece = color | KING;
+		else if (color == BLACK)
+			newpiece = (stack[sp].square >= 28) ? (BLACK | KING) : (BLACK | MAN);
+		else
+			newpiece = (stack[sp].square <= 17) ? (WHITE | KING) : (WHITE | MAN);
+		move.m[1] = (newpiece << 16) + (FREE << 8) + to;
+		move.m[move.n++] = (FREE << 16) + (b[over] << 8) + over;
+		stack[sp].found = 1;
+		stack[sp].captured = over;
+		stack[sp].tmp = b[over];
+		if (king)
+			b[over] = FREE;
+
+		sp++;
+		stack[sp].square = to;
+		stack[sp].next = 0;
+		stack[sp].found = 0;
+	}
+}
+
+template <class RULES> inline void blackmancapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+{
+	capturesequences<RULES>(b, n, movelist, i, BLACK | MAN);
+}
+
+template <class RULES> inline void blackkingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+{
+	capturesequences<RULES>(b, n, movelist, i, BLACK | KING);
+}
+
+template <class RULES> inline void whitemancapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+{
+	capturesequences<RULES>(b, n, movelist, i, WHITE | MAN);
+}
+
+template <class RULES> inline void whitekingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+{
+	capturesequences<RULES>(b, n, movelist, i, WHITE | KING);
+}
+
+template <class RULES> int testcapture(int b[46], int color)
+/*----------> purpose: test if color has a capture on b
+  ----------> version: 1.0
+  ----------> date: 25th october 97 */
+{
+	int i;
+
+	if (color == BLACK) {
+		for (i = 5; i <= 40; i++) {
+			if ((b[i] & BLACK) != 0) {
+				if ((b[i] & MAN) != 0) {
+					if (mancancapture<RULES>(b[i + 4], WHITE)) {
+						if ((b[i + 8] & FREE) != 0)
+							return(1);
+					}
+
+					if (mancancapture<RULES>(b[i + 5], WHITE)) {
+						if ((b[i + 10] & FREE) != 0)
+							return(1);
+					}
+				}
+				else {
+
+					/* b[i] is a KING */
+					if ((b[i + 4] & WHITE) != 0) {
+						if ((b[i + 8] & FREE) != 0)
+							return(1);
+					}
+
+					if ((b[i + 5] & WHITE) != 0) {
+						if ((b[i + 10] & FREE) != 0)
+							return(1);
+					}
+
+					if ((b[i - 4] & WHITE) != 0) {
+						if ((b[i - 8] & FREE) != 0)
+							return(1);
+					}
+
+					if ((b[i - 5] & WHITE) != 0) {
+						if ((b[i - 10] & FREE) != 0)
+							return(1);
+					}
+				}
+			}
+		}
+	}
+	else {
+
+		/* color is WHITE */
+		for (i = 5; i <= 40; i++) {
+			if ((b[i] & WHITE) != 0) {
+				if ((b[i] & MAN) != 0) {
+					if (mancancapture<RULES>(b[i - 4], BLACK)) {
+						if ((b[i - 8] & FREE) != 0)
+							return(1);
+					}
+
+					if (mancancapture<RULES>(b[i - 5], BLACK)) {
+						if ((b[i - 10] & FREE) != 0)
+							return(1);
+					}
+				}
+				else {
+
+					/* b[i] is a KING */
+					if ((b[i + 4] & BLACK) != 0) {
+						if ((b[i + 8] & FREE) != 0)
+							return(1);
+					}
+
+					if ((b[i + 5] & BLACK) != 0) {
+						if ((b[i + 10] & FREE) != 0)
+							return(1);
+					}
+
+					if ((b[i - 4] & BLACK) != 0) {
+						if ((b[i - 8] & FREE) != 0)
+							return(1);
+					}
+
+					if ((b[i - 5] & BLACK) != 0) {
+						if ((b[i - 10] & FREE) != 0)
+							return(1);
+					}
+				}
+			}
+		}
+	}
+
+	return(0);
+}
+
+template <class RULES> inline int mancancapture(int piece, int opponent)
+/*----------> purpose: returns nonzero if a man can capture piece, a piece of the
+  ---------->          color opponent. */
+{
+	if (RULES::MANCAPTURESKING)
+		return(piece & opponent);
+	return(piece == (opponent | MAN));
+}
+
+inline int capturepriority(move2 movelist[MAXMOVES], int n)
+/*----------> purpose: remove the captures of movelist that the italian rules do not
+  ---------->          allow:
+  ---------->          -> the maximum number of pieces must be captured
+  ---------->          -> if that is possible with a man or a king, it must be done with the king
+  ---------->          -> if there are multiple possibilites, it must take as many kings as possible
+  ---------->          -> if there are multiple possibilites, it must take a king as early as possible
+  ----------> returns the number of captures that are left. */
+{
+	int i, j;
+	int tmp, max;
+	int n2;
+	int ismove[MAXMOVES];
+
+	/* capture max */
+	for (i = 0; i < n; i++)
+		ismove[i] = 1;
+
+	max = 0;
+
+	for (i = 0; i < n; i++) {
+		if (movelist[i].n > max)
+			max = movelist[i].n;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (movelist[i].n < max) {
+			ismove[i] = 0;
+		}
+	}
+
+	/* capture with king if multiple possibilities*/
+	max = 0;
+
+	for (i = 0; i < n; i++) {
+		if (!ismove[i])
+			continue;
+
+		if (((movelist[i].m[0] >> 8) % 256) & KING)
+			max = 1;
+	}
+
+	if (max == 1) {
+		for (i = 0; i < n; i++) {
+			if (!(((movelist[i].m[0] >> 8) % 256) & KING))
+				ismove[i] = 0;
+		}
+	}
+
+	/* capture maximum number of kings */
+	max = 0;
+	for (i = 0; i < n; i++) {
+		if (!ismove[i])
+			continue;
+		tmp = 0;
+		for (j = 2; j < movelist[i].n; j++) {
+			if (((movelist[i].m[j] >> 8) % 256) & KING)
+				tmp++;
+		}
+
+		if (tmp > max)
+			max = tmp;
+	}
+
+	if (max > 0) {
+		for (i = 0; i < n; i++) {
+			if (!ismove[i])
+				continue;
+			tmp = 0;
+			for (j = 2; j < movelist[i].n; j++) {
+				if (((movelist[i].m[j] >> 8) % 256) & KING)
+					tmp++;
+			}
+
+			if (tmp < max)
+				ismove[i] = 0;
+		}
+	}
+
+	/* capture king as early as possible */
+
+	/* for all moves: tmp is the earliest jump */
+
+	/* max is the smallest of the earliest jumps*/
+
+	/* eyg bug fix. Each king capture must be the earliest possible, not just the first
+	 * king capture. In this pos, W:WK30:BK26,K27,K18,20,10,K12 30x5 is the only legal move.
+	 * I changed temp to be the binary weighted sum of king captures, where
+	 * the weight of the nth capture is (1 << n).
+	 */
+	max = 65535;
+	for (i = 0; i < n; i++) {
+		if (!ismove[i])
+			continue;
+		tmp = 0;
+		for (j = movelist[i].n - 1; j >= 2; j--) {
+			if (((movelist[i].m[j] >> 8) % 256) & KING)
+				tmp += (1 << j);
+		}
+
+		if (tmp < max)
+			max = tmp;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (!ismove[i])
+			continue;
+		tmp = 0;
+		for (j = movelist[i].n - 1; j >= 2; j--) {
+			if (((movelist[i].m[j] >> 8) % 256) & KING)
+				tmp += (1 << j);
+		}
+
+		if (tmp > max)
+			ismove[i] = 0;
+	}
+
+	/* clean up movelist */
+	n2 = 0;
+	for (i = 0; i < n; i++) {
+		if (ismove[i]) {
+			movelist[n2] = movelist[i];
+			n2++;
+		}
+	}
+
+	return(n2);
+}
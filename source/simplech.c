@@ -65,11 +65,14 @@
 #include <ShlObj.h>
 #include <Shlwapi.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <windows.h>
 #include "cb_interface.h"
 #include "enginedefs.h"
+#include "../bitboard.h"
+#include "../lsb.h"
 
 #define VERSION "1.15"
 
@@ -83,12 +86,66 @@
 #define FREE 16
 
 #define MAXDEPTH 99
+#define MAXPLY 128				/* maximum search ply including capture extensions. */
+
+/* hashtable entry bound types */
+#define HASH_EXACT 1
+#define HASH_LOWER 2			/* value is a lower bound, the search failed high. */
+#define HASH_UPPER 3			/* value is an upper bound, the search failed low. */
+
+#define DEFAULT_HASHSIZE_MB 32
+#define NO_MOVE 255
+
+/* endgame database, see part V */
+#define MAXDBPIECES 4
+#define DEFAULT_DBMBYTES 64
+#define DBBLOCKSIZE 1024
+#define DB_UNKNOWN 0
+#define DB_WIN 1				/* results of dblookup(), from the point of view of black. */
+#define DB_LOSS 2
+#define DB_DRAW 3
+#define DBWIN 2000				/* value of a database win. the evaluation is added so that the winner makes progress. */
+
+/* opening book, see part VI */
+#define DEFAULT_BOOKFILE "simplech.bok"
+#define BOOKMAGIC 0x4b424353	/* "SCBK", the first 4 bytes of a book file. */
+#define MAXBOOKPLY 30			/* makebook() puts the first 30 plies of each game in the book. */
+#define GOODMOVEMARGIN 10		/* a good book move scores at most 10 percent less than the best one. */
+
+/* fields of the data word of a hashtable entry */
+#define HASHVALUE(data) ((short)((data) & 0xffff))
+#define HASHDEPTH(data) ((int)(((data) >> 16) & 0xff))
+#define HASHBOUND(data) ((int)(((data) >> 24) & 0xff))
+#define HASHBEST(data) ((int)(((data) >> 32) & 0xff))
+#define HASHSEARCHID(data) ((unsigned char)((data) >> 40))
+
+#define MAXTHREADS 64
+#define ASPIRATIONWINDOW 20		/* a fifth of a man. */
+#define MAXMULTIPV 10			/* most best moves that set multipv can ask for. */
+#define PONDERGUESSTIME 0.1		/* seconds to find the opponent's reply if the last search did not expect this position. */
+#define MAXGAMEPLY 1024			/* positions of the game kept for the repetition detection. */
+#define KEYCOUNTSLOTS 1024		/* size of the keycount[] filter of the key stack, a power of 2. */
+#define NUMBENCHPOSITIONS 8
+#define BENCHDEPTH 15			/* depth of the bench command if it has none. */
+
+/* bitboard masks, see part IV */
+#define EVENROWS 0x0f0f0f0f
+#define ODDROWS 0xf0f0f0f0
+#define LEFTEDGE 0x01010101
+#define RIGHTEDGE 0x80808080
+#define PROMOTEBLACK 0xf0000000
+#define PROMOTEWHITE 0x0000000f
+#define CENTER 0x00666600
+#define EDGE 0xf181818f
+#define SAFEEDGE 0x11000088
 
 /*----------> compile options  */
 #undef MUTE
 #undef VERBOSE
 #define STATISTICS
 #define LOG_TIME_MGMT
+#define LOGNAME "Simplech"		/* the time management log is Simplech.log in the folder Simplech. */
+#undef CHECKEVAL				/* compare the incremental evaluation terms with a full recomputation at every leaf */
 
 /*----------> function prototypes  */
 
@@ -114,72 +171,282 @@ int WINAPI getmove
 void movetonotation(move2 move, char str[80]);
 
 /*----------> part II: search */
-int checkers(int b[46], int color, double maxtime, char *str);
-int alphabeta(int b[46], int depth, int alpha, int beta, int color);
-int firstalphabeta(int b[46], int depth, int alpha, int beta, int color, move2 *best);
+struct SEARCHTHREAD;
+struct BBMOVE;
+void setthreadposition(SEARCHTHREAD *t, int b[46], int color);
 void domove(int b[46], move2 &move);
 void undomove(int b[46], move2 &move);
-int evaluation(int b[46], int color);
+void domove(SEARCHTHREAD *t, BBMOVE &move);
+void undomove(SEARCHTHREAD *t, BBMOVE &move);
+void xormove(SEARCHTHREAD *t, BBMOVE &move);
+uint64_t hashposition(int b[46], int color);
+uint64_t hashposition(pos *p, int color);
+uint64_t hashdelta(pos *delta);
+int samemove(BBMOVE &a, BBMOVE &b);
 
 /*----------> part III: move generation */
 int generatemovelist(int b[46], move2 movelist[MAXMOVES], int color);
 int generatecapturelist(int b[46], move2 movelist[MAXMOVES], int color);
-void blackmancapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-void blackkingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-void whitemancapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-void whitekingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int square);
-int testcapture(int b[46], int color);
 
-/*----------> globals  */
+/*----------> part IV: bitboards */
+void addgameposition(int b[46], int color);
+void boardtopos(int b[46], pos *p);
+void tomove2(BBMOVE &move, int color, move2 *m);
+int generatemovelist(pos *p, BBMOVE movelist[MAXMOVES], int color);
+void addmove(BBMOVE movelist[MAXMOVES], int *n, pos *p, int color, uint32_t from, uint32_t to);
+int generatecapturelist(pos *p, BBMOVE movelist[MAXMOVES], int color);
+void mancapture(pos *p, int *n, BBMOVE movelist[MAXMOVES], BBMOVE &move, uint32_t square, uint32_t opp, uint32_t empty, int color, int first);
+void kingcapture(pos *p, int *n, BBMOVE movelist[MAXMOVES], BBMOVE &move, uint32_t square, uint32_t opp, uint32_t empty, int color, int first);
+void addcapture(pos *p, BBMOVE &move, uint32_t square, int color);
+int testcapture(pos *p, int color);
+int testcapture(SEARCHTHREAD *t, int color);
+int generatemovelist(SEARCHTHREAD *t, BBMOVE movelist[MAXMOVES], int color);
+int generatecapturelist(SEARCHTHREAD *t, BBMOVE movelist[MAXMOVES], int color);
+int &historyentry(SEARCHTHREAD *t, BBMOVE &move, int color);
+void initevaluation(void);
+void evalterms(pos *p, int count[4], int *psq, int *tempo);
+int evaluation(SEARCHTHREAD *t, int color);
+
+/*----------> part V: endgame database */
+struct DBSLICE;
+void initdb(void);
+void freedb(void);
+int setdbmbytes(int megabytes);
+int readdbindex(int pieces);
+int dblookup(pos *p, int color);
+int dbvalue(SEARCHTHREAD *t, int result, int color);
+int dbdecode(DBSLICE *slice, uint32_t index);
+uint32_t dbrank(uint32_t x, uint32_t occupied);
+uint32_t reversebits(uint32_t x);
+
+/*----------> part VI: opening book */
+struct BOOKENTRY;
+void bookpath(char path[MAX_PATH]);
+void openbook(void);
+void closebook(void);
+int makebook(char *pdnfile, char *reply);
+int addbookgame(char *movetext, int blackscore, BOOKENTRY **entries, int *n, int *allocated);
+int compareentries(const void *a, const void *b);
+
+/*----------> structs  */
+struct HASHENTRY {
+	uint64_t check;			/* zobrist key xor data. */
+	uint64_t data;			/* value, depth, bound, best move index and search id, see HASHVALUE() etc. */
+};
+
+/* a move on the bitboards. the move is executed and taken back by xoring delta
+   onto the position. from and to are bit numbers. */
+struct BBMOVE {
+	pos delta;
+	unsigned char from;
+	unsigned char to;
+};
+
+typedef BBMOVE SEARCHMOVE;			/* the move type of the search in searchcore.h. */
+
+/* the state of one search thread. all threads search the same root position and
+   share nothing but the hashtable. thread 0 is the main thread, it checks the
+   time and its result is played. */
+struct SEARCHTHREAD {
+	pos p;
+	int color;
+	int id;
+	uint64_t hashkey;				/* key of the current search position, updated by domove() and undomove(). */
+	int64_t alphabetas;
+	int64_t qnodes;					/* nodes of the quiescence search, not counted in alphabetas. */
+	int maxqdepth;					/* longest capture sequence searched by the quiescence search. */
+	int64_t hashprobes, hashhits;	/* lookups, and lookups that found the position. */
 #ifdef STATISTICS
-int generatemovelists, evaluations, generatecapturelists, testcaptures;
+	int64_t generatemovelists, evaluations, generatecapturelists, testcaptures;
+	int64_t failhighs, failhighsfirst;	/* beta cutoffs, and beta cutoffs by the first move searched. */
+	int64_t pvssearches, pvsresearches;	/* null window searches, and how many of them had to be searched again. */
+	int aspresearches;				/* root searches repeated because the value was outside the aspiration window. */
+	int64_t dbhits;					/* nodes whose value was found in the endgame database. */
+#endif
+
+	/* the evaluation terms that are sums over the pieces, kept up to date by domove()
+	   and undomove(). see evalterms(). */
+	int count[4];					/* number of pieces, indexed like the bitboards bm, bk, wm, wk. */
+	int psq;						/* center and edge terms. */
+	int tempo;
+
+	/* database result of the root position if it is a win for one side, else DB_UNKNOWN,
+	   and its number of pieces. see alphabeta(). */
+	int rootresult;
+	int rootpieces;
+#ifdef CHECKEVAL
+	int evalerrors;					/* leaves where the terms differed from a full recomputation. */
 #endif
-int alphabetas;
+
+	/* move ordering: the principal variation of the last iteration is searched first,
+	   then the hashtable move, then two killer moves per ply, then the other moves
+	   sorted by the history table. */
+	BBMOVE pv[MAXPLY][MAXPLY];		/* triangular pv table, pv[ply][ply..] is the pv from ply. */
+	int pvlength[MAXPLY];
+	BBMOVE lastpv[MAXPLY];			/* pv of the last completed iteration. */
+	int lastpvlength;
+	int followpv;					/* nonzero while the search is on the path of lastpv. */
+	BBMOVE killers[MAXPLY][2];
+	int history[2][32][32];			/* indexed by color - 1, from bit, to bit. */
+
+	/* multipv: the root moves sorted by their values in the last completed iteration,
+	   the first multipv values are exact. see multipvsearch(). */
+	BBMOVE rootmoves[MAXMOVES];
+	int rootvalues[MAXMOVES];
+	int numrootmoves;
+
+	/* repetition detection: the keys of the game since its last irreversible move
+	   and of the search path. see repetition(). */
+	uint64_t keys[MAXGAMEPLY + MAXPLY];
+	int reversible[MAXGAMEPLY + MAXPLY];	/* number of reversible moves that led to keys[i]. */
+	int numkeys;
+	unsigned short keycount[KEYCOUNTSLOTS];
+};
+
+/* a slice of the endgame database holds all positions with the same number of men and
+   kings of each color, the same rank of the most advanced black and white man, and the
+   same side to move. it is stored in 1024 byte blocks of a .cpr file, starting at offset
+   in block firstblock. */
+struct DBSLICE {
+	int value;						/* DB_WIN, DB_LOSS or DB_DRAW if all positions of the slice have this value, else DB_UNKNOWN. */
+	int file;						/* number of pieces of the .cpr file, 0 if the slice is not in the database. */
+	int firstblock;
+	int offset;
+	int nblocks;					/* number of further blocks of the slice. */
+	uint32_t *blockstart;			/* index of the first position in each of the further blocks. */
+};
+
+/* an entry of the opening book: a move that was played in a position, the number of
+   games in which it was played, and the score of the side that played it in these
+   games, 2 for a win and 1 for a draw. a book file is a BOOKHEADER followed by the
+   entries, sorted by key and move. */
+struct BOOKENTRY {
+	uint64_t key;					/* hashposition() of the position. */
+	unsigned char from;				/* bit numbers, like BBMOVE. */
+	unsigned char to;
+	unsigned short games;
+	uint32_t score;
+};
+
+struct BOOKHEADER {
+	uint32_t magic;					/* BOOKMAGIC. */
+	uint32_t entries;
+};
+
+/* the totals of all search threads when an iteration of checkers() was completed,
+   get stats reports them. */
+struct ITERATIONSTATS {
+	int depth;
+	int64_t nodes;
+	int64_t qnodes;
+	int64_t hashprobes;
+	int64_t hashhits;
+	double time;					/* seconds since the start of the search. */
+};
+
+/*----------> globals  */
 int value[17] = { 0, 0, 0, 0, 0, 1, 256, 0, 0, 16, 4096, 0, 0, 0, 0, 0, 0 };
 int *play;
-clock_t starttime;
+LARGE_INTEGER starttime;			/* the search time is wall clock time from QueryPerformanceCounter(). */
+double counterfrequency;
 double absolute_maxtime;
 
+/* zobrist keys, indexed by bitboard (bm, bk, wm, wk) and bit number. */
+uint64_t zobrist[4][32];
+uint64_t zobrist_color;
+
+/* piece-square tables of the evaluation terms kept by domove(), indexed like the
+   zobrist keys. set up by initevaluation(). */
+int psqvalue[4][32];
+int tempovalue[4][32];
+
+/* the hashtable is shared by all search threads without locking. an entry is only
+   used if check ^ data is the key of the position, so that an entry torn by two
+   threads writing it at the same time is not found. */
+HASHENTRY *hashtable;
+uint32_t hashmask;
+int hashsize_MB = DEFAULT_HASHSIZE_MB;
+unsigned char searchid;
+
+SEARCHTHREAD *threads[MAXTHREADS];
+int numthreads = 1;
+int multipv = 1;					/* number of best moves with exact values, see multipvsearch(). */
+volatile int stopsearch;			/* set by the main thread to stop the helper threads. */
+ITERATIONSTATS iterationstats[MAXDEPTH + 1];	/* the iterations of the last search. */
+int numiterations;
+
+/* pondering: checkers() remembers the reply it expects to its move, ponder() remembers
+   the position it searched. if the next search is of that position, it is a ponder hit
+   and keeps the hashtable entries, killers and history of the ponder search. */
+uint64_t expectedkey;				/* key of the position after the move of the last search, 0 if none. */
+BBMOVE expectedreply;
+uint64_t ponderkey;					/* key of the position of the last ponder search, 0 if none. */
+int ponderhit;
+
+/* the game history: the keys of the positions that CheckerBoard sent and that the
+   engine played since CB_RESET_MOVES, for the repetition detection. */
+uint64_t gamekeys[MAXGAMEPLY];
+int gamereversible[MAXGAMEPLY];		/* number of reversible moves that led to gamekeys[i]. */
+int gamelength;
+pos gameposition;					/* the last position added by addgameposition(). */
+
+/* the test positions of the bench command, see bench(). */
+const char *benchpositions[NUMBENCHPOSITIONS] = {
+	"B:W21,22,23,24,25,26,27,28,29,30,31,32:B1,2,3,4,5,6,7,8,9,10,11,12",
+	"W:W18,19,21,23,24,26,29,30,31,32:B1,2,3,5,6,7,9,10,12,14",
+	"B:W14,18,22,25,26,27,29,30,31,32:B1,2,3,5,6,7,8,10,12,15",
+	"W:W17,21,22,23,25,26,27,29,30,31,32:B1,2,3,4,5,6,7,9,10,11,14",
+	"B:W15,19,22,23,26,27,30,31:B2,5,6,9,10,12,13,16",
+	"B:WK6,20,24,27,28:B3,K10,13,K14,15",
+	"W:W20,K27,28,32:B5,K9,12,K23",
+	"W:WK3,K5:BK30,K26",
+};
+
+/* the endgame database db2 - db4 is read on the first search. the slices of a material
+   are indexed by (black man rank * 8 + white man rank) * 2 + side to move. the blocks
+   of the .cpr files are read on demand into a cache of dbmbytes MB that all search
+   threads share, dbcachelock guards it. */
+char dbpath[MAX_PATH];
+int dbmbytes = DEFAULT_DBMBYTES;
+int dbinitialized;
+int dbpieces;						/* the database is probed in positions with at most dbpieces pieces, 0 if none. */
+DBSLICE *dbslices[MAXDBPIECES][MAXDBPIECES][MAXDBPIECES][MAXDBPIECES];	/* indexed by bm, bk, wm, wk. */
+FILE *dbfile[MAXDBPIECES + 1];
+int dbfirstblock[MAXDBPIECES + 1];	/* number of the first block of each file, the blocks of all files are numbered together. */
+int dbblocks;
+uint32_t binomial[33][MAXDBPIECES + 1];
+unsigned char *dbcache;
+int dbcacheslots;
+int *dbcacheblock;					/* block held by each slot of the cache, -1 if none. */
+unsigned int *dbcacheused;			/* last use of each slot, the least recently used slot is replaced. */
+unsigned int dbcacheclock;
+int *dbblockslot;					/* slot of each block, -1 if it is not in the cache. */
+CRITICAL_SECTION dbcachelock;
+
+/* the opening book file is mapped into memory on the first search. a relative
+   bookfile is in the folder of the engine. */
+char enginedirectory[MAX_PATH];
+char bookfile[MAX_PATH] = DEFAULT_BOOKFILE;
+int bookmode = CB_BOOK_GOOD_MOVES;
+int bookinitialized;
+HANDLE bookfilehandle = INVALID_HANDLE_VALUE;
+HANDLE bookmapping;
+BOOKHEADER *bookheader;				/* the mapped book file, the entries follow the header. */
+BOOKENTRY *book;
+int booksize;						/* number of entries, 0 if there is no book. */
+uint64_t bookrandom;				/* state of the random numbers that choose a book move. */
+const char *booknames[4] = { "off", "all kinds of moves", "good moves", "best moves" };
+
 #ifdef LOG_TIME_MGMT
 char logfilename[MAX_PATH];
+#endif
 
-void init_logfile()
-{
-	FILE *fp;
-	char path[MAX_PATH];
-
-	/* Create directories for Simplech under My Documents. */
-	if (SUCCEEDED(SHGetFolderPath(NULL, CSIDL_PERSONAL, NULL, 0, path))) {
-
-		/* Create the directories under My Documents. */
-		PathAppend(path, "Martin Fierz");
-		CreateDirectory(path, NULL);
-
-		PathAppend(path, "Simplech");
-		CreateDirectory(path, NULL);
-	}
-	sprintf(logfilename, "%s\\Simplech.log", path);
-	fp = fopen(logfilename, "w");
-	fclose(fp);
-}
-
-void log(const char *fmt, ...)
-{
-	FILE *fp;
-	va_list args;
-	va_start(args, fmt);
-
-	if (fmt == NULL)
-		return;
-
-	fp = fopen(logfilename, "a");
-	if (fp == NULL)
-		return;
+/*----------> the search and the move generation shared with dama.c */
+#include "searchcore.h"
 
-	vfprintf(fp, fmt, args);
-	fclose(fp);
-}
-#endif
+typedef ENGLISHRULES RULES;
+template <> int databasevalue<ENGLISHRULES>(SEARCHTHREAD *t, int color, int progress, int *value);
+template <> int bookmove<ENGLISHRULES>(int b[46], int color, char *str);
 
 /*-------------- PART 1: dll stuff -------------------------------------------*/
 BOOL WINAPI DllMain(HANDLE hDLL, DWORD dwReason, LPVOID lpReserved)
@@ -187,16 +454,37 @@ BOOL WINAPI DllMain(HANDLE hDLL, DWORD dwReason, LPVOID lpReserved)
 	/* in a dll you used to have LibMain instead of WinMain in windows programs, or main
    in normal C programs
    win32 replaces LibMain with DllEntryPoint.*/
+	int i;
+
 	switch (dwReason) {
 	case DLL_PROCESS_ATTACH:
 		/* dll loaded. put initializations here! */
 #ifdef LOG_TIME_MGMT
 		init_logfile();
 #endif
+		inithashkeys();
+		initevaluation();
+
+		/* the endgame database is in the db folder next to the engines folder. */
+		InitializeCriticalSection(&dbcachelock);
+		GetModuleFileName((HMODULE)hDLL, enginedirectory, MAX_PATH);
+		PathRemoveFileSpec(enginedirectory);
+		sprintf(dbpath, "%s", enginedirectory);
+		PathAppend(dbpath, "..\\db");
+		bookrandom = GetTickCount() | 1;
 		break;
 
 	case DLL_PROCESS_DETACH:
 		/* program is unloading dll. put clean up here! */
+		free(hashtable);
+		hashtable = NULL;
+		for (i = 0; i < MAXTHREADS; i++) {
+			free(threads[i]);
+			threads[i] = NULL;
+		}
+		freedb();
+		DeleteCriticalSection(&dbcachelock);
+		closebook();
 		break;
 
 	case DLL_THREAD_ATTACH:
@@ -218,6 +506,8 @@ int WINAPI enginecommand(char str[256], char reply[256])
 	// Simple Checkers does not answer to some of the commands,
 	// eg it has no engine options.
 	char command[256], param1[256], param2[256];
+	char *path;
+	int depth;
 
 	sscanf(str, "%s %s %s", command, param1, param2);
 
@@ -239,25 +529,152 @@ int WINAPI enginecommand(char str[256], char reply[256])
 
 	if (strcmp(command, "set") == 0) {
 		if (strcmp(param1, "hashsize") == 0) {
-			sprintf(reply, "?");
-			return 0;
+			if (!sethashsize(atoi(param2))) {
+				sprintf(reply, "?");
+				return 0;
+			}
+
+			sprintf(reply, "%d", hashsize_MB);
+			return 1;
+		}
+
+		if (strcmp(param1, "searchthreads") == 0 || strcmp(param1, "threads") == 0) {
+			if (!setsearchthreads(atoi(param2))) {
+				sprintf(reply, "?");
+				return 0;
+			}
+
+			sprintf(reply, "%d", numthreads);
+			return 1;
+		}
+
+		if (strcmp(param1, "multipv") == 0) {
+			if (atoi(param2) < 1 || atoi(param2) > MAXMULTIPV) {
+				sprintf(reply, "?");
+				return 0;
+			}
+
+			multipv = atoi(param2);
+			sprintf(reply, "%d", multipv);
+			return 1;
+		}
+
+		/* CheckerBoard shows a non-empty reply to dbmbytes in a message box. */
+		if (strcmp(param1, "dbmbytes") == 0) {
+			if (!setdbmbytes(atoi(param2))) {
+				sprintf(reply, "not enough memory for a %s MB endgame database cache", param2);
+				return 0;
+			}
+
+			reply[0] = 0;
+			return 1;
+		}
+
+		if (strcmp(param1, "dbpath") == 0) {
+			for (path = str + strlen("set dbpath"); *path == ' '; path++)
+				;
+			freedb();
+			sprintf(dbpath, "%s", path);
+			sprintf(reply, "%s", dbpath);
+			return 1;
 		}
 
+		/* CheckerBoard shows the reply to book in the status bar. */
 		if (strcmp(param1, "book") == 0) {
+			if (atoi(param2) < CB_BOOK_NONE || atoi(param2) > CB_BOOK_BEST_MOVES) {
+				sprintf(reply, "?");
+				return 0;
+			}
+
+			bookmode = atoi(param2);
+			sprintf(reply, "book: %s", booknames[bookmode]);
+			return 1;
+		}
+
+		if (strcmp(param1, "bookfile") == 0) {
+			for (path = str + strlen("set bookfile"); *path == ' '; path++)
+				;
+			closebook();
+			sprintf(bookfile, "%s", path);
+			sprintf(reply, "%s", bookfile);
+			return 1;
+		}
+	}
+
+	/* makebook <pdn file> makes the book file from the games of the pdn file. */
+	if (strcmp(command, "makebook") == 0) {
+		for (path = str + strlen("makebook"); *path == ' '; path++)
+			;
+		return(makebook(path, reply));
+	}
+
+	/* bench [depth] searches the test positions to a fixed depth, see bench(). */
+	if (strcmp(command, "bench") == 0) {
+		depth = BENCHDEPTH;
+		sscanf(str, "%*s %d", &depth);
+		if (depth < 1 || depth > MAXDEPTH) {
 			sprintf(reply, "?");
 			return 0;
 		}
+
+		if (hashtable == NULL)
+			sethashsize(hashsize_MB);
+		if (hashtable == NULL || (threads[0] == NULL && !setsearchthreads(numthreads))) {
+			sprintf(reply, "not enough memory for the search");
+			return 0;
+		}
+		if (!dbinitialized)
+			initdb();
+		return(bench<RULES>(depth, reply));
 	}
 
 	if (strcmp(command, "get") == 0) {
 		if (strcmp(param1, "hashsize") == 0) {
-			sprintf(reply, "?");
-			return 0;
+			sprintf(reply, "%d", hashsize_MB);
+			return 1;
+		}
+
+		if (strcmp(param1, "searchthreads") == 0 || strcmp(param1, "threads") == 0) {
+			sprintf(reply, "%d", numthreads);
+			return 1;
+		}
+
+		if (strcmp(param1, "multipv") == 0) {
+			sprintf(reply, "%d", multipv);
+			return 1;
+		}
+
+		if (strcmp(param1, "dbmbytes") == 0) {
+			sprintf(reply, "%d", dbmbytes);
+			return 1;
+		}
+
+		if (strcmp(param1, "dbpath") == 0) {
+			sprintf(reply, "%s", dbpath);
+			return 1;
+		}
+
+		if (strcmp(param1, "cpus") == 0) {
+			SYSTEM_INFO sysinfo;
+
+			GetSystemInfo(&sysinfo);
+			sprintf(reply, "%d", sysinfo.dwNumberOfProcessors);
+			return 1;
 		}
 
 		if (strcmp(param1, "book") == 0) {
-			sprintf(reply, "?");
-			return 0;
+			sprintf(reply, "%d", bookmode);
+			return 1;
+		}
+
+		if (strcmp(param1, "bookfile") == 0) {
+			sprintf(reply, "%s", bookfile);
+			return 1;
+		}
+
+		if (strcmp(param1, "stats") == 0) {
+			getstats(reply);
+			return 1;
 		}
 
 		if (strcmp(param1, "protocolversion") == 0) {
@@ -269,6 +686,11 @@ int WINAPI enginecommand(char str[256], char reply[256])
 			sprintf(reply, "21");
 			return 1;
 		}
+
+		if (strcmp(param1, "ponder") == 0) {
+			sprintf(reply, "1");
+			return 1;
+		}
 	}
 
 	sprintf(reply, "?");
@@ -302,16 +724,16 @@ int WINAPI getmove
    			would like your engine to play immediately, this value is nonzero,
             else zero. you should respond to a nonzero value of *playnow by
             interrupting your search IMMEDIATELY.
+   info		has the bits CB_RESET_MOVES, CB_EXACT_TIME, the incremental time mode
+   			and CB_PONDER. with CB_PONDER, color is the opponent and the engine
+            searches on its time until *playnow is set, see ponder().
    CBmove *move
    			is unused here. this parameter would allow engines playing different
             versions of checkers to return a move to CB. for engines playing
             english checkers this is not necessary.
             */
 	int i;
-	int value;
-	bool incremental;
-	double desired, new_iter_maxtime;
-	double remaining, increment;
+	int result;
 	int board[46];
 
 	/* initialize board */
@@ -370,40 +792,13 @@ int WINAPI getmove
 
 	play = playnow;
 
-	starttime = clock();
-	if (incremental = get_incremental_times(info, moreinfo, &increment, &remaining)) {
-		if (remaining < increment) {
-			desired = remaining / 1.5;
-			absolute_maxtime = remaining;
-			new_iter_maxtime = 0.7 * absolute_maxtime / 1.5;
-		}
-		else {
-			desired = increment + remaining / 9;
-			absolute_maxtime = min(1.5 * desired, remaining);
-			new_iter_maxtime = 0.7 * absolute_maxtime / 1.5;
-		}
-
-		/* Allow a few msec for overhead. */
-		if (absolute_maxtime > .01)
-			absolute_maxtime -= .003;
-	}
-	else {
-		/* Using fixed time per move. These params result in an average search time of maxtime. */
-		new_iter_maxtime = 0.59 * maxtime;
-		absolute_maxtime = 3 * maxtime;
-	}
-
-	value = checkers(board, color, new_iter_maxtime, str);
+	/* the endgame database and the opening book are read on the first search. */
+	if (!dbinitialized)
+		initdb();
+	if (!bookinitialized)
+		openbook();
+	result = playmove<RULES>(board, color, maxtime, str, info, moreinfo);
 
-#ifdef LOG_TIME_MGMT
-	if (incremental) {
-		double elapsed = (clock() - starttime) / (double)CLK_TCK;
-		log("incr %.1f, remaining %.3f, abs maxt %.3f, desired %.3f, new iter maxt %.3f, actual %.3f, margin %.3f %s\n",
-			increment, remaining, absolute_maxtime, desired, new_iter_maxtime, 
-			elapsed, remaining - elapsed,
-			remaining - elapsed < 0 ? "***" : "");
-	}
-#endif
 	for (i = 5; i <= 40; i++)
 		if (board[i] == FREE)
 			board[i] = 0;
@@ -441,21 +836,7 @@ int WINAPI getmove
 	b[3][7] = board[38];
 	b[5][7] = board[39];
 	b[7][7] = board[40];
-	if (color == BLACK) {
-		if (value > 4000)
-			return CB_WIN;
-		if (value < -4000)
-			return CB_LOSS;
-	}
-
-	if (color == WHITE) {
-		if (value > 4000)
-			return CB_LOSS;
-		if (value < -4000)
-			return CB_WIN;
-	}
-
-	return CB_UNKNOWN;
+	return result;
 }
 
 void movetonotation(move2 move, char str[80])
@@ -486,244 +867,65 @@ void movetonotation(move2 move, char str[80])
 }
 
 /*-------------- PART II: SEARCH ---------------------------------------------*/
-int checkers(int b[46], int color, double maxtime, char *str)
-/*----------> purpose: entry point to checkers. find a move on board b for color
-  ---------->          in the time specified by maxtime, write the best move in
-  ---------->          board, returns information on the search in str
-  ----------> returns 1 if a move is found & executed, 0, if there is no legal
-  ----------> move in this position.
-  ----------> version: 1.1
-  ----------> date: 9th october 98 */
+void setthreadposition(SEARCHTHREAD *t, int b[46], int color)
+/*----------> purpose: set up the bitboards, the hashkey and the evaluation terms of
+  ---------->          search thread t for board b, and look up the root position in
+  ---------->          the endgame database. */
 {
-	int i, numberofmoves;
-	int eval;
-	move2 best, lastbest, movelist[MAXMOVES];
-	char str2[255];
-	alphabetas = 0;
-#ifdef STATISTICS
-	generatemovelists = 0;
-	generatecapturelists = 0;
-	evaluations = 0;
-#endif
-
-	/*--------> check if there is only one move */
-	numberofmoves = generatecapturelist(b, movelist, color);
-	if (numberofmoves == 1) {
-		domove(b, movelist[0]);
-		sprintf(str, "forced capture");
-		return(1);
-	}
-	else {
-		numberofmoves = generatemovelist(b, movelist, color);
-		if (numberofmoves == 1) {
-			domove(b, movelist[0]);
-			sprintf(str, "only move");
-			return(1);
-		}
-
-		if (numberofmoves == 0) {
-			sprintf(str, "no legal moves in this position");
-			return(0);
-		}
-	}
-
-	eval = firstalphabeta(b, 1, -10000, 10000, color, &best);
-	for (i = 2; (i <= MAXDEPTH) && ((clock() - starttime) / (double)CLK_TCK < maxtime); i++) {
-		lastbest = best;
-		eval = firstalphabeta(b, i, -10000, 10000, color, &best);
-		movetonotation(best, str2);
-#ifndef MUTE
-		sprintf(str, "best:%s time %2.2fs, depth %2li, value %4li", str2, (clock() - starttime) / (double)CLK_TCK, i, eval);
-#ifdef STATISTICS
-		sprintf(str2,
-				"  nodes %li, gms %li, gcs %li, evals %li",
-				alphabetas,
-				generatemovelists,
-				generatecapturelists,
-				evaluations);
-		strcat(str, str2);
-#endif
-#endif
-		if (*play)
-			break;
-		if (eval == 5000)
-			break;
-		if (eval == -5000)
-			break;
-	}
-
-	i--;
-	if (*play)
-		movetonotation(lastbest, str2);
-	else
-		movetonotation(best, str2);
-
-	sprintf(str,
-			"best:%s time %2.2f, depth %2li, value %4li  nodes %li, gms %li, gcs %li, evals %li",
-			str2,
-			(clock() - starttime) / (double)CLK_TCK,
-			i,
-			eval,
-			alphabetas,
-			generatemovelists,
-			generatecapturelists,
-			evaluations);
-
-	if (*play)
-		domove(b, lastbest);
-	else
-		domove(b, best);
-	return eval;
+	boardtopos(b, &t->p);
+	t->hashkey = hashposition(&t->p, color);
+	evalterms(&t->p, t->count, &t->psq, &t->tempo);
+	t->rootpieces = t->count[0] + t->count[1] + t->count[2] + t->count[3];
+	t->rootresult = DB_UNKNOWN;
+	if (t->rootpieces <= dbpieces && !testcapture(&t->p, color))
+		t->rootresult = dblookup(&t->p, color);
+	if (t->rootresult == DB_DRAW)
+		t->rootresult = DB_UNKNOWN;
 }
 
-int firstalphabeta(int b[46], int depth, int alpha, int beta, int color, move2 *best)
-/*----------> purpose: search the game tree and find the best move.
-  ----------> version: 1.0
-  ----------> date: 25th october 97 */
+int samemove(BBMOVE &a, BBMOVE &b)
+/*----------> purpose: returns 1 if a and b are the same move. */
 {
-	int i;
-	int value;
-	int numberofmoves;
-	int capture;
-	move2 movelist[MAXMOVES];
-
-	alphabetas++;
-	if (*play)
-		return 0;
-
-	/*----------> test if captures are possible */
-	capture = testcapture(b, color);
-
-	/*----------> recursion termination if no captures and depth=0*/
-	if (depth == 0) {
-		if (capture == 0)
-			return(evaluation(b, color));
-		else
-			depth = 1;
-	}
-
-	/*----------> generate all possible moves in the position */
-	if (capture == 0) {
-		numberofmoves = generatemovelist(b, movelist, color);
-
-		/*----------> if there are no possible moves, we lose: */
-		if (numberofmoves == 0) {
-			if (color == BLACK)
-				return(-5000);
-			else
-				return(5000);
-		}
-	}
-	else
-		numberofmoves = generatecapturelist(b, movelist, color);
-
-	/*----------> for all moves: execute the move, search tree, undo move. */
-	for (i = 0; i < numberofmoves; i++) {
-		domove(b, movelist[i]);
-
-		value = alphabeta(b, depth - 1, alpha, beta, CB_CHANGECOLOR(color));
-
-		undomove(b, movelist[i]);
-		if (color == BLACK) {
-			if (value >= beta)
-				return(value);
-			if (value > alpha) {
-				alpha = value;
-				*best = movelist[i];
-			}
-		}
-
-		if (color == WHITE) {
-			if (value <= alpha)
-				return(value);
-			if (value < beta) {
-				beta = value;
-				*best = movelist[i];
-			}
-		}
-	}
-
-	if (color == BLACK)
-		return(alpha);
-	return(beta);
+	return(a.from == b.from && a.to == b.to &&
+		   a.delta.bm == b.delta.bm && a.delta.bk == b.delta.bk &&
+		   a.delta.wm == b.delta.wm && a.delta.wk == b.delta.wk);
 }
 
-int alphabeta(int b[46], int depth, int alpha, int beta, int color)
-/*----------> purpose: search the game tree and find the best move.
-  ----------> version: 1.0
-  ----------> date: 24th october 97 */
+uint64_t hashposition(int b[46], int color)
+/*----------> purpose: compute the zobrist key of the board b of CheckerBoard. */
 {
-	int i;
-	int value;
-	int capture;
-	int numberofmoves;
-	move2 movelist[MAXMOVES];
-
-	alphabetas++;
-	if ((alphabetas & 0x3ff) == 0) {
-		if ((clock() - starttime) / (double)CLK_TCK >= absolute_maxtime) {
-#ifdef LOG_TIME_MGMT
-			log("max detected at %.3f\n", (clock() - starttime) / (double)CLK_TCK);
-#endif
-			*play = 1;
-		}
-	}
-	if (*play)
-		return 0;
-
+	pos p;
 
-	/*----------> test if captures are possible */
-	capture = testcapture(b, color);
-
-	/*----------> recursion termination if no captures and depth=0*/
-	if (depth == 0) {
-		if (capture == 0)
-			return(evaluation(b, color));
-		else
-			depth = 1;
-	}
-
-	/*----------> generate all possible moves in the position */
-	if (capture == 0) {
-		numberofmoves = generatemovelist(b, movelist, color);
-
-		/*----------> if there are no possible moves, we lose: */
-		if (numberofmoves == 0) {
-			if (color == BLACK)
-				return(-5000);
-			else
-				return(5000);
-		}
-	}
-	else
-		numberofmoves = generatecapturelist(b, movelist, color);
-
-	/*----------> for all moves: execute the move, search tree, undo move. */
-	for (i = 0; i < numberofmoves; i++) {
-		domove(b, movelist[i]);
-
-		value = alphabeta(b, depth - 1, alpha, beta, CB_CHANGECOLOR(color));
-
-		undomove(b, movelist[i]);
+	boardtopos(b, &p);
+	return(hashposition(&p, color));
+}
 
-		if (color == BLACK) {
-			if (value >= beta)
-				return(value);
-			if (value > alpha)
-				alpha = value;
-		}
+uint64_t hashposition(pos *p, int color)
+/*----------> purpose: compute the zobrist key of a position from scratch. */
+{
+	uint64_t key;
 
-		if (color == WHITE) {
-			if (value <= alpha)
-				return(value);
-			if (value < beta)
-				beta = value;
-		}
-	}
+	key = hashdelta(p);
+	if (color == WHITE)
+		key ^= zobrist_color;
+	return(key);
+}
 
-	if (color == BLACK)
-		return(alpha);
-	return(beta);
+uint64_t hashdelta(pos *delta)
+/*----------> purpose: xor of the zobrist keys of all pieces in delta. */
+{
+	uint32_t x;
+	uint64_t key = 0;
+
+	for (x = delta->bm; x; x &= x - 1)
+		key ^= zobrist[0][LSB(x)];
+	for (x = delta->bk; x; x &= x - 1)
+		key ^= zobrist[1][LSB(x)];
+	for (x = delta->wm; x; x &= x - 1)
+		key ^= zobrist[2][LSB(x)];
+	for (x = delta->wk; x; x &= x - 1)
+		key ^= zobrist[3][LSB(x)];
+	return(key);
 }
 
 void domove(int b[46], move2 &move)
@@ -753,348 +955,646 @@ void undomove(int b[46], move2 &move)
 	}
 }
 
-int evaluation(int b[46], int color)
-/*----------> purpose:
-  ----------> version: 1.1
-  ----------> date: 18th april 98 */
+void domove(SEARCHTHREAD *t, BBMOVE &move)
+/*----------> purpose: execute move in a search thread and put the new position on
+  ---------->          its key stack. a move without men that only changes the kings
+  ---------->          of one side is a king move that took nothing, it is reversible. */
 {
-	int i, j;
-	int eval;
-	int v1, v2;
-	int nbm, nbk, nwm, nwk;
-	int nbmc = 0, nbkc = 0, nwmc = 0, nwkc = 0;
-	int nbme = 0, nbke = 0, nwme = 0, nwke = 0;
-	int code = 0;
-	static int value[17] = { 0, 0, 0, 0, 0, 1, 256, 0, 0, 16, 4096, 0, 0, 0, 0, 0, 0 };
-	static int edge[14] = { 5, 6, 7, 8, 13, 14, 22, 23, 31, 32, 37, 38, 39, 40 };
-	static int center[8] = { 15, 16, 20, 21, 24, 25, 29, 30 };
-	static int row[41] =
-	{
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		0,
-		1,
-		1,
-		1,
-		1,
-		2,
-		2,
-		2,
-		2,
-		0,
-		3,
-		3,
-		3,
-		3,
-		4,
-		4,
-		4,
-		4,
-		0,
-		5,
-		5,
-		5,
-		5,
-		6,
-		6,
-		6,
-		6,
-		0,
-		7,
-		7,
-		7,
-		7
-	};
-	static int safeedge[4] = { 8, 13, 32, 37 };
-
-	int tempo = 0;
-	int nm, nk;
+	xormove(t, move);
+	pushkey(t, (move.delta.bm | move.delta.wm) == 0 && (move.delta.bk == 0 || move.delta.wk == 0));
+}
 
-	const int turn = 2;						//color to move gets +turn
-	const int brv = 3;						//multiplier for back rank
-	const int kcv = 5;						//multiplier for kings in center
-	const int mcv = 1;						//multiplier for men in center
-	const int mev = 1;						//multiplier for men on edge
-	const int kev = 5;						//multiplier for kings on edge
-	const int cramp = 5;					//multiplier for cramp
-	const int opening = -2;					// multipliers for tempo
-	const int midgame = -1;
-	const int endgame = 2;
-	const int intactdoublecorner = 3;
+void undomove(SEARCHTHREAD *t, BBMOVE &move)
+{
+	popkey(t);
+	xormove(t, move);
+}
 
-	int backrank;
+void xormove(SEARCHTHREAD *t, BBMOVE &move)
+/*----------> purpose: execute or take back move on the bitboards of a search thread
+  ---------->          and update its hashkey and incremental evaluation terms. the
+  ---------->          move is xored in, so both are the same. */
+{
+	uint32_t board[4], delta[4], x;
+	int i, bit;
+
+	t->p.bm ^= move.delta.bm;
+	t->p.bk ^= move.delta.bk;
+	t->p.wm ^= move.delta.wm;
+	t->p.wk ^= move.delta.wk;
+	t->hashkey ^= hashdelta(&move.delta) ^ zobrist_color;
+
+	/* a piece in the delta was put on the board if it is there now, else it was
+	   taken off. */
+	board[0] = t->p.bm;
+	board[1] = t->p.bk;
+	board[2] = t->p.wm;
+	board[3] = t->p.wk;
+	delta[0] = move.delta.bm;
+	delta[1] = move.delta.bk;
+	delta[2] = move.delta.wm;
+	delta[3] = move.delta.wk;
+	for (i = 0; i < 4; i++) {
+		for (x = delta[i]; x; x &= x - 1) {
+			bit = LSB(x);
+			if (board[i] & x & -x) {
+				t->count[i]++;
+				t->psq += psqvalue[i][bit];
+				t->tempo += tempovalue[i][bit];
+			}
+			else {
+				t->count[i]--;
+				t->psq -= psqvalue[i][bit];
+				t->tempo -= tempovalue[i][bit];
+			}
+		}
+	}
+}
 
-	int stonesinsystem = 0;
+/*-------------- PART III: MOVE GENERATION -----------------------------------*/
+int generatemovelist(int b[46], move2 movelist[MAXMOVES], int color)
+/*----------> purpose: generates all moves. no captures. returns number of moves */
+{
+	return(generatemovelist<RULES>(b, movelist, color));
+}
 
-#ifdef STATISTICS
-	evaluations++;
-#endif
-	for (i = 5; i <= 40; i++)
-		code += value[b[i]];
+int generatecapturelist(int b[46], move2 movelist[MAXMOVES], int color)
+/*----------> purpose: generate all possible captures. returns number of captures */
+{
+	return(generatecapturelist<RULES>(b, movelist, color));
+}
 
-	nwm = code % 16;
-	nwk = (code >> 4) % 16;
-	nbm = (code >> 8) % 16;
-	nbk = (code >> 12) % 16;
+/*-------------- PART IV: BITBOARDS ------------------------------------------*/
+/*	the search works on the bitboards of bitboard.h. bit i is square i + 1 of the
+	board numbering below, bitnumber = square - 5 - square / 9 for a board46 square.
+
+				(white)
+   				28  29  30  31
+              24  25  26  27
+                20  21  22  23
+              16  17  18  19
+                12  13  14  15
+               8   9  10  11
+                 4   5   6   7
+               0   1   2   3
+					(black)
+
+	a step in one of the four board46 directions +4, +5, -4 and -5 is a shift by 3, 4
+	or 5 bits depending on the row. the generators below visit the pieces and the
+	directions in the same order as the board46 generators, so that both produce
+	the same movelists in the same order. */
+
+inline uint32_t up4(uint32_t x)
+{
+	return(((x & EVENROWS & ~LEFTEDGE) << 3) | ((x & ODDROWS) << 4));
+}
 
-	v1 = 100 * nbm + 130 * nbk;
-	v2 = 100 * nwm + 130 * nwk;
+inline uint32_t up5(uint32_t x)
+{
+	return(((x & EVENROWS) << 4) | ((x & ODDROWS & ~RIGHTEDGE) << 5));
+}
 
-	eval = v1 - v2;							/*material values*/
-	eval += (250 * (v1 - v2)) / (v1 + v2);	/*favor exchanges if in material plus*/
+inline uint32_t down4(uint32_t x)
+{
+	return(((x & EVENROWS) >> 4) | ((x & ODDROWS & ~RIGHTEDGE) >> 3));
+}
 
-	nm = nbm + nwm;
-	nk = nbk + nwk;
+inline uint32_t down5(uint32_t x)
+{
+	return(((x & EVENROWS & ~LEFTEDGE) >> 5) | ((x & ODDROWS) >> 4));
+}
 
-	/*--------- fine evaluation below -------------*/
-	if (color == BLACK)
-		eval += turn;
-	else
-		eval -= turn;
+inline int bitcount(uint32_t x)
+/*----------> purpose: number of set bits in x. */
+{
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	x = (x + (x >> 4)) & 0x0f0f0f0f;
+	return((x * 0x01010101) >> 24);
+}
 
-	/*    (white)
-   				 37  38  39  40
-              32  33  34  35
-                28  29  30  31
-              23  24  25  26
-                19  20  21  22
-              14  15  16  17
-                10  11  12  13
-               5   6   7   8
-         (black)   */
-
-	/* cramp */
-	if (b[23] == (BLACK | MAN) && b[28] == (WHITE | MAN))
-		eval += cramp;
-	if (b[22] == (WHITE | MAN) && b[17] == (BLACK | MAN))
-		eval -= cramp;
+void addgameposition(int b[46], int color)
+/*----------> purpose: add a position that CheckerBoard sent or that the engine played
+  ---------->          to the game history. the moves since the last position were
+  ---------->          reversible if they moved no men and took no pieces. */
+{
+	int reversible;
+	pos p;
+
+	boardtopos(b, &p);
+	reversible = (p.bm == gameposition.bm && p.wm == gameposition.wm &&
+		bitcount(p.bk) == bitcount(gameposition.bk) && bitcount(p.wk) == bitcount(gameposition.wk));
+	addgamekey(hashposition(&p, color), reversible);
+	gameposition = p;
+}
 
-	/* back rank guard */
-	code = 0;
-	if (b[5] & MAN)
-		code++;
-	if (b[6] & MAN)
-		code += 2;
-	if (b[7] & MAN)
-		code += 4;
-	if (b[8] & MAN)
-		code += 8;
-	switch (code) {
-	case 0:
-		code = 0;
-		break;
+void boardtopos(int b[46], pos *p)
+/*----------> purpose: convert a board46 position to bitboards. */
+{
+	int i;
+	uint32_t bit;
+
+	p->bm = p->bk = p->wm = p->wk = 0;
+	for (i = 5; i <= 40; i++) {
+		if (i % 9 == 0)
+			continue;
+		bit = 1 << (i - 5 - i / 9);
+		switch (b[i]) {
+		case BLACK | MAN:
+			p->bm |= bit;
+			break;
 
-	case 1:
-		code = -1;
-		break;
+		case BLACK | KING:
+			p->bk |= bit;
+			break;
 
-	case 2:
-		code = 1;
-		break;
+		case WHITE | MAN:
+			p->wm |= bit;
+			break;
 
-	case 3:
-		code = 0;
-		break;
+		case WHITE | KING:
+			p->wk |= bit;
+			break;
+		}
+	}
+}
 
-	case 4:
-		code = 1;
-		break;
+void tomove2(BBMOVE &move, int color, move2 *m)
+/*----------> purpose: convert a bitboard move of color to a board46 move, for
+  ---------->          domove() on the board of CheckerBoard and for
+  ---------->          movetonotation(). the captured pieces are listed in
+  ---------->          square order instead of the order they are jumped. */
+{
+	uint32_t ownmen, ownkings, oppmen, oppkings, x;
+	int before, after, from, to, king, opp;
 
-	case 5:
-		code = 1;
-		break;
+	if (color == BLACK) {
+		ownmen = move.delta.bm;
+		ownkings = move.delta.bk;
+		oppmen = move.delta.wm;
+		oppkings = move.delta.wk;
+	}
+	else {
+		ownmen = move.delta.wm;
+		ownkings = move.delta.wk;
+		oppmen = move.delta.bm;
+		oppkings = move.delta.bk;
+	}
 
-	case 6:
-		code = 2;
-		break;
+	from = move.from + 5 + (move.from + 4) / 8;
+	to = move.to + 5 + (move.to + 4) / 8;
+	king = (ownmen & (1 << move.from)) ? 0 : KING;
+	before = color | (king ? KING : MAN);
+	after = (king || (ownkings & (1 << move.to))) ? (color | KING) : (color | MAN);
+	m->m[0] = (FREE << 16) | (before << 8) | from;
+	m->m[1] = (after << 16) | (FREE << 8) | to;
+	m->n = 2;
+
+	opp = CB_CHANGECOLOR(color);
+	for (x = oppmen | oppkings; x; x &= x - 1) {
+		m->m[m->n] = (FREE << 16) | (LSB(x) + 5 + (LSB(x) + 4) / 8);
+		m->m[m->n] |= ((oppmen & x & -x) ? (opp | MAN) : (opp | KING)) << 8;
+		m->n++;
+	}
+}
 
-	case 7:
-		code = 1;
-		break;
+int generatemovelist(pos *p, BBMOVE movelist[MAXMOVES], int color)
+/*----------> purpose: generate all moves on a bitboard position. no captures.
+  ----------> returns number of moves */
+{
+	int n = 0;
+	uint32_t empty, men, kings, movers, square, to;
 
-	case 8:
-		code = 1;
-		break;
+	empty = ~(p->bm | p->bk | p->wm | p->wk);
+	if (color == BLACK) {
+		men = p->bm;
+		kings = p->bk;
+		movers = (down4(empty) | down5(empty)) & men;
+		movers |= (down4(empty) | down5(empty) | up4(empty) | up5(empty)) & kings;
+	}
+	else {
+		men = p->wm;
+		kings = p->wk;
+		movers = (up4(empty) | up5(empty)) & men;
+		movers |= (down4(empty) | down5(empty) | up4(empty) | up5(empty)) & kings;
+	}
 
-	case 9:
-		code = 0;
-		break;
+	for (; movers; movers &= movers - 1) {
+		square = movers & -movers;
+		if (square & men) {
+			if (color == BLACK) {
+				if ((to = up4(square) & empty) != 0)
+					addmove(movelist, &n, p, color, square, to);
+				if ((to = up5(square) & empty) != 0)
+					addmove(movelist, &n, p, color, square, to);
+			}
+			else {
+				if ((to = down4(square) & empty) != 0)
+					addmove(movelist, &n, p, color, square, to);
+				if ((to = down5(square) & empty) != 0)
+					addmove(movelist, &n, p, color, square, to);
+			}
+		}
+		else {
+			if ((to = up4(square) & empty) != 0)
+				addmove(movelist, &n, p, color, square, to);
+			if ((to = up5(square) & empty) != 0)
+				addmove(movelist, &n, p, color, square, to);
+			if ((to = down4(square) & empty) != 0)
+				addmove(movelist, &n, p, color, square, to);
+			if ((to = down5(square) & empty) != 0)
+				addmove(movelist, &n, p, color, square, to);
+		}
+	}
 
-	case 10:
-		code = 7;
-		break;
+	return(n);
+}
 
-	case 11:
-		code = 4;
-		break;
+void addmove(BBMOVE movelist[MAXMOVES], int *n, pos *p, int color, uint32_t from, uint32_t to)
+/*----------> purpose: append the move of the piece on from to to, without captures. */
+{
+	BBMOVE *move = movelist + *n;
 
-	case 12:
-		code = 2;
-		break;
+	move->delta.bm = move->delta.bk = move->delta.wm = move->delta.wk = 0;
+	move->from = LSB(from);
+	move->to = LSB(to);
+	if (color == BLACK) {
+		if (from & p->bk)
+			move->delta.bk = from | to;
+		else if (to & PROMOTEBLACK) {
+			move->delta.bm = from;
+			move->delta.bk = to;
+		}
+		else
+			move->delta.bm = from | to;
+	}
+	else {
+		if (from & p->wk)
+			move->delta.wk = from | to;
+		else if (to & PROMOTEWHITE) {
+			move->delta.wm = from;
+			move->delta.wk = to;
+		}
+		else
+			move->delta.wm = from | to;
+	}
 
-	case 13:
-		code = 2;
-		break;
+	(*n)++;
+}
 
-	case 14:
-		code = 9;
-		break;
+int generatecapturelist(pos *p, BBMOVE movelist[MAXMOVES], int color)
+/*----------> purpose: generate all captures on a bitboard position.
+  ----------> returns number of moves */
+{
+	int n = 0;
+	uint32_t empty, men, kings, opp, capturers, square;
+	BBMOVE move;
 
-	case 15:
-		code = 8;
-		break;
+	empty = ~(p->bm | p->bk | p->wm | p->wk);
+	if (color == BLACK) {
+		men = p->bm;
+		kings = p->bk;
+		opp = p->wm | p->wk;
+		capturers = (down4(down4(empty) & opp) | down5(down5(empty) & opp)) & (men | kings);
+		capturers |= (up4(up4(empty) & opp) | up5(up5(empty) & opp)) & kings;
+	}
+	else {
+		men = p->wm;
+		kings = p->wk;
+		opp = p->bm | p->bk;
+		capturers = (up4(up4(empty) & opp) | up5(up5(empty) & opp)) & (men | kings);
+		capturers |= (down4(down4(empty) & opp) | down5(down5(empty) & opp)) & kings;
 	}
 
-	backrank = code;
-
-	code = 0;
-	if (b[37] & MAN)
-		code += 8;
-	if (b[38] & MAN)
-		code += 4;
-	if (b[39] & MAN)
-		code += 2;
-	if (b[40] & MAN)
-		code++;
-	switch (code) {
-	case 0:
-		code = 0;
-		break;
+	for (; capturers; capturers &= capturers - 1) {
+		square = capturers & -capturers;
+		move.delta.bm = move.delta.bk = move.delta.wm = move.delta.wk = 0;
+		move.from = LSB(square);
+		if (square & men) {
+			if (color == BLACK)
+				move.delta.bm = square;
+			else
+				move.delta.wm = square;
+			mancapture(p, &n, movelist, move, square, opp, empty, color, 1);
+		}
+		else {
+			if (color == BLACK)
+				move.delta.bk = square;
+			else
+				move.delta.wk = square;
 
-	case 1:
-		code = -1;
-		break;
+			/* the capturing king leaves its square, it may pass it again. */
+			kingcapture(p, &n, movelist, move, square, opp, empty | square, color, 1);
+		}
+	}
 
-	case 2:
-		code = 1;
-		break;
+	return(n);
+}
 
-	case 3:
-		code = 0;
-		break;
+void mancapture(pos *p, int *n, BBMOVE movelist[MAXMOVES], BBMOVE &move, uint32_t square, uint32_t opp, uint32_t empty, int color, int first)
+/*----------> purpose: continue the capture of a man on square. move holds the
+  ---------->          pieces captured so far. when no further capture is
+  ---------->          possible, the move is added to the movelist. */
+{
+	int i;
+	int found = 0;
+	uint32_t mid[2], land[2];
+	BBMOVE next;
 
-	case 4:
-		code = 1;
-		break;
+	if (color == BLACK) {
+		mid[0] = up4(square);
+		mid[1] = up5(square);
+		land[0] = up4(mid[0]);
+		land[1] = up5(mid[1]);
+	}
+	else {
+		mid[0] = down4(square);
+		mid[1] = down5(square);
+		land[0] = down4(mid[0]);
+		land[1] = down5(mid[1]);
+	}
 
-	case 5:
-		code = 1;
-		break;
+	for (i = 0; i < 2; i++) {
+		if ((mid[i] & opp) && (land[i] & empty)) {
+			found = 1;
+			next = move;
+			addcapture(p, next, mid[i], color);
+			mancapture(p, n, movelist, next, land[i], opp, empty, color, 0);
+		}
+	}
 
-	case 6:
-		code = 2;
-		break;
+	if (found || first)
+		return;
 
-	case 7:
-		code = 1;
-		break;
+	movelist[*n] = move;
+	movelist[*n].to = LSB(square);
+	if (color == BLACK) {
+		if (square & PROMOTEBLACK)
+			movelist[*n].delta.bk |= square;
+		else
+			movelist[*n].delta.bm |= square;
+	}
+	else {
+		if (square & PROMOTEWHITE)
+			movelist[*n].delta.wk |= square;
+		else
+			movelist[*n].delta.wm |= square;
+	}
 
-	case 8:
-		code = 1;
-		break;
+	(*n)++;
+}
 
-	case 9:
-		code = 0;
-		break;
+void kingcapture(pos *p, int *n, BBMOVE movelist[MAXMOVES], BBMOVE &move, uint32_t square, uint32_t opp, uint32_t empty, int color, int first)
+/*----------> purpose: continue the capture of a king on square. captured pieces
+  ---------->          are removed from opp and added to empty. the first jump
+  ---------->          tries the directions in the order +4, +5, -4, -5, the
+  ---------->          following jumps in the order -4, -5, +4, +5, as the
+  ---------->          board46 generator does. */
+{
+	int i;
+	int found = 0;
+	uint32_t mid[4], land[4];
+	BBMOVE next;
+
+	if (first) {
+		mid[0] = up4(square);
+		mid[1] = up5(square);
+		mid[2] = down4(square);
+		mid[3] = down5(square);
+		land[0] = up4(mid[0]);
+		land[1] = up5(mid[1]);
+		land[2] = down4(mid[2]);
+		land[3] = down5(mid[3]);
+	}
+	else {
+		mid[0] = down4(square);
+		mid[1] = down5(square);
+		mid[2] = up4(square);
+		mid[3] = up5(square);
+		land[0] = down4(mid[0]);
+		land[1] = down5(mid[1]);
+		land[2] = up4(mid[2]);
+		land[3] = up5(mid[3]);
+	}
 
-	case 10:
-		code = 7;
-		break;
+	for (i = 0; i < 4; i++) {
+		if ((mid[i] & opp) && (land[i] & empty)) {
+			found = 1;
+			next = move;
+			addcapture(p, next, mid[i], color);
+			kingcapture(p, n, movelist, next, land[i], opp & ~mid[i], empty | mid[i], color, 0);
+		}
+	}
 
-	case 11:
-		code = 4;
-		break;
+	if (found || first)
+		return;
 
-	case 12:
-		code = 2;
-		break;
+	/* the king may end on the square it started from. */
+	movelist[*n] = move;
+	movelist[*n].to = LSB(square);
+	if (color == BLACK)
+		movelist[*n].delta.bk ^= square;
+	else
+		movelist[*n].delta.wk ^= square;
+	(*n)++;
+}
 
-	case 13:
-		code = 2;
-		break;
+void addcapture(pos *p, BBMOVE &move, uint32_t square, int color)
+/*----------> purpose: add the opposing piece on square to the captured pieces of move. */
+{
+	if (color == BLACK) {
+		if (square & p->wm)
+			move.delta.wm |= square;
+		else
+			move.delta.wk |= square;
+	}
+	else {
+		if (square & p->bm)
+			move.delta.bm |= square;
+		else
+			move.delta.bk |= square;
+	}
+}
 
-	case 14:
-		code = 9;
-		break;
+int testcapture(pos *p, int color)
+/*----------> purpose: test if color has a capture on a bitboard position */
+{
+	uint32_t empty, opp, own;
 
-	case 15:
-		code = 8;
-		break;
+	empty = ~(p->bm | p->bk | p->wm | p->wk);
+	if (color == BLACK) {
+		opp = p->wm | p->wk;
+		own = p->bm | p->bk;
+		if ((up4(up4(own) & opp) | up5(up5(own) & opp)) & empty)
+			return(1);
+		return(((down4(down4(p->bk) & opp) | down5(down5(p->bk) & opp)) & empty) != 0);
 	}
 
-	backrank -= code;
-	eval += brv * backrank;
+	opp = p->bm | p->bk;
+	own = p->wm | p->wk;
+	if ((down4(down4(own) & opp) | down5(down5(own) & opp)) & empty)
+		return(1);
+	return(((up4(up4(p->wk) & opp) | up5(up5(p->wk) & opp)) & empty) != 0);
+}
 
-	/* intact double corner */
-	if (b[8] == (BLACK | MAN)) {
-		if (b[12] == (BLACK | MAN) || b[13] == (BLACK | MAN))
-			eval += intactdoublecorner;
-	}
+int testcapture(SEARCHTHREAD *t, int color)
+/*----------> purpose: the search's view of testcapture(): the position of thread t */
+{
+	return(testcapture(&t->p, color));
+}
 
-	if (b[37] == (WHITE | MAN)) {
-		if (b[32] == (WHITE | MAN) || b[33] == (WHITE | MAN))
-			eval -= intactdoublecorner;
-	}
+int generatemovelist(SEARCHTHREAD *t, BBMOVE movelist[MAXMOVES], int color)
+/*----------> purpose: the search's view of generatemovelist(): the position of thread t */
+{
+	return(generatemovelist(&t->p, movelist, color));
+}
 
-	/*    (white)
-   				 37  38  39  40
-              32  33  34  35
-                28  29  30  31
-              23  24  25  26
-                19  20  21  22
-              14  15  16  17
-                10  11  12  13
-               5   6   7   8
-         (black)   */
+int generatecapturelist(SEARCHTHREAD *t, BBMOVE movelist[MAXMOVES], int color)
+/*----------> purpose: the search's view of generatecapturelist(): the position of thread t */
+{
+	return(generatecapturelist(&t->p, movelist, color));
+}
 
-	/* center control */
-	for (i = 0; i < 8; i++) {
-		if (b[center[i]] != FREE) {
-			if (b[center[i]] == (BLACK | MAN))
-				nbmc++;
-			if (b[center[i]] == (BLACK | KING))
-				nbkc++;
-			if (b[center[i]] == (WHITE | MAN))
-				nwmc++;
-			if (b[center[i]] == (WHITE | KING))
-				nwkc++;
-		}
+int &historyentry(SEARCHTHREAD *t, BBMOVE &move, int color)
+/*----------> purpose: the history score of move for color, indexed by its from and to squares */
+{
+	return(t->history[color - 1][move.from][move.to]);
+}
+
+/* evaluation weights. the material, center, edge and tempo terms of the evaluation
+   are sums over the pieces. the search keeps them up to date in domove() and
+   undomove(), so that evaluation() only computes the other terms. */
+static const int kcv = 5;					//multiplier for kings in center
+static const int mcv = 1;					//multiplier for men in center
+static const int mev = 1;					//multiplier for men on edge
+static const int kev = 5;					//multiplier for kings on edge
+
+void initevaluation(void)
+/*----------> purpose: set up the piece-square tables of the evaluation terms that
+  ---------->          are kept up to date by domove(). */
+{
+	int i;
+	int center, edge, row;
+
+	for (i = 0; i < 32; i++) {
+		center = (CENTER >> i) & 1;
+		edge = (EDGE >> i) & 1;
+		row = i / 4;
+		psqvalue[0][i] = center * mcv - edge * mev;
+		psqvalue[1][i] = center * kcv - edge * kev;
+		psqvalue[2][i] = -psqvalue[0][i];
+		psqvalue[3][i] = -psqvalue[1][i];
+		tempovalue[0][i] = row;
+		tempovalue[1][i] = 0;
+		tempovalue[2][i] = row - 7;
+		tempovalue[3][i] = 0;
 	}
+}
+
+void evalterms(pos *p, int count[4], int *psq, int *tempo)
+/*----------> purpose: compute the evaluation terms that domove() keeps up to date
+  ---------->          from scratch: the number of pieces on each bitboard, the
+  ---------->          center and edge terms, and the tempo count. */
+{
+	count[0] = bitcount(p->bm);
+	count[1] = bitcount(p->bk);
+	count[2] = bitcount(p->wm);
+	count[3] = bitcount(p->wk);
 
-	eval += (nbmc - nwmc) * mcv;
-	eval += (nbkc - nwkc) * kcv;
+	/* center control */
+	*psq = (bitcount(p->bm & CENTER) - bitcount(p->wm & CENTER)) * mcv;
+	*psq += (bitcount(p->bk & CENTER) - bitcount(p->wk & CENTER)) * kcv;
 
 	/*edge*/
-	for (i = 0; i < 14; i++) {
-		if (b[edge[i]] != FREE) {
-			if (b[edge[i]] == (BLACK | MAN))
-				nbme++;
-			if (b[edge[i]] == (BLACK | KING))
-				nbke++;
-			if (b[edge[i]] == (WHITE | MAN))
-				nwme++;
-			if (b[edge[i]] == (WHITE | KING))
-				nwke++;
-		}
-	}
+	*psq -= (bitcount(p->bm & EDGE) - bitcount(p->wm & EDGE)) * mev;
+	*psq -= (bitcount(p->bk & EDGE) - bitcount(p->wk & EDGE)) * kev;
+
+	/* tempo: the sum of the rows of the black men minus the sum of the rows of the
+	   white men counted from white's side. the masks select the rows with bit
+	   0, 1 and 2 of the row number set. */
+	*tempo = bitcount(p->bm & 0xf0f0f0f0) + 2 * bitcount(p->bm & 0xff00ff00) + 4 * bitcount(p->bm & 0xffff0000);
+	*tempo -= 7 * count[2];
+	*tempo += bitcount(p->wm & 0xf0f0f0f0) + 2 * bitcount(p->wm & 0xff00ff00) + 4 * bitcount(p->wm & 0xffff0000);
+}
+
+int evaluation(SEARCHTHREAD *t, int color)
+/*----------> purpose: static evaluation, from the point of view of black.
+  ----------> version: 2.0 */
+{
+	pos *p = &t->p;
+	int eval;
+	int v1, v2;
+	int nbm, nbk, nwm, nwk;
+	int nm, nk;
+	int tempo;
+	int backrank;
+	int stonesinsystem;
+	uint32_t men, all;
+
+	/* back rank guard by the men on squares 1-4 (bit 0 is square 1), and the same
+	   for white with the square order reversed. */
+	static int backrankvalue[16] = { 0, -1, 1, 0, 1, 1, 2, 1, 1, 0, 7, 4, 2, 2, 9, 8 };
+	static int reverse[16] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+
+	const int turn = 2;						//color to move gets +turn
+	const int brv = 3;						//multiplier for back rank
+	const int cramp = 5;					//multiplier for cramp
+	const int opening = -2;					// multipliers for tempo
+	const int midgame = -1;
+	const int endgame = 2;
+	const int intactdoublecorner = 3;
+
+#ifdef CHECKEVAL
+	int count[4], psq;
 
-	eval -= (nbme - nwme) * mev;
-	eval -= (nbke - nwke) * kev;
+	evalterms(p, count, &psq, &tempo);
+	if (memcmp(count, t->count, sizeof(count)) != 0 || psq != t->psq || tempo != t->tempo)
+		t->evalerrors++;
+#endif
+
+	nbm = t->count[0];
+	nbk = t->count[1];
+	nwm = t->count[2];
+	nwk = t->count[3];
+
+	v1 = 100 * nbm + 130 * nbk;
+	v2 = 100 * nwm + 130 * nwk;
+
+	eval = v1 - v2;							/*material values*/
+	eval += (250 * (v1 - v2)) / (v1 + v2);	/*favor exchanges if in material plus*/
+
+	nm = nbm + nwm;
+	nk = nbk + nwk;
+
+	/*--------- fine evaluation below -------------*/
+	if (color == BLACK)
+		eval += turn;
+	else
+		eval -= turn;
+
+	/* cramp */
+	if ((p->bm & (1 << 16)) && (p->wm & (1 << 20)))
+		eval += cramp;
+	if ((p->wm & (1 << 15)) && (p->bm & (1 << 11)))
+		eval -= cramp;
+
+	/* back rank guard */
+	men = p->bm | p->wm;
+	backrank = backrankvalue[men & 15];
+	backrank -= backrankvalue[reverse[men >> 28]];
+	eval += brv * backrank;
+
+	/* intact double corner */
+	if ((p->bm & (1 << 3)) && (p->bm & ((1 << 6) | (1 << 7))))
+		eval += intactdoublecorner;
+	if ((p->wm & (1 << 28)) && (p->wm & ((1 << 24) | (1 << 25))))
+		eval -= intactdoublecorner;
+
+	/* center control and edge */
+	eval += t->psq;
 
 	/* tempo */
-	for (i = 5; i < 41; i++) {
-		if (b[i] == (BLACK | MAN))
-			tempo += row[i];
-		if (b[i] == (WHITE | MAN))
-			tempo -= 7 - row[i];
-	}
+	tempo = t->tempo;
 
 	if (nm >= 16)
 		eval += opening * tempo;
@@ -1103,28 +1603,16 @@ int evaluation(int b[46], int color)
 	if (nm < 9)
 		eval += endgame * tempo;
 
-	for (i = 0; i < 4; i++) {
-		if (nbk + nbm > nwk + nwm && nwk < 3) {
-			if (b[safeedge[i]] == (WHITE | KING))
-				eval -= 15;
-		}
-
-		if (nwk + nwm > nbk + nbm && nbk < 3) {
-			if (b[safeedge[i]] == (BLACK | KING))
-				eval += 15;
-		}
-	}
+	if (nbk + nbm > nwk + nwm && nwk < 3)
+		eval -= 15 * bitcount(p->wk & SAFEEDGE);
+	if (nwk + nwm > nbk + nbm && nbk < 3)
+		eval += 15 * bitcount(p->bk & SAFEEDGE);
 
 	/* the move */
 	if (nwm + nwk - nbk - nbm == 0) {
+		all = p->bm | p->bk | p->wm | p->wk;
 		if (color == BLACK) {
-			for (i = 5; i <= 8; i++) {
-				for (j = 0; j < 4; j++) {
-					if (b[i + 9 * j] != FREE)
-						stonesinsystem++;
-				}
-			}
-
+			stonesinsystem = bitcount(all & EVENROWS);
 			if (stonesinsystem % 2) {
 				if (nm + nk <= 12)
 					eval++;
@@ -1147,13 +1635,7 @@ int evaluation(int b[46], int color)
 			}
 		}
 		else {
-			for (i = 10; i <= 13; i++) {
-				for (j = 0; j < 4; j++) {
-					if (b[i + 9 * j] != FREE)
-						stonesinsystem++;
-				}
-			}
-
+			stonesinsystem = bitcount(all & ODDROWS);
 			if ((stonesinsystem % 2) == 0) {
 				if (nm + nk <= 12)
 					eval++;
@@ -1180,1093 +1662,803 @@ int evaluation(int b[46], int color)
 	return(eval);
 }
 
-/*-------------- PART III: MOVE GENERATION -----------------------------------*/
-int generatemovelist(int b[46], move2 movelist[MAXMOVES], int color)
-/*----------> purpose:generates all moves. no captures. returns number of moves
-  ----------> version: 1.0
-  ----------> date: 25th october 97 */
+/*-------------- PART V: ENDGAME DATABASE ------------------------------------*/
+/*	the win/loss/draw database in the db folder of CheckerBoard has all positions with
+	2, 3 and 4 pieces in which neither side can capture. dbN.idx lists the slices of
+	the positions with N pieces, one line per slice
+
+		BASE<bm>,<bk>,<wm>,<wk>,<black man rank>,<white man rank>,<b|w>:<block>/<offset>
+
+	followed by the index of the first position in each further block of the slice, one
+	per line. instead of block/offset, "+", "-" or "=" mark a slice whose positions are
+	all won, lost or drawn for the side to move. dbN.cpr holds the values of the
+	positions of each slice in the order of their index, 1024 byte blocks: a byte 0..80
+	holds the values of 4 positions in base 3, the first position in the lowest digit,
+	a byte 81..255 a run of skiplength[(x - 81) % 58] positions of the value (x - 81) / 58.
+	the value 0 is a win, 1 a loss and 2 a draw for the side to move.
+
+	the database only holds positions in which black has more pieces than white, or as
+	many pieces and not more men, or the same pieces and a most advanced man at least as
+	far advanced as the white one. if they are equally advanced, only black to move is
+	stored. any other position is looked up with the colors reversed and the board
+	turned around. the ranks of the men count from the back rank of their side, rank 0. */
+
+static const int skiplength[58] = {
+	5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32,
+	36, 40, 44, 48, 52, 56, 60, 70, 80, 90, 100, 150, 200, 250, 300, 400, 500, 650, 800, 1000,
+	1200, 1400, 1600, 2000, 2400, 3200, 4000, 5000, 7500, 10000
+};
+
+void initdb(void)
+/*----------> purpose: open the files of the endgame database and read the index files.
+  ---------->          the database is probed in positions with up to the largest
+  ---------->          number of pieces whose files were found. */
 {
-	int n = 0, m;
-	int i;
-
-#ifdef STATISTICS
-	generatemovelists++;
-#endif
-	if (color == BLACK) {
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & BLACK) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i + 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i >= 32)
-							m = (BLACK | KING);
-						else
-							m = (BLACK | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i + 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i >= 32)
-							m = (BLACK | KING);
-						else
-							m = (BLACK | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
+	int i, k;
+	int pieces;
+	long size;
+	char filename[MAX_PATH];
+
+	dbinitialized = 1;
+	for (i = 0; i <= 32; i++) {
+		binomial[i][0] = 1;
+		for (k = 1; k <= MAXDBPIECES; k++)
+			binomial[i][k] = (i == 0) ? 0 : binomial[i - 1][k - 1] + binomial[i - 1][k];
+	}
 
-				if ((b[i] & KING) != 0) {
-					if ((b[i + 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i + 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (BLACK | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (BLACK | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
-			}
+	dbblocks = 0;
+	for (pieces = 2; pieces <= MAXDBPIECES; pieces++) {
+		sprintf(filename, "%s\\db%d.cpr", dbpath, pieces);
+		dbfile[pieces] = fopen(filename, "rb");
+		if (dbfile[pieces] == NULL)
+			continue;
+
+		fseek(dbfile[pieces], 0, SEEK_END);
+		size = ftell(dbfile[pieces]);
+		dbfirstblock[pieces] = dbblocks;
+		dbblocks += (size + DBBLOCKSIZE - 1) / DBBLOCKSIZE;
+		if (!readdbindex(pieces)) {
+			freedb();
+			dbinitialized = 1;
+			return;
 		}
 	}
-	else {
 
-		/* color = WHITE */
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & WHITE) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i - 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i <= 13)
-							m = (WHITE | KING);
-						else
-							m = (WHITE | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						if (i <= 13)
-							m = (WHITE | KING);
-						else
-							m = (WHITE | MAN);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | MAN);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
+	dbblockslot = (int *)malloc(max(dbblocks, 1) * sizeof(int));
+	if (dbblockslot == NULL || !setdbmbytes(dbmbytes)) {
+		freedb();
+		dbinitialized = 1;
+	}
+}
 
-				if ((b[i] & KING) != 0) {
-
-					/* or else */
-					if ((b[i + 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i + 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i + 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 4] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 4;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-
-					if ((b[i - 5] & FREE) != 0) {
-						movelist[n].n = 2;
-						m = (WHITE | KING);
-						m = m << 8;
-						m += FREE;
-						m = m << 8;
-						m += i - 5;
-						movelist[n].m[1] = m;
-						m = FREE;
-						m = m << 8;
-						m += (WHITE | KING);
-						m = m << 8;
-						m += i;
-						movelist[n].m[0] = m;
-						n++;
-					}
-				}
-			}
+void freedb(void)
+/*----------> purpose: close the endgame database and free its memory. the next search
+  ---------->          opens it again. */
+{
+	int i, k;
+	DBSLICE *slices;
+
+	for (i = 0; i < MAXDBPIECES * MAXDBPIECES * MAXDBPIECES * MAXDBPIECES; i++) {
+		slices = (&dbslices[0][0][0][0])[i];
+		if (slices != NULL) {
+			for (k = 0; k < 128; k++)
+				free(slices[k].blockstart);
+			free(slices);
+			(&dbslices[0][0][0][0])[i] = NULL;
 		}
 	}
 
-	return(n);
+	for (i = 0; i <= MAXDBPIECES; i++) {
+		if (dbfile[i] != NULL)
+			fclose(dbfile[i]);
+		dbfile[i] = NULL;
+	}
+
+	free(dbcache);
+	free(dbcacheblock);
+	free(dbcacheused);
+	free(dbblockslot);
+	dbcache = NULL;
+	dbcacheblock = NULL;
+	dbcacheused = NULL;
+	dbblockslot = NULL;
+	dbcacheslots = 0;
+	dbblocks = 0;
+	dbpieces = 0;
+	dbinitialized = 0;
 }
 
-int generatecapturelist(int b[46], move2 movelist[MAXMOVES], int color)
-/*----------> purpose: generate all possible captures
-  ----------> version: 1.0
-  ----------> date: 25th october 97 */
+int setdbmbytes(int megabytes)
+/*----------> purpose: allocate a block cache of megabytes MB for the endgame database,
+  ---------->          or of the size of the database if that is smaller. 0 switches
+  ---------->          the database off.
+  ----------> returns 1 on success, 0 if megabytes is negative or the memory could
+  ----------> not be allocated. in that case the database is switched off. */
 {
-	int n = 0;
-	int m;
 	int i;
-	int tmp;
 
-#ifdef STATISTICS
-	generatecapturelists++;
-#endif
-	if (color == BLACK) {
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & BLACK) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i + 4] & WHITE) != 0) {
-						if ((b[i + 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i >= 28)
-								m = (BLACK | KING);
-							else
-								m = (BLACK | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 4];
-							m = m << 8;
-							m += i + 4;
-							movelist[n].m[2] = m;
-							blackmancapture(b, &n, movelist, i + 8);
-						}
-					}
-
-					if ((b[i + 5] & WHITE) != 0) {
-						if ((b[i + 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i >= 28)
-								m = (BLACK | KING);
-							else
-								m = (BLACK | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 5];
-							m = m << 8;
-							m += i + 5;
-							movelist[n].m[2] = m;
-							blackmancapture(b, &n, movelist, i + 10);
-						}
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & WHITE) != 0) {
-						if ((b[i + 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 4];
-							m = m << 8;
-							m += i + 4;
-							movelist[n].m[2] = m;
-							tmp = b[i + 4];
-							b[i + 4] = FREE;	/* Remove captured piece. */
-							b[i] = FREE;		/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i + 8);
-							b[i + 4] = tmp;		/* Restore captured piece. */
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-
-					if ((b[i + 5] & WHITE) != 0) {
-						if ((b[i + 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 5];
-							m = m << 8;
-							m += i + 5;
-							movelist[n].m[2] = m;
-							tmp = b[i + 5];
-							b[i + 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i + 10);
-							b[i + 5] = tmp;
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-
-					if ((b[i - 4] & WHITE) != 0) {
-						if ((b[i - 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 4];
-							m = m << 8;
-							m += i - 4;
-							movelist[n].m[2] = m;
-							tmp = b[i - 4];
-							b[i - 4] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i - 8);
-							b[i - 4] = tmp;
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-
-					if ((b[i - 5] & WHITE) != 0) {
-						if ((b[i - 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (BLACK | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (BLACK | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 5];
-							m = m << 8;
-							m += i - 5;
-							movelist[n].m[2] = m;
-							tmp = b[i - 5];
-							b[i - 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							blackkingcapture(b, &n, movelist, i - 10);
-							b[i - 5] = tmp;
-							b[i] = BLACK | KING;	/* Restore capturing king. */
-						}
-					}
-				}
-			}
-		}
-	}
-	else {
+	if (megabytes < 0)
+		return(0);
+
+	dbmbytes = megabytes;
+	free(dbcache);
+	free(dbcacheblock);
+	free(dbcacheused);
+	dbcache = NULL;
+	dbcacheblock = NULL;
+	dbcacheused = NULL;
+	dbcacheslots = 0;
+	dbpieces = 0;
+	if (!dbinitialized)
+		return(1);
 
-		/* color is WHITE */
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & WHITE) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i - 4] & BLACK) != 0) {
-						if ((b[i - 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i <= 17)
-								m = (WHITE | KING);
-							else
-								m = (WHITE | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 4];
-							m = m << 8;
-							m += i - 4;
-							movelist[n].m[2] = m;
-							whitemancapture(b, &n, movelist, i - 8);
-						}
-					}
-
-					if ((b[i - 5] & BLACK) != 0) {
-						if ((b[i - 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							if (i <= 17)
-								m = (WHITE | KING);
-							else
-								m = (WHITE | MAN);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | MAN);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 5];
-							m = m << 8;
-							m += i - 5;
-							movelist[n].m[2] = m;
-							whitemancapture(b, &n, movelist, i - 10);
-						}
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & BLACK) != 0) {
-						if ((b[i + 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 4];
-							m = m << 8;
-							m += i + 4;
-							movelist[n].m[2] = m;
-							tmp = b[i + 4];
-							b[i + 4] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i + 8);
-							b[i + 4] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-
-					if ((b[i + 5] & BLACK) != 0) {
-						if ((b[i + 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i + 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i + 5];
-							m = m << 8;
-							m += i + 5;
-							movelist[n].m[2] = m;
-							tmp = b[i + 5];
-							b[i + 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i + 10);
-							b[i + 5] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-
-					if ((b[i - 4] & BLACK) != 0) {
-						if ((b[i - 8] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 8;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 4];
-							m = m << 8;
-							m += i - 4;
-							movelist[n].m[2] = m;
-							tmp = b[i - 4];
-							b[i - 4] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i - 8);
-							b[i - 4] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-
-					if ((b[i - 5] & BLACK) != 0) {
-						if ((b[i - 10] & FREE) != 0) {
-							movelist[n].n = 3;
-							m = (WHITE | KING);
-							m = m << 8;
-							m += FREE;
-							m = m << 8;
-							m += i - 10;
-							movelist[n].m[1] = m;
-							m = FREE;
-							m = m << 8;
-							m += (WHITE | KING);
-							m = m << 8;
-							m += i;
-							movelist[n].m[0] = m;
-							m = FREE;
-							m = m << 8;
-							m += b[i - 5];
-							m = m << 8;
-							m += i - 5;
-							movelist[n].m[2] = m;
-							tmp = b[i - 5];
-							b[i - 5] = FREE;
-							b[i] = FREE;			/* Remove capturing king. */
-							whitekingcapture(b, &n, movelist, i - 10);
-							b[i - 5] = tmp;
-							b[i] = WHITE | KING;
-						}
-					}
-				}
-			}
-		}
+	dbcacheslots = (int)min((int64_t)megabytes * 1024 * 1024 / DBBLOCKSIZE, (int64_t)dbblocks);
+	if (dbcacheslots == 0)
+		return(1);
+
+	dbcache = (unsigned char *)malloc((size_t)dbcacheslots * DBBLOCKSIZE);
+	dbcacheblock = (int *)malloc(dbcacheslots * sizeof(int));
+	dbcacheused = (unsigned int *)calloc(dbcacheslots, sizeof(unsigned int));
+	if (dbcache == NULL || dbcacheblock == NULL || dbcacheused == NULL) {
+		free(dbcache);
+		free(dbcacheblock);
+		free(dbcacheused);
+		dbcache = NULL;
+		dbcacheblock = NULL;
+		dbcacheused = NULL;
+		dbcacheslots = 0;
+		return(0);
 	}
 
-	return(n);
+	for (i = 0; i < dbcacheslots; i++)
+		dbcacheblock[i] = -1;
+	for (i = 0; i < dbblocks; i++)
+		dbblockslot[i] = -1;
+	for (i = 2; i <= MAXDBPIECES; i++)
+		if (dbfile[i] != NULL)
+			dbpieces = i;
+	return(1);
 }
 
-void blackmancapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+int readdbindex(int pieces)
+/*----------> purpose: read the index file of the database with this number of pieces.
+  ----------> returns 1 on success, 0 if the file could not be read. */
 {
-	int m;
-	int found = 0;
-	move2 move, orgmove;
-
-	orgmove = movelist[*n];
-	move = orgmove;
+	FILE *fp;
+	char filename[MAX_PATH], line[256];
+	char color, *p;
+	int bm, bk, wm, wk, br, wr;
+	int block, offset;
+	int ok;
+	uint32_t start, *blockstart;
+	DBSLICE *slice = NULL;
+
+	sprintf(filename, "%s\\db%d.idx", dbpath, pieces);
+	fp = fopen(filename, "r");
+	if (fp == NULL)
+		return(0);
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "BASE%d,%d,%d,%d,%d,%d,%c", &bm, &bk, &wm, &wk, &br, &wr, &color) == 7) {
+			if (bm < 0 || bk < 0 || wm < 0 || wk < 0 || bm + bk + wm + wk != pieces || bm + bk >= MAXDBPIECES ||
+				wm + wk >= MAXDBPIECES || br < 0 || br > 7 || wr < 0 || wr > 7 || (p = strchr(line, ':')) == NULL)
+				break;
+
+			if (dbslices[bm][bk][wm][wk] == NULL) {
+				dbslices[bm][bk][wm][wk] = (DBSLICE *)calloc(128, sizeof(DBSLICE));
+				if (dbslices[bm][bk][wm][wk] == NULL)
+					break;
+			}
 
-	if ((b[i + 4] & WHITE) != 0) {
-		if ((b[i + 8] & FREE) != 0) {
-			move.n++;
-			if (i >= 28)
-				m = (BLACK | KING);
+			slice = &dbslices[bm][bk][wm][wk][(br * 8 + wr) * 2 + (color == 'w')];
+			slice->file = pieces;
+			if (sscanf(p + 1, "%d/%d", &block, &offset) == 2) {
+				slice->value = DB_UNKNOWN;
+				slice->firstblock = block;
+				slice->offset = offset;
+			}
+			else if (p[1] == '+')
+				slice->value = DB_WIN;
+			else if (p[1] == '-')
+				slice->value = DB_LOSS;
+			else if (p[1] == '=')
+				slice->value = DB_DRAW;
 			else
-				m = (BLACK | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += (i + 8);
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 4];
-			m = m << 8;
-			m += (i + 4);
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			blackmancapture(b, n, movelist, i + 8);
+				break;
 		}
-	}
-
-	move = orgmove;
-	if ((b[i + 5] & WHITE) != 0) {
-		if ((b[i + 10] & FREE) != 0) {
-			move.n++;
-			if (i >= 28)
-				m = (BLACK | KING);
-			else
-				m = (BLACK | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += (i + 10);
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 5];
-			m = m << 8;
-			m += (i + 5);
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			blackmancapture(b, n, movelist, i + 10);
+		else if (sscanf(line, "%u", &start) == 1) {
+			if (slice == NULL)
+				break;
+			blockstart = (uint32_t *)realloc(slice->blockstart, (slice->nblocks + 1) * sizeof(uint32_t));
+			if (blockstart == NULL)
+				break;
+			slice->blockstart = blockstart;
+			slice->blockstart[slice->nblocks++] = start;
 		}
 	}
 
-	if (!found)
-		(*n)++;
+	/* the whole file was read unless a line was wrong. */
+	ok = (feof(fp) != 0);
+	fclose(fp);
+	return(ok);
 }
 
-void blackkingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+int dblookup(pos *p, int color)
+/*----------> purpose: look up the position p with color to move in the endgame database.
+  ----------> returns DB_WIN, DB_LOSS or DB_DRAW from the point of view of black, like the
+  ----------> values of the search, or DB_UNKNOWN if the position is not in the database. */
 {
-	int m;
-	int tmp;
-	int found = 0;
-	move2 move, orgmove;
-
-	orgmove = movelist[*n];
-	move = orgmove;
-
-	if ((b[i - 4] & WHITE) != 0) {
-		if ((b[i - 8] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 4];
-			m = m << 8;
-			m += i - 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 4];
-			b[i - 4] = FREE;
-			blackkingcapture(b, n, movelist, i - 8);
-			b[i - 4] = tmp;
-		}
+	pos q;
+	int nbm, nbk, nwm, nwk;
+	int br, wr;
+	int reverse;
+	int result;
+	uint32_t index;
+	DBSLICE *slice;
+
+	nbm = bitcount(p->bm);
+	nbk = bitcount(p->bk);
+	nwm = bitcount(p->wm);
+	nwk = bitcount(p->wk);
+	if (nbm + nbk == 0 || nwm + nwk == 0 || nbm + nbk + nwm + nwk > dbpieces)
+		return(DB_UNKNOWN);
+
+	/* the database has no values for positions in which either side can capture. */
+	if (testcapture(p, color) || testcapture(p, CB_CHANGECOLOR(color)))
+		return(DB_UNKNOWN);
+
+	/* the rank of the most advanced man of each side. */
+	br = nbm ? 7 - LSB(reversebits(p->bm)) / 4 : 0;
+	wr = nwm ? 7 - LSB(p->wm) / 4 : 0;
+
+	if (nbm + nbk != nwm + nwk)
+		reverse = (nbm + nbk < nwm + nwk);
+	else if (nbm != nwm)
+		reverse = (nbm > nwm);
+	else if (br != wr)
+		reverse = (br < wr);
+	else
+		reverse = (color == WHITE);
+
+	if (reverse) {
+		q.bm = reversebits(p->wm);
+		q.bk = reversebits(p->wk);
+		q.wm = reversebits(p->bm);
+		q.wk = reversebits(p->bk);
+		nbm = bitcount(q.bm);
+		nbk = bitcount(q.bk);
+		nwm = bitcount(q.wm);
+		nwk = bitcount(q.wk);
+		br = nbm ? 7 - LSB(reversebits(q.bm)) / 4 : 0;
+		wr = nwm ? 7 - LSB(q.wm) / 4 : 0;
 	}
+	else
+		q = *p;
+
+	if (dbslices[nbm][nbk][nwm][nwk] == NULL)
+		return(DB_UNKNOWN);
+	/* the values of the database are for the side to move. */
+	slice = &dbslices[nbm][nbk][nwm][nwk][(br * 8 + wr) * 2 + ((color == WHITE) != reverse)];
+	if (slice->file == 0)
+		return(DB_UNKNOWN);
+
+	/* the index of the position is a number with the digits white kings, black kings,
+	   white men and black men. the kings are numbered among the squares the men and
+	   the black kings leave free, the men among the squares of their ranks. */
+	index = dbrank(q.wk, q.bm | q.wm | q.bk);
+	index = index * binomial[32 - nbm - nwm][nbk] + dbrank(q.bk, q.bm | q.wm);
+	if (nwm)
+		index = index * (binomial[4 * wr + 4][nwm] - binomial[4 * wr][nwm]) + dbrank(reversebits(q.wm), 0) - binomial[4 * wr][nwm];
+	if (nbm)
+		index = index * (binomial[4 * br + 4][nbm] - binomial[4 * br][nbm]) + dbrank(q.bm, 0) - binomial[4 * br][nbm];
+
+	if (slice->value != DB_UNKNOWN)
+		result = slice->value;
+	else
+		result = dbdecode(slice, index);
+	if (color == WHITE && result != DB_DRAW)
+		result = (result == DB_WIN) ? DB_LOSS : (result == DB_LOSS) ? DB_WIN : DB_UNKNOWN;
+	return(result);
+}
 
-	move = orgmove;
-	if ((b[i - 5] & WHITE) != 0) {
-		if ((b[i - 10] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 5];
-			m = m << 8;
-			m += i - 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 5];
-			b[i - 5] = FREE;
-			blackkingcapture(b, n, movelist, i - 10);
-			b[i - 5] = tmp;
-		}
-	}
+int dbvalue(SEARCHTHREAD *t, int result, int color)
+/*----------> purpose: the value of the current position of thread t with color to move,
+  ---------->          whose database result is result. the evaluation is added to a
+  ---------->          win, so that the winning side prefers to simplify. */
+{
+	if (result == DB_DRAW)
+		return(0);
 
-	move = orgmove;
-	if ((b[i + 4] & WHITE) != 0) {
-		if ((b[i + 8] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 4];
-			m = m << 8;
-			m += i + 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 4];
-			b[i + 4] = FREE;
-			blackkingcapture(b, n, movelist, i + 8);
-			b[i + 4] = tmp;
+#ifdef STATISTICS
+	t->evaluations++;
+#endif
+	if (result == DB_WIN)
+		return(DBWIN + evaluation(t, color));
+	return(-DBWIN + evaluation(t, color));
+}
+
+template <> int databasevalue<ENGLISHRULES>(SEARCHTHREAD *t, int color, int progress, int *value)
+/*----------> purpose: look up the current position of thread t in the endgame database.
+  ---------->          if progress is set and the root is a database win, positions with
+  ---------->          the same result and number of pieces are not taken, else all moves
+  ---------->          of the winner would look the same and it would never make progress.
+  ----------> returns 1 and the value in *value if the position was found. */
+{
+	int pieces, result;
+
+	pieces = t->count[0] + t->count[1] + t->count[2] + t->count[3];
+	if (pieces > dbpieces)
+		return(0);
+	result = dblookup(&t->p, color);
+	if (result == DB_UNKNOWN)
+		return(0);
+	if (progress && result == t->rootresult && pieces >= t->rootpieces)
+		return(0);
+#ifdef STATISTICS
+	t->dbhits++;
+#endif
+	*value = dbvalue(t, result, color);
+	return(1);
+}
+
+int dbdecode(DBSLICE *slice, uint32_t index)
+/*----------> purpose: find the value of the position index of slice in its block of the
+  ---------->          .cpr file. the block is read into the cache if it is not there.
+  ----------> returns DB_WIN, DB_LOSS or DB_DRAW for the side to move, or DB_UNKNOWN if
+  ----------> the block is not valid. */
+{
+	int i, k;
+	int low, high;
+	int block, slot;
+	int x, length;
+	int result = DB_UNKNOWN;
+	uint32_t start;
+	unsigned char *data;
+
+	/* the last block whose first position is not after index. */
+	low = 0;
+	high = slice->nblocks;
+	while (low < high) {
+		k = (low + high) / 2;
+		if (slice->blockstart[k] <= index)
+			low = k + 1;
+		else
+			high = k;
+	}
+	if (low == 0) {
+		block = dbfirstblock[slice->file] + slice->firstblock;
+		i = slice->offset;
+		start = 0;
+	}
+	else {
+		block = dbfirstblock[slice->file] + slice->firstblock + low;
+		i = 0;
+		start = slice->blockstart[low - 1];
+	}
+	if (block >= dbblocks || i >= DBBLOCKSIZE)
+		return(DB_UNKNOWN);
+
+	EnterCriticalSection(&dbcachelock);
+	slot = dbblockslot[block];
+	if (slot < 0) {
+		/* replace the least recently used block. */
+		slot = 0;
+		for (k = 1; k < dbcacheslots; k++)
+			if (dbcacheused[k] < dbcacheused[slot])
+				slot = k;
+		if (dbcacheblock[slot] >= 0)
+			dbblockslot[dbcacheblock[slot]] = -1;
+
+		data = dbcache + (size_t)slot * DBBLOCKSIZE;
+		memset(data, 0, DBBLOCKSIZE);
+		fseek(dbfile[slice->file], (long)(block - dbfirstblock[slice->file]) * DBBLOCKSIZE, SEEK_SET);
+		fread(data, 1, DBBLOCKSIZE, dbfile[slice->file]);
+		dbcacheblock[slot] = block;
+		dbblockslot[block] = slot;
+	}
+	dbcacheused[slot] = ++dbcacheclock;
+	data = dbcache + (size_t)slot * DBBLOCKSIZE;
+
+	/* skip the bytes before the position. */
+	for (; i < DBBLOCKSIZE; i++) {
+		x = data[i];
+		length = (x <= 80) ? 4 : skiplength[(x - 81) % 58];
+		if (index < start + length) {
+			if (x <= 80) {
+				for (; start < index; start++)
+					x /= 3;
+				x %= 3;
+			}
+			else
+				x = (x - 81) / 58;
+			result = (x == 0) ? DB_WIN : (x == 1) ? DB_LOSS : DB_DRAW;
+			break;
 		}
+		start += length;
 	}
+	LeaveCriticalSection(&dbcachelock);
+	return(result);
+}
 
-	move = orgmove;
-	if ((b[i + 5] & WHITE) != 0) {
-		if ((b[i + 10] & FREE) != 0) {
-			move.n++;
-			m = (BLACK | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 5];
-			m = m << 8;
-			m += i + 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 5];
-			b[i + 5] = FREE;
-			blackkingcapture(b, n, movelist, i + 10);
-			b[i + 5] = tmp;
-		}
+uint32_t dbrank(uint32_t x, uint32_t occupied)
+/*----------> purpose: number of the set of squares x among all sets of as many squares
+  ---------->          that are not occupied, counted in colexicographic order. */
+{
+	int i, square;
+	uint32_t rank = 0;
+
+	for (i = 1; x; x &= x - 1, i++) {
+		square = LSB(x);
+		rank += binomial[square - bitcount(occupied & ((1u << square) - 1))][i];
 	}
+	return(rank);
+}
 
-	if (!found)
-		(*n)++;
+uint32_t reversebits(uint32_t x)
+/*----------> purpose: bit i becomes bit 31 - i, which turns the board around. */
+{
+	x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+	x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+	x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+	x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+	return((x >> 16) | (x << 16));
 }
 
-void whitemancapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+/*-------------- PART VI: OPENING BOOK ---------------------------------------*/
+/*	the opening book is made from the games of a pdn file with the makebook command.
+	the book modes of CheckerBoard choose among the book moves of a position: all kinds
+	of moves plays any of them, good moves one whose score is at most GOODMOVEMARGIN
+	percent below the best score, and best moves the move with the best score. the move
+	is chosen at random, weighted by the number of games in which it was played. the
+	keys of the book are the zobrist keys of inithashkeys(), if they change the book has
+	to be made again. */
+
+void bookpath(char path[MAX_PATH])
+/*----------> purpose: the full path of bookfile, a relative bookfile is in the folder
+  ---------->          of the engine. */
 {
-	int m;
-	int found = 0;
-	move2 move, orgmove;
+	if (PathIsRelative(bookfile))
+		PathCombine(path, enginedirectory, bookfile);
+	else
+		sprintf(path, "%s", bookfile);
+}
 
-	orgmove = movelist[*n];
-	move = orgmove;
+void openbook(void)
+/*----------> purpose: map the book file into memory. booksize is 0 if there is no
+  ---------->          valid book file. */
+{
+	char path[MAX_PATH];
+	LARGE_INTEGER size;
+
+	bookinitialized = 1;
+	size.QuadPart = 0;
+	bookpath(path);
+	bookfilehandle = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (bookfilehandle != INVALID_HANDLE_VALUE && GetFileSizeEx(bookfilehandle, &size) && size.QuadPart >= (LONGLONG)sizeof(BOOKHEADER))
+		bookmapping = CreateFileMapping(bookfilehandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (bookmapping != NULL)
+		bookheader = (BOOKHEADER *)MapViewOfFile(bookmapping, FILE_MAP_READ, 0, 0, 0);
+	if (bookheader != NULL && bookheader->magic == BOOKMAGIC &&
+		size.QuadPart == (LONGLONG)(sizeof(BOOKHEADER) + (uint64_t)bookheader->entries * sizeof(BOOKENTRY))) {
+		book = (BOOKENTRY *)(bookheader + 1);
+		booksize = bookheader->entries;
+	}
+}
 
-	if ((b[i - 4] & BLACK) != 0) {
-		if ((b[i - 8] & FREE) != 0) {
-			move.n++;
-			if (i <= 17)
-				m = (WHITE | KING);
-			else
-				m = (WHITE | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 4];
-			m = m << 8;
-			m += i - 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			whitemancapture(b, n, movelist, i - 8);
-		}
+void closebook(void)
+/*----------> purpose: unmap the book file. the next search maps it again. */
+{
+	if (bookheader != NULL)
+		UnmapViewOfFile(bookheader);
+	if (bookmapping != NULL)
+		CloseHandle(bookmapping);
+	if (bookfilehandle != INVALID_HANDLE_VALUE)
+		CloseHandle(bookfilehandle);
+	bookheader = NULL;
+	bookmapping = NULL;
+	bookfilehandle = INVALID_HANDLE_VALUE;
+	book = NULL;
+	booksize = 0;
+	bookinitialized = 0;
+}
+
+template <> int bookmove<ENGLISHRULES>(int b[46], int color, char *str)
+/*----------> purpose: look up the position b with color to move in the opening book,
+  ---------->          and play one of its book moves on b as the book mode allows.
+  ----------> returns 1 if a book move was played, 0 if not. */
+{
+	int i, k, n;
+	int low, high;
+	int numberofmoves;
+	int best, total;
+	int moveindex[MAXMOVES], percent[MAXMOVES], weight[MAXMOVES];
+	BOOKENTRY *entry[MAXMOVES];
+	BBMOVE movelist[MAXMOVES];
+	uint64_t key;
+	pos p;
+	move2 m;
+	char str2[80];
+
+	if (booksize == 0 || bookmode == CB_BOOK_NONE)
+		return(0);
+
+	/* binary search for the first entry of the position. */
+	boardtopos(b, &p);
+	key = hashposition(&p, color);
+	low = 0;
+	high = booksize;
+	while (low < high) {
+		k = (low + high) / 2;
+		if (book[k].key < key)
+			low = k + 1;
+		else
+			high = k;
 	}
 
-	move = orgmove;
-	if ((b[i - 5] & BLACK) != 0) {
-		if ((b[i - 10] & FREE) != 0) {
-			move.n++;
-			if (i <= 17)
-				m = (WHITE | KING);
-			else
-				m = (WHITE | MAN);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 5];
-			m = m << 8;
-			m += i - 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			whitemancapture(b, n, movelist, i - 10);
+	/* the entries of the key whose moves are legal here. */
+	if (testcapture(&p, color))
+		numberofmoves = generatecapturelist(&p, movelist, color);
+	else
+		numberofmoves = generatemovelist(&p, movelist, color);
+	n = 0;
+	for (i = low; i < booksize && book[i].key == key && n < MAXMOVES; i++) {
+		for (k = 0; k < numberofmoves; k++) {
+			if (movelist[k].from == book[i].from && movelist[k].to == book[i].to) {
+				entry[n] = &book[i];
+				moveindex[n] = k;
+				percent[n] = 50 * entry[n]->score / max(entry[n]->games, 1);
+				n++;
+				break;
+			}
 		}
 	}
+	if (n == 0)
+		return(0);
+
+	best = 0;
+	for (i = 1; i < n; i++)
+		if (percent[i] > percent[best] || (percent[i] == percent[best] && entry[i]->games > entry[best]->games))
+			best = i;
+
+	total = 0;
+	for (i = 0; i < n; i++) {
+		weight[i] = 0;
+		if (i == best || bookmode == CB_BOOK_ALL_KINDS_MOVES ||
+			(bookmode == CB_BOOK_GOOD_MOVES && percent[i] >= percent[best] - GOODMOVEMARGIN))
+			weight[i] = entry[i]->games;
+		total += weight[i];
+	}
 
-	if (!found)
-		(*n)++;
+	bookrandom ^= bookrandom << 13;
+	bookrandom ^= bookrandom >> 7;
+	bookrandom ^= bookrandom << 17;
+	k = (int)(bookrandom % max(total, 1));
+	for (i = 0; i < n - 1 && k >= weight[i]; i++)
+		k -= weight[i];
+
+	tomove2(movelist[moveindex[i]], color, &m);
+	movetonotation(m, str2);
+	sprintf(str, "book move:%s, %i games, score %i%%", str2, entry[i]->games, percent[i]);
+	domove(b, m);
+	return(1);
 }
 
-void whitekingcapture(int b[46], int *n, move2 movelist[MAXMOVES], int i)
+int makebook(char *pdnfile, char *reply)
+/*----------> purpose: make the book file from the games of pdnfile that start from
+  ---------->          the initial position and have a result.
+  ----------> returns 1 on success, 0 if a file could not be read or written or there
+  ----------> is not enough memory. reply says how many book moves were found. */
 {
-	int m;
-	int tmp;
-	int found = 0;
-	move2 move, orgmove;
-
-	orgmove = movelist[*n];
-	move = orgmove;
-
-	if ((b[i - 4] & BLACK) != 0) {
-		if ((b[i - 8] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 4];
-			m = m << 8;
-			m += i - 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 4];
-			b[i - 4] = FREE;
-			whitekingcapture(b, n, movelist, i - 8);
-			b[i - 4] = tmp;
-		}
+	FILE *fp;
+	char path[MAX_PATH];
+	char *text, *game, *movetext, *next, *end;
+	long size;
+	int i, n, games;
+	int allocated, blackscore, setup;
+	BOOKENTRY *entries;
+	BOOKHEADER header;
+
+	fp = fopen(pdnfile, "rb");
+	if (fp == NULL) {
+		sprintf(reply, "could not open %s", pdnfile);
+		return(0);
 	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	text = (char *)malloc(size + 1);
+	if (text == NULL) {
+		fclose(fp);
+		sprintf(reply, "not enough memory");
+		return(0);
+	}
+	size = (long)fread(text, 1, size, fp);
+	text[size] = 0;
+	fclose(fp);
 
-	move = orgmove;
-	if ((b[i - 5] & BLACK) != 0) {
-		if ((b[i - 10] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i - 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i - 5];
-			m = m << 8;
-			m += i - 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i - 5];
-			b[i - 5] = FREE;
-			whitekingcapture(b, n, movelist, i - 10);
-			b[i - 5] = tmp;
+	/* a game is a number of tag lines and the movetext up to the next tag line. */
+	entries = NULL;
+	n = 0;
+	allocated = 0;
+	games = 0;
+	for (game = text; game != NULL && *game; game = next) {
+		blackscore = -1;
+		setup = 0;
+		movetext = game;
+		while (*movetext == '[' || *movetext == ' ' || *movetext == '\t' || *movetext == '\r' || *movetext == '\n') {
+			if (*movetext == '[') {
+				if (strncmp(movetext, "[Result \"1-0\"", 13) == 0)
+					blackscore = 2;
+				else if (strncmp(movetext, "[Result \"0-1\"", 13) == 0)
+					blackscore = 0;
+				else if (strncmp(movetext, "[Result \"1/2-1/2\"", 17) == 0)
+					blackscore = 1;
+				else if (strncmp(movetext, "[FEN ", 5) == 0)
+					setup = 1;
+				end = strchr(movetext, '\n');
+				movetext = (end != NULL) ? end : movetext + strlen(movetext);
+			}
+			else
+				movetext++;
 		}
-	}
 
-	move = orgmove;
-	if ((b[i + 4] & BLACK) != 0) {
-		if ((b[i + 8] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 8;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 4];
-			m = m << 8;
-			m += i + 4;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 4];
-			b[i + 4] = FREE;
-			whitekingcapture(b, n, movelist, i + 8);
-			b[i + 4] = tmp;
+		next = strstr(movetext, "\n[");
+		if (next != NULL)
+			*next++ = 0;
+		if (blackscore < 0 || setup)
+			continue;
+
+		if (!addbookgame(movetext, blackscore, &entries, &n, &allocated)) {
+			free(text);
+			free(entries);
+			sprintf(reply, "not enough memory");
+			return(0);
 		}
+		games++;
 	}
-
-	move = orgmove;
-	if ((b[i + 5] & BLACK) != 0) {
-		if ((b[i + 10] & FREE) != 0) {
-			move.n++;
-			m = (WHITE | KING);
-			m = m << 8;
-			m += FREE;
-			m = m << 8;
-			m += i + 10;
-			move.m[1] = m;
-			m = FREE;
-			m = m << 8;
-			m += b[i + 5];
-			m = m << 8;
-			m += i + 5;
-			move.m[move.n - 1] = m;
-			found = 1;
-			movelist[*n] = move;
-			tmp = b[i + 5];
-			b[i + 5] = FREE;
-			whitekingcapture(b, n, movelist, i + 10);
-			b[i + 5] = tmp;
+	free(text);
+
+	/* sort the entries and merge the entries of the same move. */
+	qsort(entries, n, sizeof(BOOKENTRY), compareentries);
+	for (i = 0, size = 0; i < n; i++) {
+		if (size > 0 && compareentries(&entries[size - 1], &entries[i]) == 0) {
+			/* games is 16 bits, the games after 0xffff count for neither games nor
+			   score, so that the score stays at most 2 per game. */
+			if (entries[size - 1].games < 0xffff) {
+				entries[size - 1].games++;
+				entries[size - 1].score += entries[i].score;
+			}
 		}
+		else
+			entries[size++] = entries[i];
 	}
 
-	if (!found)
-		(*n)++;
+	closebook();
+	bookpath(path);
+	fp = fopen(path, "wb");
+	if (fp == NULL) {
+		free(entries);
+		sprintf(reply, "could not write %s", path);
+		return(0);
+	}
+	header.magic = BOOKMAGIC;
+	header.entries = size;
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(entries, sizeof(BOOKENTRY), size, fp);
+	fclose(fp);
+	free(entries);
+
+	openbook();
+	sprintf(reply, "%li book moves from %i games", size, games);
+	return(1);
 }
 
-int testcapture(int b[46], int color)
-/*----------> purpose: test if color has a capture on b
-  ----------> version: 1.0
-  ----------> date: 25th october 97 */
+int addbookgame(char *movetext, int blackscore, BOOKENTRY **entries, int *n, int *allocated)
+/*----------> purpose: add a book entry for each of the first MAXBOOKPLY moves of a game
+  ---------->          to the array entries of *n entries, which is enlarged as needed.
+  ---------->          the moves are read until one is not legal or not a move.
+  ----------> returns 1 on success, 0 if there is not enough memory. */
 {
-	int i;
-
-#ifdef STATISTICS
-	testcaptures++;
-#endif
-	if (color == BLACK) {
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & BLACK) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i + 4] & WHITE) != 0) {
-						if ((b[i + 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i + 5] & WHITE) != 0) {
-						if ((b[i + 10] & FREE) != 0)
-							return(1);
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & WHITE) != 0) {
-						if ((b[i + 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i + 5] & WHITE) != 0) {
-						if ((b[i + 10] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 4] & WHITE) != 0) {
-						if ((b[i - 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 5] & WHITE) != 0) {
-						if ((b[i - 10] & FREE) != 0)
-							return(1);
-					}
+	int i, numberofmoves;
+	int ply, from, to, f, t, depth;
+	char *token, *dot, *last;
+	char str[80];
+	BBMOVE movelist[MAXMOVES];
+	BOOKENTRY *newentries;
+	move2 m;
+	pos p;
+	int color = BLACK;
+
+	/* the initial position. */
+	p.bm = 0x00000fff;
+	p.bk = 0;
+	p.wm = 0xfff00000;
+	p.wk = 0;
+
+	for (ply = 0; ply < MAXBOOKPLY; ) {
+		/* skip white space, comments and variations. */
+		while (*movetext == ' ' || *movetext == '\t' || *movetext == '\r' || *movetext == '\n' || *movetext == '{' || *movetext == '(') {
+			if (*movetext == '{') {
+				while (*movetext && *movetext != '}')
+					movetext++;
+			}
+			else if (*movetext == '(') {
+				for (depth = 0; *movetext; movetext++) {
+					if (*movetext == '(')
+						depth++;
+					if (*movetext == ')' && --depth == 0)
+						break;
 				}
 			}
+			if (*movetext)
+				movetext++;
 		}
-	}
-	else {
+		if (*movetext == 0)
+			break;
 
-		/* color is WHITE */
-		for (i = 5; i <= 40; i++) {
-			if ((b[i] & WHITE) != 0) {
-				if ((b[i] & MAN) != 0) {
-					if ((b[i - 4] & BLACK) != 0) {
-						if ((b[i - 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 5] & BLACK) != 0) {
-						if ((b[i - 10] & FREE) != 0)
-							return(1);
-					}
-				}
-				else {
-
-					/* b[i] is a KING */
-					if ((b[i + 4] & BLACK) != 0) {
-						if ((b[i + 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i + 5] & BLACK) != 0) {
-						if ((b[i + 10] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 4] & BLACK) != 0) {
-						if ((b[i - 8] & FREE) != 0)
-							return(1);
-					}
-
-					if ((b[i - 5] & BLACK) != 0) {
-						if ((b[i - 10] & FREE) != 0)
-							return(1);
-					}
-				}
-			}
+		/* the next token, a move number ends with a dot. */
+		token = movetext;
+		while (*movetext && *movetext != ' ' && *movetext != '\t' && *movetext != '\r' && *movetext != '\n')
+			movetext++;
+		if (*movetext)
+			*movetext++ = 0;
+		dot = strrchr(token, '.');
+		if (dot != NULL)
+			token = dot + 1;
+		if (*token == 0)
+			continue;
+
+		/* a move is from-to or fromxto, or fromxoverxto for a multiple capture. */
+		last = strrchr(token, (strrchr(token, 'x') != NULL) ? 'x' : '-');
+		if (last == NULL || sscanf(token, "%i", &from) != 1 || sscanf(last + 1, "%i", &to) != 1)
+			break;
+
+		if (testcapture(&p, color))
+			numberofmoves = generatecapturelist(&p, movelist, color);
+		else
+			numberofmoves = generatemovelist(&p, movelist, color);
+		for (i = 0; i < numberofmoves; i++) {
+			tomove2(movelist[i], color, &m);
+			movetonotation(m, str);
+			if (sscanf(str, "%i%*c%i", &f, &t) == 2 && f == from && t == to)
+				break;
+		}
+		if (i == numberofmoves)
+			break;
+
+		if (*n == *allocated) {
+			newentries = (BOOKENTRY *)realloc(*entries, (*allocated + 4096) * sizeof(BOOKENTRY));
+			if (newentries == NULL)
+				return(0);
+			*entries = newentries;
+			*allocated += 4096;
 		}
+		(*entries)[*n].key = hashposition(&p, color);
+		(*entries)[*n].from = movelist[i].from;
+		(*entries)[*n].to = movelist[i].to;
+		(*entries)[*n].games = 1;
+		(*entries)[*n].score = (color == BLACK) ? blackscore : 2 - blackscore;
+		(*n)++;
+
+		p.bm ^= movelist[i].delta.bm;
+		p.bk ^= movelist[i].delta.bk;
+		p.wm ^= movelist[i].delta.wm;
+		p.wk ^= movelist[i].delta.wk;
+		color = CB_CHANGECOLOR(color);
+		ply++;
 	}
+	return(1);
+}
 
-	return(0);
+int compareentries(const void *a, const void *b)
+/*----------> purpose: order of the book entries for qsort(), by key and move. */
+{
+	const BOOKENTRY *x = (const BOOKENTRY *)a;
+	const BOOKENTRY *y = (const BOOKENTRY *)b;
+
+	if (x->key != y->key)
+		return((x->key < y->key) ? -1 : 1);
+	if (x->from != y->from)
+		return(x->from - y->from);
+	return(x->to - y->to);
 }
@@ -478,6 +478,11 @@ void setmenuchecks(CBoptions *CBoptions, HMENU hmenu)
 	else
 		CheckMenuItem(hmenu, LEVELEXACT, MF_UNCHECKED);
 
+	if (CBoptions->ponder)
+		CheckMenuItem(hmenu, ENGINEPONDER, MF_CHECKED);
+	else
+		CheckMenuItem(hmenu, ENGINEPONDER, MF_UNCHECKED);
+
 	if (CBoptions->numbers)
 		CheckMenuItem(hmenu, DISPLAYNUMBERS, MF_CHECKED);
 	else